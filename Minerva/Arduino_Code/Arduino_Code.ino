@@ -10,9 +10,14 @@
 #include "SwitchingValveDCMotor.h"
 #include "CapperDecapper.h"
 #include "HotplateClampDCMotor.h"
+#include "HotplateClampStepperMotor.h"
 #include "HotplateFan.h"
 #include "DHT22Sensor.h"
 #include "Electromagnet.h"
+#include "RuntimeStatistics.h"
+#include "EventTrace.h"
+#include "SelfBenchmark.h"
+#include "Telemetry.h"
 #include "HelperFunctions.h"
 #include "SoftReset.h"
 
@@ -21,6 +26,9 @@
  **********************************/
 byte errors = 0;  // 0: ok; 1: Hall sensor error; 2: Magnet polarity error; 3: Timeout error
 bool emergencyStopRequest = false;
+const unsigned long serialBaudRate = 9600;
+RuntimeStatistics runtimeStatistics;  // timing and memory statistics of the controller, see "stats"
+Telemetry telemetry;  // periodic push of sensor values, see "subscribe"
 
 /**********************************
  * Setup for Valves               *
@@ -82,6 +90,21 @@ const int servoHotplateClamp3ClosedPos = 164;
 const int servoHotplateClamp3OpenedPos = 85;
 HotplateClampDCMotor hotplateClamp3;
 
+const byte dirPinHotplateClamp4 = 47;
+const byte stepPinHotplateClamp4 = 48;
+const byte sleepPinHotplateClamp4 = 40;
+const byte servoPinHotplateClamp4 = 9;
+const byte switchPinHotplateClamp4 = 41;
+const int servoHotplateClamp4ClosedPos = 164;
+const int servoHotplateClamp4OpenedPos = 85;
+const byte microsteppingFactorHotplateClamp4 = 4;
+const int stepsPerRevolutionHotplateClamp4 = 200;
+const float mmPerRevolutionHotplateClamp4 = 4.0;  // lead screw pitch
+const float maxSpeedHotplateClamp4 = 12.0;  // in mm/s
+const float accelerationHotplateClamp4 = 60.0;  // in mm/s^2
+const int maxPosHotplateClamp4 = 100;  // travel of the stage in mm above the home position
+HotplateClampStepperMotor hotplateClamp4;
+
 /**********************************
  * Setup for Hotplate Fans        *
  **********************************/
@@ -189,22 +212,137 @@ void handleMagnetCommand(String command) {
     return;
   }
 
-  if (command.substring(1) == "on") {
-    magnet->magnetOn(false);
-    Serial.println("MAGNET" + String(magnetNumber) + ">OK");
-  } else if (command.substring(1) == "off") {
-    magnet->magnetOff();
-    Serial.println("MAGNET" + String(magnetNumber) + ">OK");
-  } else if (command.substring(1) == "rev") {
-    magnet->magnetOn(true);
+  command = command.substring(1);
+  if (command == "status") {
+    Serial.print("MAGNET" + String(magnetNumber) + ">" + String(magnet->waveform) + ";" + String(magnet->getRemainingTime()) + "\n");
     Serial.println("MAGNET" + String(magnetNumber) + ">OK");
-  } else if (command.substring(1) == "rel") {
-    magnet->magnetOn(true);
-    delay(100);
+    return;
+  } else if (command == "off") {
     magnet->magnetOff();
     Serial.println("MAGNET" + String(magnetNumber) + ">OK");
+    return;
+  }
+
+  // Optional parameters: on/rev [duty;duration], rel [duty;frequency], stir <frequency>[;duty;duration]
+  byte waveform = MAGNET_WAVEFORM_OFF;
+  byte duty = 255;
+  float frequency = 5.0;  // a release pulse of 100 ms like the previous blocking release
+  unsigned long duration = 0;
+  bool reversedPolarity = false;
+  if (command.startsWith("on")) {
+    waveform = MAGNET_WAVEFORM_CONSTANT;
+    command = command.substring(2);
+  } else if (command.startsWith("rev")) {
+    waveform = MAGNET_WAVEFORM_CONSTANT;
+    reversedPolarity = true;
+    command = command.substring(3);
+  } else if (command.startsWith("rel")) {
+    waveform = MAGNET_WAVEFORM_RELEASE;
+    command = command.substring(3);
+  } else if (command.startsWith("stir")) {
+    waveform = MAGNET_WAVEFORM_ALTERNATE;
+    command = command.substring(4);
   } else {
     Serial.println("MAGNET" + String(magnetNumber) + ">UNK: " + command);
+    return;
+  }
+
+  char buf[command.length()+1];
+  command.toCharArray(buf, command.length()+1);
+  char* part = strtok(buf, ";");
+  int i = 0;
+  while (part != 0) {
+      if (waveform == MAGNET_WAVEFORM_ALTERNATE) {
+        if (i==0) {
+          frequency = atof(part);
+        } else if (i==1) {
+          duty = constrain(atoi(part), 1, 255);
+        } else if (i==2) {
+          duration = atol(part);
+        }
+      } else {
+        if (i==0) {
+          duty = constrain(atoi(part), 1, 255);
+        } else if (i==1 && waveform == MAGNET_WAVEFORM_RELEASE) {
+          frequency = atof(part);
+        } else if (i==1) {
+          duration = atol(part);
+        }
+      }
+      i++;
+      part = strtok(0, ";");
+  }
+  if (waveform == MAGNET_WAVEFORM_ALTERNATE && frequency <= 0) {
+    Serial.println("MAGNET" + String(magnetNumber) + ">ERROR: INVALID FREQUENCY");
+    return;
+  }
+  magnet->play(waveform, duty, frequency, duration, reversedPolarity);
+  Serial.println("MAGNET" + String(magnetNumber) + ">OK");
+}
+
+void handleHotplateClampStepperCommand(byte clampNumber, HotplateClampStepperMotor *clamp, String command) {
+  if (!clamp->isHomed && (command.startsWith("lower_and_close") || command.startsWith("open_and_raise") || command.startsWith("goto"))) {
+    // Absolute moves need a reference: home the stage (or set its position with "pos <int>") after every reset
+    Serial.println("CLAMP" + String(clampNumber) + ">ERROR: NOT HOMED");
+  } else if (command.startsWith("lower_and_close")) {
+    if (clamp->lowerAndClose(command.length() > 15 ? command.substring(15).toInt() : -1)) {
+      Serial.println("CLAMP" + String(clampNumber) + ">OK");
+    } else {
+      Serial.println("CLAMP" + String(clampNumber) + ">ERROR " + String(clamp->errors) + ": " + getErrorMessage(clamp->errors));
+    }
+  } else if (command.startsWith("open_and_raise")) {
+    if (clamp->openAndRaise(command.length() > 14 ? command.substring(14).toInt() : -1)) {
+      Serial.println("CLAMP" + String(clampNumber) + ">OK");
+    } else {
+      Serial.println("CLAMP" + String(clampNumber) + ">ERROR " + String(clamp->errors) + ": " + getErrorMessage(clamp->errors));
+    }
+  } else if (command == "close") {
+    clamp->closeClamp();
+    Serial.println("CLAMP" + String(clampNumber) + ">OK");
+  } else if (command == "open") {
+    clamp->openClamp();
+    Serial.println("CLAMP" + String(clampNumber) + ">OK");
+  } else if (command.startsWith("close")) {
+    clamp->closeClamp(command.substring(5).toInt());
+    Serial.println("CLAMP" + String(clampNumber) + ">OK");
+  } else if (command.startsWith("open")) {
+    clamp->openClamp(command.substring(4).toInt());
+    Serial.println("CLAMP" + String(clampNumber) + ">OK");
+  } else if (command == "home" || command == "homeposition") {
+    if (clamp->homePosition()) {
+      Serial.println("CLAMP" + String(clampNumber) + ">OK");
+    } else {
+      Serial.println("CLAMP" + String(clampNumber) + ">ERROR " + String(clamp->errors) + ": " + getErrorMessage(clamp->errors));
+    }
+  } else if (command.startsWith("gotoposition") || command.startsWith("goto")) {
+    String target = command.substring(command.startsWith("gotoposition") ? 12 : 4);
+    int targetPos = target.toInt();
+    if (!isNumber(target) || targetPos > clamp->maxPos) {
+      // toInt() turns "abc" into 0, which would silently send the stage home; negative targets are beyond the limit switch
+      Serial.println("CLAMP" + String(clampNumber) + ">ERROR: INVALID POSITION");
+    } else if (targetPos == clamp->currentPos) {
+      Serial.println("CLAMP" + String(clampNumber) + ">OK");
+    } else if (clamp->gotoPosition(targetPos)) {
+      Serial.println("CLAMP" + String(clampNumber) + ">OK");
+    } else {
+      Serial.println("CLAMP" + String(clampNumber) + ">ERROR " + String(clamp->errors) + ": " + getErrorMessage(clamp->errors));
+    }
+  } else if (command.startsWith("pos")) {
+    if (command.length() == 3) {
+      Serial.println("CLAMP" + String(clampNumber) + ">POS " + String(clamp->currentPos));
+    } else {
+      clamp->setCurrentPosition(command.substring(3).toInt());
+      Serial.println("CLAMP" + String(clampNumber) + ">OK");
+    }
+  } else if (command == "status") {
+    Serial.print("CLAMP" + String(clampNumber) + ">" + String(clamp->isHomed ? "HOMED" : "NOT HOMED") + "\n");
+    Serial.print("CLAMP" + String(clampNumber) + ">POS " + String(clamp->currentPos) + "\n");
+    Serial.println("CLAMP" + String(clampNumber) + ">OK");
+  } else if (command == "stop") {
+    clamp->stopStage();
+    Serial.println("CLAMP" + String(clampNumber) + ">OK");
+  } else {
+    Serial.println("CLAMP" + String(clampNumber) + ">UNK: " + command);
   }
 }
 
@@ -218,13 +356,28 @@ void handleHotplateClampCommand(String command) {
     clamp = &hotplateClamp2;
   } else if (clampNumber == 3) {
     clamp = &hotplateClamp3;
+  } else if (clampNumber == 4) {
+    handleHotplateClampStepperCommand(clampNumber, &hotplateClamp4, command.substring(1));
+    return;
   } else {
     Serial.println("CLAMP" + String(clampNumber) + ">UNKNOWN HOTPLATE CLAMP NUMBER: " + String(clampNumber));
     return;
   }
   command = command.substring(1);
 
-  if (command == "close") {
+  if (command.startsWith("lower_and_close")) {
+    if (clamp->lowerAndClose(command.length() > 15 ? command.substring(15).toInt() : -1)) {
+      Serial.println("CLAMP" + String(clampNumber) + ">OK");
+    } else {
+      Serial.println("CLAMP" + String(clampNumber) + ">ERROR " + String(clamp->errors) + ": " + getErrorMessage(clamp->errors));
+    }
+  } else if (command.startsWith("open_and_raise")) {
+    if (clamp->openAndRaise(command.length() > 14 ? command.substring(14).toInt() : -1)) {
+      Serial.println("CLAMP" + String(clampNumber) + ">OK");
+    } else {
+      Serial.println("CLAMP" + String(clampNumber) + ">ERROR " + String(clamp->errors) + ": " + getErrorMessage(clamp->errors));
+    }
+  } else if (command == "close") {
     clamp->closeClamp();
     Serial.println("CLAMP" + String(clampNumber) + ">OK");
   } else if (command == "open") {
@@ -292,12 +445,43 @@ void handleHotplateFanCommand(String command) {
   }
   command = command.substring(1);
 
-  if (command == "on") {
-    fan->turnOn();
+  if (command.startsWith("on")) {
+    command = command.substring(2);
+    fan->turnOn((command.length() > 0) ? constrain(command.toInt(), 1, 255) : 255);
     Serial.println("FAN" + String(fanNumber) + ">OK");
   } else if (command == "off") {
     fan->turnOff();
     Serial.println("FAN" + String(fanNumber) + ">OK");
+  } else if (command.startsWith("cool")) {
+    // Parameters: duty;duration[;target temperature]
+    command = command.substring(4);
+    byte duty = 255;
+    unsigned long duration = 0;
+    float targetTemperature = NAN;
+    char buf[command.length()+1];
+    command.toCharArray(buf, command.length()+1);
+    char* part = strtok(buf, ";");
+    int i = 0;
+    while (part != 0) {
+        if (i==0) {
+          duty = constrain(atoi(part), 1, 255);
+        } else if (i==1) {
+          duration = atol(part);
+        } else if (i==2) {
+          targetTemperature = atof(part);
+        }
+        i++;
+        part = strtok(0, ";");
+    }
+    if (duration == 0 && isnan(targetTemperature)) {
+      Serial.println("FAN" + String(fanNumber) + ">ERROR: NO DURATION OR TARGET TEMPERATURE");
+      return;
+    }
+    fan->coolDown(duty, duration, targetTemperature);
+    Serial.println("FAN" + String(fanNumber) + ">OK");
+  } else if (command == "status") {
+    Serial.print("FAN" + String(fanNumber) + ">" + String(fan->state) + ";" + String(fan->duty) + ";" + String(fan->getRemainingTime()) + "\n");
+    Serial.println("FAN" + String(fanNumber) + ">OK");
   } else {
     Serial.println("FAN" + String(fanNumber) + ">UNK: " + command);
   }
@@ -319,7 +503,7 @@ void handleDHTCommand(String command) {
   if (command == "measure") {
     res = sensor->measure();
     if (res != NULL) {
-      Serial.println("DHT22SENSOR" + String(sensorNumber) + ">" + String(* res) + "\n" + String(* res + sizeof(float)) + "\nOK");
+      Serial.println("DHT22SENSOR" + String(sensorNumber) + ">" + String(res[0]) + "\n" + String(res[1]) + "\n" + String(sensor->getAge()) + "\n" + String(res[2]) + ";" + String(res[3]) + ";" + String(res[4]) + "\n" + String(res[5]) + ";" + String(res[6]) + ";" + String(res[7]) + "\nOK");
     } else {
       Serial.println("DHT22SENSOR" + String(sensorNumber) + ">ERROR " + String(sensor->errors) + ": " + getErrorMessage(sensor->errors));
     }
@@ -357,22 +541,75 @@ void handleCapperDecapperCommand(String command) {
       capper.logSensorSignals(command.substring(3).toInt(), true);
     }
     Serial.println("CAPPER>OK");
+  } else if (command == "recorder") {
+    capper.recorder.dump("CAPPER");
+    Serial.println(F("CAPPER>OK"));
+  } else if (command == "recorder_clear") {
+    capper.recorder.clear();
+    Serial.println(F("CAPPER>OK"));
+  } else if (command == "stream_stop") {
+    capper.stopStream();
+    Serial.println(F("CAPPER>OK"));
+  } else if (command.startsWith("stream")) {
+    command = command.substring(6);
+    char buf[command.length()+1];
+    command.toCharArray(buf, command.length()+1);
+    char* part = strtok(buf, ";");
+    int i = 0;
+    byte channels = STREAM_PRESSURE | STREAM_DC_CURRENT | STREAM_SERVO_CURRENT;
+    unsigned long period = 5000;
+    byte decimation = 4;  // 50 records per second, fits the serial port with all channels
+    unsigned long duration = 5000;
+    while (part != 0) {
+        if (i==0) {
+          channels = atoi(part);
+        } else if (i==1) {
+          period = atol(part);
+        } else if (i==2) {
+          decimation = atoi(part);
+        } else if (i==3) {
+          duration = atol(part);
+        }
+        i++;
+        part = strtok(0, ";");
+    }
+    if (!capper.startStream(channels, period, decimation, duration, serialBaudRate / 10)) {
+      Serial.println(F("CAPPER>ERROR: INVALID STREAM PARAMETERS (OR MORE RECORDS PER SECOND THAN THE SERIAL PORT CAN SEND)"));
+    }
+  } else if (command.startsWith("open_profile")) {
+    command = command.substring(12);
+    if (!isNumber(command) || command.toInt() >= CONTAINER_PROFILE_COUNT) {
+      Serial.println(F("CAPPER>ERROR: INVALID PROFILE ID"));
+    } else if (capper.openContainerWithProfile(command.toInt())) {
+      Serial.println(F("CAPPER>OK"));
+    } else {
+      Serial.println(F("CAPPER>ERROR OPENING CONTAINER"));
+    }
+  } else if (command.startsWith("close_profile")) {
+    command = command.substring(13);
+    if (!isNumber(command) || command.toInt() >= CONTAINER_PROFILE_COUNT) {
+      Serial.println(F("CAPPER>ERROR: INVALID PROFILE ID"));
+    } else if (capper.closeContainerWithProfile(command.toInt())) {
+      Serial.println(F("CAPPER>OK"));
+    } else {
+      Serial.println(F("CAPPER>ERROR CLOSING CONTAINER"));
+    }
   } else if (command.startsWith("open")) {
     command = command.substring(4);
     char buf[command.length()+1];
-    command.toCharArray(buf, command.length());
+    command.toCharArray(buf, command.length()+1);
     char* part = strtok(buf, ";");
     int i = 0;
-    int pos = 0;
-    int p = 0;
-    long timeout = 0;
+    int pos = 31;
+    int p = 100;
+    long timeout = 10000;
     while (part != 0) {
         if (i==0) {
-          pos = atoi(buf);
+          pos = atoi(part);
         } else if (i==1) {
-          p = atoi(buf);
+          p = atoi(part);
         } else if (i==2) {
-          timeout = atol(buf);
+          timeout = atol(part);
         }
         i++;
         part = strtok(0, ";");
@@ -382,22 +619,22 @@ void handleCapperDecapperCommand(String command) {
     } else {
       Serial.println(F("CAPPER>ERROR OPENING CONTAINER"));
     }
-  } else if (command=="close") {
+  } else if (command.startsWith("close")) {
     command = command.substring(5);
     char buf[command.length()+1];
-    command.toCharArray(buf, command.length());
+    command.toCharArray(buf, command.length()+1);
     char* part = strtok(buf, ";");
     int i = 0;
-    int p = 0;
-    float current = 0.0;
-    long timeout = 0;
+    int p = 1000;
+    float current = -1;
+    long timeout = 10000;
     while (part != 0) {
         if (i==0) {
-          p = atoi(buf);
+          p = atoi(part);
         } else if (i==1) {
-          current = atof(buf);
+          current = atof(part);
         } else if (i==2) {
-          timeout = atol(buf);
+          timeout = atol(part);
         }
         i++;
         part = strtok(0, ";");
@@ -407,6 +644,184 @@ void handleCapperDecapperCommand(String command) {
     } else {
       Serial.println(F("CAPPER>ERROR CLOSING CONTAINER"));
     }
+  } else if (command.startsWith("tighten")) {
+    bool release = command.startsWith("tighten_release");  // open the clamp right after the wrist was stopped
+    command = command.substring(release ? 15 : 7);
+    float current = -1;
+    int timeout = 10000;
+    byte reason;
+    if (command.length() > 0) {
+      current = command.toFloat();
+      if (command.indexOf(';') >= 0) {
+        timeout = command.substring(command.indexOf(';') + 1).toInt();
+      }
+    }
+    reason = capper.tightenUntilSeated(current, timeout);
+    if (release) {
+      capper.openClamp();
+    }
+    if (reason == TORQUE_SEATED_SLOPE) {
+      Serial.print(F("CAPPER>SEATED SLOPE "));
+      Serial.print(String(capper.seatedCurrent) + "\n");
+      Serial.println(F("CAPPER>OK"));
+    } else if (reason == TORQUE_SEATED_PLATEAU) {
+      Serial.print(F("CAPPER>SEATED PLATEAU "));
+      Serial.print(String(capper.seatedCurrent) + "\n");
+      Serial.println(F("CAPPER>OK"));
+    } else if (reason == TORQUE_SEATED_LEVEL) {
+      Serial.print(F("CAPPER>SEATED LEVEL "));
+      Serial.print(String(capper.seatedCurrent) + "\n");
+      Serial.println(F("CAPPER>OK"));
+    } else {
+      Serial.print(F("CAPPER>ERROR 3: "));
+      Serial.println(getErrorMessage(3));
+    }
+  } else if (command.startsWith("profile_clear")) {
+    if (capper.clearContainerProfile(command.substring(13).toInt())) {
+      Serial.println(F("CAPPER>OK"));
+    } else {
+      Serial.println(F("CAPPER>ERROR: INVALID PROFILE ID"));
+    }
+  } else if (command.startsWith("profile")) {
+    command = command.substring(7);
+    byte id = command.toInt();
+    ContainerProfile profile = capper.getContainerProfile(id);
+    if (id >= CONTAINER_PROFILE_COUNT) {
+      Serial.println(F("CAPPER>ERROR: INVALID PROFILE ID"));
+      return;
+    }
+    if (command.indexOf(';') >= 0) {
+      char buf[command.length()+1];
+      command.toCharArray(buf, command.length()+1);
+      char* part = strtok(buf, ";");
+      int i = 0;
+      while (part != 0) {
+          if (i==1) {
+            profile.clampPos = atoi(part);
+          } else if (i==2) {
+            profile.gripCurrent = atof(part);
+          } else if (i==3) {
+            profile.openPressure = atoi(part);
+          } else if (i==4) {
+            profile.closePressure = atoi(part);
+          } else if (i==5) {
+            profile.seatLevel = atof(part);
+          } else if (i==6) {
+            profile.fastStepTime = atoi(part);
+          } else if (i==7) {
+            profile.fineStepTime = atoi(part);
+          } else if (i==8) {
+            profile.openTimeout = atoi(part);
+          } else if (i==9) {
+            profile.closeTimeout = atoi(part);
+          } else if (i==10) {
+            profile.torqueTime = atoi(part);
+          }
+          i++;
+          part = strtok(0, ";");
+      }
+      capper.setContainerProfile(id, profile);
+      profile = capper.getContainerProfile(id);
+    }
+    Serial.print(F("CAPPER>"));
+    Serial.print(String(profile.version == CONTAINER_PROFILE_VERSION ? "STORED" : "DEFAULT") + "\n");
+    Serial.print(F("CAPPER>"));
+    Serial.print(String(profile.clampPos) + ";" + String(profile.gripCurrent) + ";" + String(profile.openPressure) + ";" + String(profile.closePressure) + ";" + String(profile.seatLevel) + ";" + String(profile.fastStepTime) + ";" + String(profile.fineStepTime) + ";" + String(profile.openTimeout) + ";" + String(profile.closeTimeout) + ";" + String(profile.torqueTime) + "\n");
+    Serial.println(F("CAPPER>OK"));
+  } else if (command.startsWith("torque_profile")) {
+    command = command.substring(14);
+    if (command.length() > 0) {
+      char buf[command.length()+1];
+      command.toCharArray(buf, command.length()+1);
+      char* part = strtok(buf, ";");
+      int i = 0;
+      while (part != 0) {
+          if (i==0) {
+            capper.torqueProfile.inrushTime = atoi(part);
+          } else if (i==1) {
+            capper.torqueProfile.levelThreshold = atof(part);
+          } else if (i==2) {
+            capper.torqueProfile.riseThreshold = atof(part);
+          } else if (i==3) {
+            capper.torqueProfile.slopeThreshold = atof(part);
+          } else if (i==4) {
+            capper.torqueProfile.plateauTime = atoi(part);
+          }
+          i++;
+          part = strtok(0, ";");
+      }
+    }
+    Serial.print(F("CAPPER>"));
+    Serial.print(String(capper.torqueProfile.inrushTime) + ";" + String(capper.torqueProfile.levelThreshold) + ";" + String(capper.torqueProfile.riseThreshold) + ";" + String(capper.torqueProfile.slopeThreshold) + ";" + String(capper.torqueProfile.plateauTime) + "\n");
+    Serial.println(F("CAPPER>OK"));
+  } else if (command.startsWith("unscrew_profile")) {
+    command = command.substring(15);
+    if (command.length() > 0) {
+      char buf[command.length()+1];
+      command.toCharArray(buf, command.length()+1);
+      char* part = strtok(buf, ";");
+      int i = 0;
+      while (part != 0) {
+          if (i==0) {
+            capper.unscrewProfile.inrushTime = atoi(part);
+          } else if (i==1) {
+            capper.unscrewProfile.minRotationTime = atoi(part);
+          } else if (i==2) {
+            capper.unscrewProfile.currentDropFraction = atof(part);
+          } else if (i==3) {
+            capper.unscrewProfile.currentStableTime = atoi(part);
+          } else if (i==4) {
+            capper.unscrewProfile.minConfidence = constrain(atoi(part), 0, 100);
+          }
+          i++;
+          part = strtok(0, ";");
+      }
+    }
+    Serial.print(F("CAPPER>"));
+    Serial.print(String(capper.unscrewProfile.inrushTime) + ";" + String(capper.unscrewProfile.minRotationTime) + ";" + String(capper.unscrewProfile.currentDropFraction) + ";" + String(capper.unscrewProfile.currentStableTime) + ";" + String(capper.unscrewProfile.minConfidence) + "\n");
+    Serial.println(F("CAPPER>OK"));
+  } else if (command.startsWith("grip_unscrew")) {
+    command = command.substring(12);
+    float current = 350.0;
+    int timeout = 10000;
+    byte reasons;
+    if (command.length() > 0) {
+      current = command.toFloat();
+      if (command.indexOf(';') >= 0) {
+        timeout = command.substring(command.indexOf(';') + 1).toInt();
+      }
+    }
+    if (!capper.closeClamp(current, false, -1, true)) {
+      Serial.print(F("CAPPER>ERROR "));
+      Serial.println(String(capper.errors) + ": " + ((capper.errors == 1) ? "NO SERVO CURRENT READINGS" : "CONTAINER NOT GRIPPED"));
+      return;
+    }
+    reasons = capper.unscrewUntilFree(timeout);
+    Serial.print(F("CAPPER>DIAMETER "));
+    Serial.print(String(capper.clampDiameter) + "\n");
+    if (capper.unscrewConfidence >= capper.unscrewProfile.minConfidence) {
+      Serial.print(F("CAPPER>FREE "));
+      Serial.print(String(capper.unscrewConfidence) + " " + capper.getUnscrewReasons(reasons) + "\n");
+      Serial.println(F("CAPPER>OK"));
+    } else {
+      Serial.print(F("CAPPER>ERROR 3: "));
+      Serial.println(getErrorMessage(3));
+    }
+  } else if (command.startsWith("unscrew")) {
+    int timeout = 10000;
+    byte reasons;
+    if (command.length() > 7) {
+      timeout = command.substring(7).toInt();
+    }
+    reasons = capper.unscrewUntilFree(timeout);
+    if (capper.unscrewConfidence >= capper.unscrewProfile.minConfidence) {
+      Serial.print(F("CAPPER>FREE "));
+      Serial.print(String(capper.unscrewConfidence) + " " + capper.getUnscrewReasons(reasons) + "\n");
+      Serial.println(F("CAPPER>OK"));
+    } else {
+      Serial.print(F("CAPPER>ERROR 3: "));
+      Serial.println(getErrorMessage(3));
+    }
   } else if (command=="turn_cw") {
     capper.turnWristClockwise();
     Serial.println("CAPPER>OK");
@@ -429,18 +844,316 @@ void handleCapperDecapperCommand(String command) {
     } else {
       capper.closeClamp(command.substring(11).toFloat());
     }
+    if (capper.errors == 1) {  // closing without contact is fine here (e.g. to close the empty clamp), the diameter is 0 then
+      Serial.println(F("CAPPER>ERROR 1: NO SERVO CURRENT READINGS"));
+    } else {
+      Serial.print(F("CAPPER>DIAMETER "));
+      Serial.print(String(capper.clampDiameter) + "\n");
+      Serial.println(F("CAPPER>OK"));
+    }
+  } else if (command.startsWith("grip_profile")) {
+    command = command.substring(12);
+    if (command.length() > 0) {
+      char buf[command.length()+1];
+      command.toCharArray(buf, command.length()+1);
+      char* part = strtok(buf, ";");
+      int i = 0;
+      while (part != 0) {
+          if (i==0) {
+            capper.gripProfile.fastStepTime = atoi(part);
+          } else if (i==1) {
+            capper.gripProfile.fineStepTime = atoi(part);
+          } else if (i==2) {
+            capper.gripProfile.contactDelta = atof(part);
+          } else if (i==3) {
+            capper.gripProfile.holdBand = atof(part);
+          } else if (i==4) {
+            capper.gripProfile.settleTime = atoi(part);
+          } else if (i==5) {
+            capper.gripProfile.timeout = atoi(part);
+          }
+          i++;
+          part = strtok(0, ";");
+      }
+    }
+    Serial.print(F("CAPPER>"));
+    Serial.print(String(capper.gripProfile.fastStepTime) + ";" + String(capper.gripProfile.fineStepTime) + ";" + String(capper.gripProfile.contactDelta) + ";" + String(capper.gripProfile.holdBand) + ";" + String(capper.gripProfile.settleTime) + ";" + String(capper.gripProfile.timeout) + "\n");
+    Serial.println(F("CAPPER>OK"));
+  } else if (command.startsWith("wrist_profile")) {
+    command = command.substring(13);
+    if (command.length() > 0) {
+      char buf[command.length()+1];
+      command.toCharArray(buf, command.length()+1);
+      char* part = strtok(buf, ";");
+      int i = 0;
+      while (part != 0) {
+          if (i==0) {
+            capper.wristProfile.startDuty = constrain(atoi(part), 0, 255);
+          } else if (i==1) {
+            capper.wristProfile.cruiseDuty = constrain(atoi(part), 0, 255);
+          } else if (i==2) {
+            capper.wristProfile.rampTime = atoi(part);
+          } else if (i==3) {
+            capper.wristProfile.torqueDuty = constrain(atoi(part), 0, 255);
+          } else if (i==4) {
+            capper.wristProfile.torqueTime = atoi(part);
+          } else if (i==5) {
+            capper.wristProfile.brakeTime = atoi(part);
+          }
+          i++;
+          part = strtok(0, ";");
+      }
+    }
+    Serial.print(F("CAPPER>"));
+    Serial.print(String(capper.wristProfile.startDuty) + ";" + String(capper.wristProfile.cruiseDuty) + ";" + String(capper.wristProfile.rampTime) + ";" + String(capper.wristProfile.torqueDuty) + ";" + String(capper.wristProfile.torqueTime) + ";" + String(capper.wristProfile.brakeTime) + "\n");
     Serial.println("CAPPER>OK");
   } else {
     Serial.println("CAPPER>UNK: " + command);
   }
 }
 
+void handleBenchCommand() {
+  // Measures the timing of this board with its actual wiring (takes about 1 s). The stepper driver of valve 1 stays disabled while its step pin is
+  // used for the digitalWrite and step rate measurements, the capper servo is written with its current position.
+  const int analogPins[6] = {hallSensorPinValve1, hallSensorPinValve2, currentSensorPinHotplateClamp1, currentSensorPinHotplateClamp2, currentSensorPinHotplateClamp3, pressureSensorPin};
+  unsigned long serialTime;
+
+  if (capper.isStreaming) {
+    Serial.println(F("BENCH>ERROR: CAPPER STREAM ACTIVE"));
+    return;
+  }
+  Serial.print(F("BENCH>DELAY 100;"));
+  Serial.print(String(benchmarkDelayMicroseconds(100)) + "\n");
+  Serial.print(F("BENCH>DELAY 2000;"));
+  Serial.print(String(benchmarkDelayMicroseconds(2000)) + "\n");
+  for (int i = 0; i < 6; i++) {
+    int otherPin = analogPins[(i + 1) % 6];
+    Serial.print(F("BENCH>ANALOG "));
+    Serial.print(String(analogPins[i]) + " " + String(benchmarkAnalogRead(analogPins[i])) + ";" + String(benchmarkAnalogSettling(analogPins[i], otherPin, 0)) + ";" + String(benchmarkAnalogSettling(analogPins[i], otherPin, 100)) + "\n");
+  }
+  digitalWrite(sleepPinValve1, !enableIsHighValve1);
+  Serial.print(F("BENCH>DIGITALWRITE "));
+  Serial.print(String(benchmarkDigitalWrite(stepPinValve1)) + "\n");
+  Serial.print(F("BENCH>STEP "));
+  Serial.print(String(benchmarkStepRate(stepPinValve1, dirPinValve1)) + "\n");
+  capper.benchmark("BENCH");
+  Serial.print(F("BENCH>DHT22 "));
+  Serial.print(String(dhtSensor1.readDuration) + "\n");
+  serialTime = benchmarkSerial("BENCH");
+  Serial.print(F("BENCH>SERIAL "));
+  Serial.print(String(BENCH_SERIAL_BYTES) + ";" + String(serialTime) + ";" + String(BENCH_SERIAL_BYTES * 1000000.0 / serialTime) + ";" + String(serialBaudRate / 10) + "\n");
+  Serial.println(F("BENCH>OK"));
+}
+
+void handleSubscribeCommand(String command) {
+  // subscribe <channel>;<period> (period in ms, 0 unsubscribes), or without parameters: list the subscribed channels and their periods
+  int separator = command.indexOf(';');
+  String reply = "";
+
+  if (command == "") {
+    for (byte i = 0; i < TELEMETRY_CHANNELS; i++) {
+      if (telemetry.getPeriod(i) != 0) {
+        reply += telemetry.getChannelName(i) + ";" + String(telemetry.getPeriod(i)) + "\n";
+      }
+    }
+    Serial.print(F("TELEMETRY>"));
+    Serial.println(reply + "OK");
+  } else if (separator < 0) {
+    Serial.println(F("TELEMETRY>ERROR: PERIOD MISSING"));
+  } else if (telemetry.subscribe(command.substring(0, separator), (unsigned long)command.substring(separator + 1).toInt())) {
+    Serial.println(F("TELEMETRY>OK"));
+  } else {
+    Serial.print(F("TELEMETRY>ERROR: UNKNOWN CHANNEL "));
+    Serial.println(command.substring(0, separator));
+  }
+}
+
+void handleUnsubscribeCommand(String command) {
+  // unsubscribe <channel>, or without parameters: unsubscribe all channels
+  if (command == "") {
+    telemetry.unsubscribeAll();
+    Serial.println(F("TELEMETRY>OK"));
+  } else if (telemetry.unsubscribe(command)) {
+    Serial.println(F("TELEMETRY>OK"));
+  } else {
+    Serial.print(F("TELEMETRY>ERROR: UNKNOWN CHANNEL "));
+    Serial.println(command);
+  }
+}
+
+void handleWatchCommand(String command) {
+  // watch <channel>;<mode>[;<threshold>;<hysteresis>] (mode 0 disarms), watch <motion|limits|errors>, or without parameters: list the watches
+  int separator = command.indexOf(';');
+  String channel = (separator < 0) ? command : command.substring(0, separator);
+  float params[3] = {WATCH_CHANGE, 0, 0};  // mode, threshold, hysteresis
+
+  if (command == "") {
+    Serial.print(F("EVENT>"));
+    Serial.println(telemetry.getWatches() + "OK");
+    return;
+  }
+  if (separator >= 0) {
+    command = command.substring(separator + 1);
+    for (byte i = 0; i < 3 && command.length() > 0; i++) {
+      separator = command.indexOf(';');
+      params[i] = ((separator < 0) ? command : command.substring(0, separator)).toFloat();
+      command = (separator < 0) ? "" : command.substring(separator + 1);
+    }
+  }
+  if (telemetry.watch(channel, (byte)params[0], params[1], params[2])) {
+    Serial.println(F("EVENT>OK"));
+  } else {
+    Serial.print(F("EVENT>ERROR: UNKNOWN CHANNEL OR MODE "));
+    Serial.println(channel);
+  }
+}
+
+void handleUnwatchCommand(String command) {
+  // unwatch <channel>, or without parameters: disarm all watches
+  if (command == "") {
+    telemetry.unwatchAll();
+    Serial.println(F("EVENT>OK"));
+  } else if (telemetry.unwatch(command)) {
+    Serial.println(F("EVENT>OK"));
+  } else {
+    Serial.print(F("EVENT>ERROR: UNKNOWN CHANNEL "));
+    Serial.println(command);
+  }
+}
+
+/**********************************
+ * Background Tasks               *
+ **********************************/
+void yield() {
+  // Called by delay() and by isTimedOut(), i.e. from every blocking loop, so the waveforms of the electromagnet and the cool-down profiles of
+  // the fans keep running while other devices execute a command
+  static bool isRunning = false;  // the background tasks use isTimedOut() themselves
+  float temperature;
+
+  if (isRunning) {
+    return;
+  }
+  isRunning = true;
+  runtimeStatistics.waitPolled();
+  electromagnet1.update();
+  temperature = dhtSensor1.getTemperature();  // temperature input of the cool-down profiles
+  hotplateFan1.update(temperature);
+  hotplateFan2.update(temperature);
+  hotplateFan3.update(temperature);
+  hotplateFan4.update(temperature);
+  isRunning = false;
+}
+
+float readTelemetryChannel(byte channel) {
+  // Current value of a telemetry channel, NAN if there is no valid value
+  byte switches = 0;
+  const byte switchPins[7] = {switchPinHotplateClamp1Down, switchPinHotplateClamp1Up, switchPinHotplateClamp2Down, switchPinHotplateClamp2Up, switchPinHotplateClamp3Down, switchPinHotplateClamp3Up, switchPinHotplateClamp4};
+
+  switch (channel) {
+    case TELEMETRY_HALL1:
+      return valve1.readHallSensorSignal(false) - valve1.hallSensorIdleSignal;
+    case TELEMETRY_HALL2:
+      return valve2.readHallSensorSignal(false) - valve2.hallSensorIdleSignal;
+    case TELEMETRY_VALVE1:
+      return valve1.currentPos;
+    case TELEMETRY_VALVE2:
+      return valve2.currentPos;
+    case TELEMETRY_PRESSURE:
+      return capper.pressure;
+    case TELEMETRY_MOTOR_CURRENT:
+      return capper.getLatestCurrent(0);
+    case TELEMETRY_SERVO_CURRENT:
+      return capper.getLatestCurrent(1);
+    case TELEMETRY_CLAMP1:
+      return hotplateClamp1.sampleCurrent();
+    case TELEMETRY_CLAMP2:
+      return hotplateClamp2.sampleCurrent();
+    case TELEMETRY_CLAMP3:
+      return hotplateClamp3.sampleCurrent();
+    case TELEMETRY_SWITCHES:
+      for (byte i = 0; i < 7; i++) {
+        if (digitalRead(switchPins[i]) == LOW) {  // the limit switches pull the input low when they are triggered
+          switches |= (1 << i);
+        }
+      }
+      return switches;
+    case TELEMETRY_TEMPERATURE1:
+      return dhtSensor1.getTemperature();
+    case TELEMETRY_HUMIDITY1:
+      return dhtSensor1.getHumidity();
+  }
+  return NAN;
+}
+
+void updateTelemetry() {
+  // Sends the values of all subscribed channels that are due in one line: TELEMETRY>DATA <time in ms>;<channel>=<value>;... Only called while the
+  // loop is idle, so the pushed lines never end up inside the reply of a command. Values are held back while the transmit buffer is too full.
+  bool isSent[TELEMETRY_CHANNELS];
+  String line;
+  float value;
+
+  if (telemetry.subscriptions == 0) {
+    return;
+  }
+  line = "TELEMETRY>DATA " + String(millis());
+  for (byte i = 0; i < TELEMETRY_CHANNELS; i++) {
+    isSent[i] = false;
+    if (telemetry.isDue(i)) {
+      value = readTelemetryChannel(i);
+      if (!isnan(value)) {  // e.g. no valid reading of the DHT22 sensor yet, try again in the next iteration
+        line += ";" + telemetry.getChannelName(i) + "=" + String(value, telemetry.getDecimals(i));
+        isSent[i] = true;
+      }
+    }
+  }
+  // Lines longer than the transmit buffer are sent as soon as it is empty, the rest of the line is then written blocking
+  if (line.indexOf(';') < 0 || Serial.availableForWrite() < min((int)line.length() + 2, SERIAL_TX_BUFFER_SIZE - 1)) {
+    return;
+  }
+  Serial.println(line);
+  for (byte i = 0; i < TELEMETRY_CHANNELS; i++) {
+    if (isSent[i]) {
+      telemetry.markSent(i);
+    }
+  }
+}
+
+void updateWatches() {
+  // Sends an event line for every watch whose condition was met: EVENT>WATCH <time in ms>;<channel>;<rising|falling|change>;<value> for the
+  // telemetry channels and EVENT>TRACE <time in ms>;<type>;<source>;<value> (see EventTrace.h) for the watched events of the event trace, which
+  // are mostly added while a command is running. Only called while the loop is idle, so these are sent right after the reply of the command.
+  static const char conditions[5][8] PROGMEM = {"", "rising", "falling", "", "change"};
+  TraceEvent event;
+  float value;
+  byte condition;
+
+  if (telemetry.watches == 0) {
+    return;
+  }
+  for (byte i = 0; i < TELEMETRY_CHANNELS; i++) {
+    if (telemetry.isWatched(i)) {
+      value = readTelemetryChannel(i);
+      if (!isnan(value)) {
+        condition = telemetry.checkWatch(i, value);
+        if (condition != WATCH_OFF) {
+          Serial.print(F("EVENT>WATCH "));
+          Serial.println(String(millis()) + ";" + telemetry.getChannelName(i) + ";" + String((const __FlashStringHelper *)conditions[condition]) + ";" + String(value, telemetry.getDecimals(i)));
+        }
+      }
+    }
+  }
+  while (telemetry.getTraceEvent(&event)) {
+    Serial.print(F("EVENT>TRACE "));
+    Serial.println(String(millis() - (micros() - event.time) / 1000) + ";" + String(event.type) + ";" + String(event.source) + ";" + String(event.value));
+  }
+}
+
 /**********************************
  * Setup                          *
  **********************************/
 void setup() {
   // initialize the serial port:
-  Serial.begin(9600);
+  Serial.begin(serialBaudRate);
   
   // Initialize connected Hardware
   capper = CapperDecapper(dcMotorPin1, dcMotorPin2, servoPinCapper, pressureSensorPin, currentSensorDCMotorAddress, currentSensorServoMotorAddress, servoClosedPosDegrees, servoOpenedPosDegrees, servoClosedPosMillimeters, servoOpenedPosMillimeters);
@@ -449,24 +1162,38 @@ void setup() {
   hotplateClamp1 = HotplateClampDCMotor(dcMotorPin1HotplateClamp1, dcMotorPin2HotplateClamp1, servoPinHotplateClamp1, currentSensorPinHotplateClamp1, switchPinHotplateClamp1Up, switchPinHotplateClamp1Down , servoHotplateClamp1ClosedPos, servoHotplateClamp1OpenedPos);
   hotplateClamp2 = HotplateClampDCMotor(dcMotorPin1HotplateClamp2, dcMotorPin2HotplateClamp2, servoPinHotplateClamp2, currentSensorPinHotplateClamp2, switchPinHotplateClamp2Up, switchPinHotplateClamp2Down , servoHotplateClamp2ClosedPos, servoHotplateClamp2OpenedPos);
   hotplateClamp3 = HotplateClampDCMotor(dcMotorPin1HotplateClamp3, dcMotorPin2HotplateClamp3, servoPinHotplateClamp3, currentSensorPinHotplateClamp3, switchPinHotplateClamp3Up, switchPinHotplateClamp3Down , servoHotplateClamp3ClosedPos, servoHotplateClamp3OpenedPos);
+  hotplateClamp4 = HotplateClampStepperMotor(dirPinHotplateClamp4, stepPinHotplateClamp4, sleepPinHotplateClamp4, servoPinHotplateClamp4, switchPinHotplateClamp4, servoHotplateClamp4ClosedPos, servoHotplateClamp4OpenedPos, microsteppingFactorHotplateClamp4, stepsPerRevolutionHotplateClamp4, mmPerRevolutionHotplateClamp4, maxSpeedHotplateClamp4, accelerationHotplateClamp4, maxPosHotplateClamp4);
   hotplateFan1 = HotplateFan(enablePinHotplateFan1);
   hotplateFan2 = HotplateFan(enablePinHotplateFan2);
   hotplateFan3 = HotplateFan(enablePinHotplateFan3);
   hotplateFan4 = HotplateFan(enablePinHotplateFan4);
   dhtSensor1 = DHT22Sensor(dhtSensorPin1);
   electromagnet1 = Electromagnet(electromagnet1Pin1, electromagnet1Pin2);
+
+  // Device numbers of the events in the event trace
+  valve1.traceSource = TRACE_SOURCE_VALVE + 1;
+  valve2.traceSource = TRACE_SOURCE_VALVE + 2;
+  hotplateClamp1.traceSource = TRACE_SOURCE_CLAMP + 1;
+  hotplateClamp2.traceSource = TRACE_SOURCE_CLAMP + 2;
+  hotplateClamp3.traceSource = TRACE_SOURCE_CLAMP + 3;
+  hotplateClamp4.traceSource = TRACE_SOURCE_CLAMP + 4;
 }
 
 /**********************************
  * Main Loop                      *
  **********************************/
 void loop() {
+  runtimeStatistics.loopStarted();
   if (Serial.available() > 0) {
+    runtimeStatistics.checkSerialBuffer();
     String command = Serial.readStringUntil(10);
     command.replace("\r", "");
     command.replace("\n", "");
     command.replace(" ", "");
     command.toLowerCase();
+    runtimeStatistics.commandStarted(command);
+    byte traceSource = getTraceSource(command);
+    eventTrace.add(TRACE_COMMAND_RECEIVED, traceSource, Serial.available());
     if (command == "esr") {
       emergencyStopRequest = true;      
       Serial.println("Emergency Stop Request: OK");
@@ -474,6 +1201,27 @@ void loop() {
     } else if (command == "ces") {
       emergencyStopRequest = false;
       Serial.println("Clear Emergency Stop: OK");
+    } else if (command == "statsreset") {
+      runtimeStatistics.reset();
+      Serial.println(F("STATS>OK"));
+    } else if (command == "stats") {
+      runtimeStatistics.print();
+    } else if (command == "traceclear") {
+      eventTrace.clear();
+      Serial.println(F("TRACE>OK"));
+    } else if (command == "trace") {
+      eventTrace.dump("TRACE");
+      Serial.println(F("TRACE>OK"));
+    } else if (command.startsWith("subscribe")) {
+      handleSubscribeCommand(command.substring(9));
+    } else if (command.startsWith("unsubscribe")) {
+      handleUnsubscribeCommand(command.substring(11));
+    } else if (command.startsWith("watch")) {
+      handleWatchCommand(command.substring(5));
+    } else if (command.startsWith("unwatch")) {
+      handleUnwatchCommand(command.substring(7));
+    } else if ((!emergencyStopRequest) && (command == "bench")) {
+      handleBenchCommand();
     } else if ((!emergencyStopRequest) && (command.startsWith("help"))) {
       displayHelp();
     } else if ((!emergencyStopRequest) && (command.startsWith("valve"))) {
@@ -493,6 +1241,22 @@ void loop() {
     } else {
       Serial.println("Unknown Command: " + command);
     }
+    eventTrace.add(TRACE_COMMAND_DONE, traceSource, Serial.available());
+    runtimeStatistics.commandFinished();
+  }
+  // Keep the background sampling (and the sensor stream) of the capper going instead of idling in delay(20). The DHT22 sensor busy-waits
+  // for about 5 ms per reading, so it is only read here (never while a command is running) and not while the capper streams.
+  unsigned long idleStartTime = millis();
+  runtimeStatistics.idleStarted();
+  while (!isTimedOut(idleStartTime, 20)) {
+    runtimeStatistics.samplingStarted();
+    capper.updateSensors();
+    if (!capper.isStreaming) {
+      dhtSensor1.update();
+    }
+    updateTelemetry();
+    updateWatches();
+    runtimeStatistics.samplingFinished();
   }
-  delay(20);
+  runtimeStatistics.idleFinished();
 }
@@ -0,0 +1,246 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "AsyncCurrentSensors.h"
+#include "HelperFunctions.h"
+
+// INA219 registers
+const byte INA219_SHUNT_REG = 0x01;
+const byte INA219_BUS_REG = 0x02;
+const byte INA219_POWER_REG = 0x03;
+const byte INA219_CURRENT_REG = 0x04;
+
+// Steps of a register read (START, SLA+W, register pointer, repeated START, SLA+R, high byte, low byte)
+const byte PHASE_IDLE = 0;
+const byte PHASE_START = 1;
+const byte PHASE_ADDRESS_WRITE = 2;
+const byte PHASE_REGISTER = 3;
+const byte PHASE_RESTART = 4;
+const byte PHASE_ADDRESS_READ = 5;
+const byte PHASE_DATA_HIGH = 6;
+const byte PHASE_DATA_LOW = 7;
+
+AsyncCurrentSensors::AsyncCurrentSensors(void) {
+}
+
+AsyncCurrentSensors::AsyncCurrentSensors(byte address1, byte address2, float currentDivider_mA) {
+  this->addresses[0] = address1;
+  this->addresses[1] = address2;
+  this->currentDivider_mA = currentDivider_mA;  // 20 for PG_160 (current LSB of 50 uA), see INA219_WE::setPGain
+  for (int i = 0; i < 2; i++) {
+    this->current_mA[i] = 0.0;
+    this->shuntVoltage_mV[i] = 0.0;
+    this->busVoltage_V[i] = 0.0;
+    this->power_mW[i] = 0.0;
+    this->overflow[i] = false;
+    this->readingTime[i] = 0;
+    this->readingCount[i] = 0;
+  }
+  this->busErrors = 0;
+  this->transferTime = 0;
+  this->transferCount = 0;
+  this->sensor = 0;
+  this->reg = INA219_BUS_REG;
+  this->phase = PHASE_IDLE;
+  this->registerValue = 0;
+  this->currentRegister = 0;
+  this->shuntRegister = 0;
+  this->busRegister = 0;
+  this->transferStartTime = 0;
+}
+
+bool AsyncCurrentSensors::update() {
+  // For each sensor: read the bus voltage register and check the conversion ready flag. If a new conversion is available, read current, shunt voltage
+  // and power (which clears the flag) and publish the results, then switch to the other sensor. Returns true when a new reading was published.
+  if (this->phase == PHASE_IDLE) {
+    this->startTransfer(this->reg);
+    return false;
+  }
+  if (!this->continueTransfer()) {
+    return false;
+  }
+
+  if (this->reg == INA219_BUS_REG) {
+    this->busRegister = (uint16_t)this->registerValue;
+    if (this->busRegister & 0x02) {
+      this->reg = INA219_CURRENT_REG;
+    } else {
+      this->nextSensor();
+    }
+  } else if (this->reg == INA219_CURRENT_REG) {
+    this->currentRegister = this->registerValue;
+    this->reg = INA219_SHUNT_REG;
+  } else if (this->reg == INA219_SHUNT_REG) {
+    this->shuntRegister = this->registerValue;
+    this->reg = INA219_POWER_REG;
+  } else {
+    this->current_mA[this->sensor] = this->currentRegister / this->currentDivider_mA;
+    this->shuntVoltage_mV[this->sensor] = this->shuntRegister * 0.01;
+    this->busVoltage_V[this->sensor] = (this->busRegister >> 3) * 0.004;
+    this->power_mW[this->sensor] = this->current_mA[this->sensor] * this->busVoltage_V[this->sensor];
+    this->overflow[this->sensor] = (this->busRegister & 0x01);
+    this->readingTime[this->sensor] = micros();
+    this->readingCount[this->sensor]++;
+    this->nextSensor();
+    return true;
+  }
+  return false;
+}
+
+bool AsyncCurrentSensors::waitForNewReading(byte sensor, int timeout) {
+  unsigned int count = this->readingCount[sensor];
+  unsigned long startTime = millis();
+
+  while (this->readingCount[sensor] == count && !isTimedOut(startTime, timeout)) {
+    this->update();
+  }
+  return (this->readingCount[sensor] != count);
+}
+
+void AsyncCurrentSensors::nextSensor() {
+  this->sensor = 1 - this->sensor;
+  this->reg = INA219_BUS_REG;
+}
+
+#if defined(__AVR__)
+// Polled TWI state machine: the interrupt of the Wire library stays disabled while the transfer is running, every call of continueTransfer()
+// only checks the TWINT flag and starts the next step, so the loop never waits for the bus.
+
+bool AsyncCurrentSensors::startTransfer(byte reg) {
+  if (TWCR & _BV(TWSTO)) {
+    return false;  // STOP condition of the previous transfer is still being sent
+  }
+  this->reg = reg;
+  this->transferStartTime = micros();
+  TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN);
+  this->phase = PHASE_START;
+  return true;
+}
+
+bool AsyncCurrentSensors::continueTransfer() {
+  const unsigned long transferTimeout = 2000;  // in us, a register read takes about 130 us at 400 kHz
+  byte address = this->addresses[this->sensor];
+  byte status;
+
+  if (!(TWCR & _BV(TWINT))) {
+    if (micros() - this->transferStartTime > transferTimeout) {
+      this->recoverBus();
+      this->phase = PHASE_IDLE;
+      this->nextSensor();
+    }
+    return false;
+  }
+
+  status = TWSR & 0xF8;
+  if (this->phase == PHASE_START && (status == 0x08 || status == 0x10)) {
+    TWDR = address << 1;
+    TWCR = _BV(TWINT) | _BV(TWEN);
+    this->phase = PHASE_ADDRESS_WRITE;
+  } else if (this->phase == PHASE_ADDRESS_WRITE && status == 0x18) {
+    TWDR = this->reg;
+    TWCR = _BV(TWINT) | _BV(TWEN);
+    this->phase = PHASE_REGISTER;
+  } else if (this->phase == PHASE_REGISTER && status == 0x28) {
+    TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN);
+    this->phase = PHASE_RESTART;
+  } else if (this->phase == PHASE_RESTART && status == 0x10) {
+    TWDR = (address << 1) | 0x01;
+    TWCR = _BV(TWINT) | _BV(TWEN);
+    this->phase = PHASE_ADDRESS_READ;
+  } else if (this->phase == PHASE_ADDRESS_READ && status == 0x40) {
+    TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWEA);  // ACK after the high byte
+    this->phase = PHASE_DATA_HIGH;
+  } else if (this->phase == PHASE_DATA_HIGH && status == 0x50) {
+    this->registerValue = TWDR << 8;
+    TWCR = _BV(TWINT) | _BV(TWEN);  // NACK after the low byte
+    this->phase = PHASE_DATA_LOW;
+  } else if (this->phase == PHASE_DATA_LOW && status == 0x58) {
+    this->registerValue |= TWDR;
+    TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+    this->phase = PHASE_IDLE;
+    this->transferTime = micros() - this->transferStartTime;
+    this->transferCount++;
+    return true;
+  } else {
+    // NACK, arbitration lost or bus error
+    this->stopTransfer();
+    this->busErrors++;
+    this->phase = PHASE_IDLE;
+    this->nextSensor();
+  }
+  return false;
+}
+
+void AsyncCurrentSensors::stopTransfer() {
+  TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+}
+
+void AsyncCurrentSensors::recoverBus() {
+  // A slave holding SDA low is released by clocking SCL up to 9 times, followed by a STOP condition. Takes about 100 us instead of the 1 s Wire timeout.
+  // SDA and SCL are the TWI pins of the board variant (20 and 21 on the Mega, A4 and A5 on the Uno).
+  TWCR = 0;  // disable the TWI hardware to get control over the pins
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, INPUT_PULLUP);
+  for (int i = 0; i < 9 && digitalRead(SDA) == LOW; i++) {
+    pinMode(SCL, OUTPUT);
+    digitalWrite(SCL, LOW);
+    delayMicroseconds(5);
+    pinMode(SCL, INPUT_PULLUP);
+    delayMicroseconds(5);
+  }
+  pinMode(SDA, OUTPUT);
+  digitalWrite(SDA, LOW);
+  delayMicroseconds(5);
+  pinMode(SDA, INPUT_PULLUP);
+  delayMicroseconds(5);
+  TWCR = _BV(TWEN);
+  this->busErrors++;
+}
+
+#else
+// Other cores (and the host build): one complete register read with the Wire library per call
+
+bool AsyncCurrentSensors::startTransfer(byte reg) {
+  this->reg = reg;
+  this->transferStartTime = micros();
+  this->phase = PHASE_START;
+  return true;
+}
+
+bool AsyncCurrentSensors::continueTransfer() {
+  byte address = this->addresses[this->sensor];
+
+  Wire.beginTransmission(address);
+  Wire.write(this->reg);
+  if (Wire.endTransmission(false) != 0 || Wire.requestFrom(address, (byte)2) != 2) {
+    if (Wire.getWireTimeoutFlag()) {
+      this->recoverBus();
+    }
+    this->busErrors++;
+    this->phase = PHASE_IDLE;
+    this->nextSensor();
+    return false;
+  }
+  this->registerValue = Wire.read() << 8;
+  this->registerValue |= Wire.read();
+  this->phase = PHASE_IDLE;
+  this->transferTime = micros() - this->transferStartTime;
+  this->transferCount++;
+  return true;
+}
+
+void AsyncCurrentSensors::stopTransfer() {
+  Wire.endTransmission(true);
+}
+
+void AsyncCurrentSensors::recoverBus() {
+  Wire.clearWireTimeoutFlag();  // the Wire library already reset the bus after the timeout
+}
+#endif
@@ -0,0 +1,49 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#ifndef AsyncCurrentSensors_h
+#define AsyncCurrentSensors_h
+#include <Arduino.h>
+#include <Wire.h>
+
+// Non-blocking reader for two INA219 current sensors running in continuous mode on the same I2C bus.
+// update() has to be called as often as possible, it advances the I2C transfer by one step and alternates between the sensors.
+class AsyncCurrentSensors {
+public:
+  AsyncCurrentSensors(void);
+  AsyncCurrentSensors(byte address1, byte address2, float currentDivider_mA=20.0);
+  bool update(void);
+  bool waitForNewReading(byte sensor, int timeout=50);
+  float current_mA[2];
+  float shuntVoltage_mV[2];
+  float busVoltage_V[2];
+  float power_mW[2];
+  bool overflow[2];
+  unsigned long readingTime[2];
+  unsigned int readingCount[2];
+  unsigned int busErrors;
+  unsigned long transferTime;  // in us, duration of the last register read
+  unsigned int transferCount;
+private:
+  bool startTransfer(byte reg);
+  bool continueTransfer(void);
+  void stopTransfer(void);
+  void recoverBus(void);
+  void nextSensor(void);
+  byte addresses[2];
+  float currentDivider_mA;
+  byte sensor;
+  byte reg;
+  byte phase;
+  int16_t registerValue;
+  int16_t currentRegister;
+  int16_t shuntRegister;
+  uint16_t busRegister;
+  unsigned long transferStartTime;
+};
+#endif
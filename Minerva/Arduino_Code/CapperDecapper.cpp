@@ -7,11 +7,68 @@
 */
 
 #include "CapperDecapper.h"
- 
+#include "EventTrace.h"
+#include "SelfBenchmark.h"
+
+// Sample clock of the binary sensor stream
+volatile unsigned long streamTickCount = 0;
+volatile unsigned long streamTickTime = 0;
+
+#if defined(__AVR__)
+// Timer1 runs in CTC mode with OCR1A as TOP and triggers the compare match B interrupt once per period. The Servo library defines the compare
+// match A interrupt of Timer1 (it only uses Timer1 for more than 12 servos, so the timer itself is free), hence channel B is used for the tick.
+ISR(TIMER1_COMPB_vect) {
+  streamTickTime = micros();
+  streamTickCount++;
+}
+
+void startStreamTimer(unsigned long period) {
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  OCR1A = period * (F_CPU / 8000000UL) - 1;  // prescaler of 8, 0.5 us per count at 16 MHz
+  OCR1B = 0;
+  TIFR1 = _BV(OCF1B);
+  TIMSK1 = _BV(OCIE1B);
+  TCCR1B = _BV(WGM12) | _BV(CS11);
+  interrupts();
+}
+
+void stopStreamTimer() {
+  TIMSK1 &= ~_BV(OCIE1B);
+  TCCR1B = 0;
+}
+
+void pollStreamTimer() {
+}
+#else
+// Other cores (and the host build): the tick is generated from micros() whenever the stream is serviced
+unsigned long streamPeriod = 0;
+unsigned long streamNextTick = 0;
+
+void startStreamTimer(unsigned long period) {
+  streamPeriod = period;
+  streamNextTick = micros() + period;
+}
+
+void stopStreamTimer() {
+  streamPeriod = 0;
+}
+
+void pollStreamTimer() {
+  while (streamPeriod > 0 && (long)(micros() - streamNextTick) >= 0) {
+    streamTickTime = streamNextTick;
+    streamTickCount++;
+    streamNextTick += streamPeriod;
+  }
+}
+#endif
+
 CapperDecapper::CapperDecapper(void) {
 }
 
-CapperDecapper::CapperDecapper(byte dcMotorPin1, byte dcMotorPin2, byte servoPin, int pressureSensorPin, int currentSensorDCMotorAddress=0x40, int currentSensorServoMotorAddress=0x41, int servoClosedPosDegrees=0, int servoOpenedPosDegrees=180, int servoClosedPosMillimeters = 4, int servoOpenedPosMillimeters=59) {
+CapperDecapper::CapperDecapper(byte dcMotorPin1, byte dcMotorPin2, byte servoPin, int pressureSensorPin, int currentSensorDCMotorAddress, int currentSensorServoMotorAddress, int servoClosedPosDegrees, int servoOpenedPosDegrees, int servoClosedPosMillimeters, int servoOpenedPosMillimeters) {
   // Pin conncetions
   this->dcMotorPin1 = dcMotorPin1;
   this->dcMotorPin2 = dcMotorPin2;
@@ -25,18 +82,18 @@ CapperDecapper::CapperDecapper(byte dcMotorPin1, byte dcMotorPin2, byte servoPin
   this->servoOpenedPosMillimeters = servoOpenedPosMillimeters;
   this->degreesPerMillimeter = (float)(servoOpenedPosDegrees-servoClosedPosDegrees)/(servoOpenedPosMillimeters-servoClosedPosMillimeters);
   this->currentPos = servoOpenedPosMillimeters;
-  const byte SDA_Pin = 20;  // I2C Pins on Arduino Mega are 20 (SDA) and 21 (SCL) (on the Uno they are A4 (SDA) and A5 (SCL)) --> Connect to corresponding pins on INA219 current sensor
-  const byte SCL_Pin = 21;
   
   // Global variables
   byte errors = 0;
   bool emergencyStopRequest = false;
 
-  // I2C Sensors
+  // I2C Sensors: the pins are SDA and SCL of the board variant, 20 (SDA) and 21 (SCL) on the Arduino Mega (on the Uno they are A4 (SDA) and A5 (SCL)) --> Connect to corresponding pins on INA219 current sensor
   Wire.begin();
-  Wire.setWireTimeout(1000000, true); // Timeout in uS, reset on timeout
+  Wire.setClock(400000);  // INA219 supports fast mode
+  Wire.setWireTimeout(5000, true); // Timeout in uS, reset on timeout (a register read takes about 130 us, so do not stall for long if the bus is stuck)
   this->currentSensorDCMotor = INA219_WE(this->currentSensorDCMotorAddress);
   this->currentSensorServoMotor = INA219_WE(this->currentSensorServoMotorAddress);
+  this->currentSensors = AsyncCurrentSensors(this->currentSensorDCMotorAddress, this->currentSensorServoMotorAddress);
   
   // Set pin modes and attach motors
   pinMode(this->servoPin, OUTPUT);
@@ -50,6 +107,61 @@ CapperDecapper::CapperDecapper(byte dcMotorPin1, byte dcMotorPin2, byte servoPin
 
   // Configure Sensors
   pinMode(this->pressureSensorPin, INPUT);
+  this->pressure = 0.0;
+  this->pressureSlope = 0.0;
+  this->pressureTime = 0;
+  this->pressureBaseline = 0.0;
+  this->pressureThreshold = 1023;
+  this->isThresholdArmed = false;
+  this->pressureHistoryIndex = 0;
+  this->pressureHistoryCount = 0;
+  this->pressureSampleSum = 0;
+  this->pressureSampleCount = 0;
+  this->lastPressureSampleTime = micros();
+  this->pressureEvents = 0;
+  this->isInContact = false;
+  this->isAboveThreshold = false;
+  this->isReleaseArmed = true;
+  for (int i = 0; i < PRESSURE_EVENT_COUNT; i++) {
+    this->pressureEventTime[i] = 0;
+    this->pressureEventValue[i] = 0.0;
+  }
+  this->pressureHysteresis = 5.0;  // in ADC counts
+  this->contactDelta = 20.0;  // in ADC counts above the baseline
+  this->contactSlope = 5.0;  // in ADC counts per slope window (about 32 ms)
+  this->releaseDelta = 30.0;  // in ADC counts drop per slope window (about 32 ms)
+  this->torqueProfile.inrushTime = 150;  // the soft start of the wrist avoids most of the inrush current
+  this->torqueProfile.levelThreshold = 200.0;
+  this->torqueProfile.riseThreshold = 80.0;
+  this->torqueProfile.slopeThreshold = 1000.0;
+  this->torqueProfile.plateauTime = 100;
+  this->seatedCurrent = 0.0;
+  this->unscrewProfile.inrushTime = 300;
+  this->unscrewProfile.minRotationTime = 500;
+  this->unscrewProfile.currentDropFraction = 0.6;
+  this->unscrewProfile.currentStableTime = 100;
+  this->unscrewProfile.minConfidence = 70;
+  this->unscrewConfidence = 0;
+  this->isStreaming = false;
+  this->gripProfile.fastStepTime = 15;
+  this->gripProfile.fineStepTime = 25;
+  this->gripProfile.contactDelta = 60.0;
+  this->gripProfile.holdBand = 0.15;
+  this->gripProfile.settleTime = 250;
+  this->gripProfile.timeout = 5000;
+  this->clampDiameter = 0.0;
+  this->wristProfile.startDuty = 100;
+  this->wristProfile.cruiseDuty = 255;
+  this->wristProfile.rampTime = 60;
+  this->wristProfile.torqueDuty = 140;
+  this->wristProfile.torqueTime = 0;  // depends on the length of the thread, see ContainerProfile
+  this->wristProfile.brakeTime = 100;
+  this->wristDirection = WRIST_STOPPED;
+  this->wristDuty = 0;
+  this->wristTargetDuty = 0;
+  this->wristRampStartDuty = 0;
+  this->wristRampStartTime = 0;
+  this->isWristBraking = false;
   
   if (!this->initializeCurrentSensor(&this->currentSensorDCMotor)) {
     this->errors = 1;
@@ -61,86 +173,546 @@ CapperDecapper::CapperDecapper(byte dcMotorPin1, byte dcMotorPin2, byte servoPin
   }
 }
 
-bool CapperDecapper::openContainer(int pos=31, int pThreshold=100, int timeout=10000) {
+bool CapperDecapper::startStream(byte channels, unsigned long period, byte decimation, unsigned long duration, unsigned long maxByteRate) {
+  // Starts streaming binary records of the selected channels with a fixed sample period (in us, driven by Timer1). Every record holds the
+  // average of <decimation> samples. The stream ends after <duration> ms (0 streams until stopStream() is called). Configurations with more
+  // bytes per second than the serial port can send (<maxByteRate>) are rejected, since most of their records would be dropped.
+  const unsigned long minPeriod = 500;  // in us
+  const unsigned long maxPeriod = 32000;  // in us, limited by the 16 bit timer
+  unsigned long recordSize = 7;  // sync byte, sequence number, time stamp and checksum
+
+  channels &= (1 << STREAM_CHANNEL_COUNT) - 1;
+  if (channels == 0 || period < minPeriod || period > maxPeriod || decimation == 0) {
+    return false;
+  }
+  for (int i = 0; i < STREAM_CHANNEL_COUNT; i++) {
+    if (bitRead(channels, i)) {
+      recordSize += 2;
+    }
+  }
+  if (recordSize * 1000000 / (period * decimation) > maxByteRate) {  // bytes per second of the stream
+    return false;
+  }
+  if (this->isStreaming) {
+    this->stopStream();
+  }
+
+  this->streamChannels = channels;
+  this->streamDecimation = decimation;
+  this->streamSampleCount = 0;
+  this->streamSequence = 0;
+  this->streamRecords = 0;
+  this->streamDropped = 0;
+  this->streamMissed = 0;
+  this->streamStartTime = millis();
+  this->streamDuration = duration;
+  for (int i = 0; i < STREAM_CHANNEL_COUNT; i++) {
+    this->streamSums[i] = 0;
+  }
+  Serial.print(F("CAPPER>STREAM "));
+  Serial.println(String(channels) + ";" + String(period) + ";" + String(decimation));  // own line, the host switches to binary mode
+  Serial.println(F("CAPPER>OK"));
+
+  startStreamTimer(period);
+  this->streamTicks = streamTickCount;
+  this->isStreaming = true;
+  return true;
+}
+
+void CapperDecapper::stopStream() {
+  if (!this->isStreaming) {
+    return;
+  }
+  stopStreamTimer();
+  this->isStreaming = false;
+  Serial.print(F("CAPPER>STREAM END "));
+  Serial.println(String(this->streamRecords) + ";" + String(this->streamDropped) + ";" + String(this->streamMissed));
+}
+
+void CapperDecapper::updateStream() {
+  // Takes one sample of the latest sensor values per timer tick and sends a record after <decimation> samples. Record layout (little endian):
+  // sync byte (0xA5), sequence number (uint8), timestamp of the last sample in us (uint32), one int16 per channel, XOR of all bytes after the sync byte.
+  // Records that do not fit into the serial transmit buffer are dropped instead of blocking, ticks that were not serviced in time are counted as missed.
+  byte record[6 + 2 * STREAM_CHANNEL_COUNT + 1];
+  byte length = 0;
+  unsigned long ticks;
+  unsigned long tickTime;
+  long value;
+
+  if (!this->isStreaming) {
+    return;
+  }
+  if (this->streamDuration > 0 && isTimedOut(this->streamStartTime, this->streamDuration)) {
+    this->stopStream();
+    return;
+  }
+
+  pollStreamTimer();
+  noInterrupts();
+  ticks = streamTickCount;
+  tickTime = streamTickTime;
+  interrupts();
+  if (ticks == this->streamTicks) {
+    return;
+  }
+  this->streamMissed += ticks - this->streamTicks - 1;
+  this->streamTicks = ticks;
+
+  for (int i = 0; i < STREAM_CHANNEL_COUNT; i++) {
+    if (!bitRead(this->streamChannels, i)) {
+      continue;
+    }
+    if (i == 0) {
+      this->streamSums[i] += (long)(this->pressure * 4);
+    } else if (i == 1) {
+      this->streamSums[i] += (long)(this->currentSensors.current_mA[0] * 10);
+    } else if (i == 2) {
+      this->streamSums[i] += (long)(this->currentSensors.current_mA[1] * 10);
+    } else {
+      this->streamSums[i] += (long)(this->currentSensors.busVoltage_V[0] * 1000);
+    }
+  }
+  this->streamSampleCount++;
+  if (this->streamSampleCount < this->streamDecimation) {
+    return;
+  }
+
+  record[length++] = STREAM_SYNC;
+  record[length++] = this->streamSequence++;
+  for (int i = 0; i < 4; i++) {
+    record[length++] = (tickTime >> (8 * i)) & 0xFF;
+  }
+  for (int i = 0; i < STREAM_CHANNEL_COUNT; i++) {
+    if (bitRead(this->streamChannels, i)) {
+      value = constrain(this->streamSums[i] / this->streamDecimation, -32768, 32767);
+      record[length++] = lowByte(value);
+      record[length++] = highByte(value);
+    }
+    this->streamSums[i] = 0;
+  }
+  record[length] = 0;
+  for (int i = 1; i < length; i++) {
+    record[length] ^= record[i];
+  }
+  length++;
+  this->streamSampleCount = 0;
+
+  if (Serial.availableForWrite() < length) {
+    this->streamDropped++;
+    return;
+  }
+  Serial.write(record, length);
+  this->streamRecords++;
+}
+
+bool CapperDecapper::openContainer(int pos, int pThreshold, int timeout, float gripCurrent) {
   unsigned long startTime = millis();
-  int pCurrent = 0;
+  bool thresholdReached = false;
+  byte reasons;
   
-  while (!isTimedOut(startTime, timeout) && pCurrent < pThreshold) {
-    pCurrent = this->readPressureSensor(64, true);
-    delay(10);
+  this->recorder.beginCycle(RECORDER_CYCLE_OPEN, pThreshold, (int)gripCurrent, timeout, pos);
+  this->recorder.setPhase(RECORDER_PHASE_WAIT_PRESSURE);
+  this->resetPressureEvents(pThreshold);
+  while (!isTimedOut(startTime, timeout) && !thresholdReached) {
+    this->updateSensors();
+    thresholdReached = this->hasPressureEvent(PRESSURE_EVENT_THRESHOLD_UP);
   }
 
-  if (pCurrent < pThreshold) {
+  if (!thresholdReached) {
+    this->isThresholdArmed = false;
+    this->recorder.endCycle(false, 0, 0);
     return false;
   }
+  this->logPressureEvent(PRESSURE_EVENT_THRESHOLD_UP);
 
-  this->closeClamp(pos);
-  this->turnWristCounterClockwise();
-  delay(1000); // wait for 1 second before checking if the uncapping is done
-  
-  startTime = millis();
-  while (!isTimedOut(startTime, timeout) && pCurrent > pThreshold) {
-    pCurrent = this->readPressureSensor(64, true);
-    delay(10);
+  this->recorder.setPhase(RECORDER_PHASE_CLAMP_CLOSE);
+  if (!this->closeClamp(gripCurrent, false, pos, true)) {
+    Serial.print(F("CAPPER>ERROR "));
+    Serial.print(String(this->errors) + ": " + ((this->errors == 1) ? "NO SERVO CURRENT READINGS" : "CONTAINER NOT GRIPPED") + "\n");
+    this->recorder.setPhase(RECORDER_PHASE_CLAMP_OPEN);
+    this->openClamp();
+    this->isThresholdArmed = false;
+    this->recorder.endCycle(false, 0, 0);
+    return false;
   }
+  this->recorder.setPhase(RECORDER_PHASE_UNSCREW);
+  reasons = this->unscrewUntilFree(timeout);
 
-  if (pCurrent > pThreshold) {
-    Serial.print("CAPPER>ERROR: TIMEOUT\n");
+  if (this->unscrewConfidence < this->unscrewProfile.minConfidence) {
+    Serial.print(F("CAPPER>ERROR: TIMEOUT (CONFIDENCE "));
+    Serial.print(String(this->unscrewConfidence) + "%: " + this->getUnscrewReasons(reasons) + ")\n");
+    this->recorder.setPhase(RECORDER_PHASE_CLAMP_OPEN);
     this->openClamp();
-  } else {
-    Serial.print("CAPPER>OK: STOPPING CRITERION MET\n");
+    this->isThresholdArmed = false;
+    this->recorder.endCycle(false, reasons, this->unscrewConfidence);
+    return false;
   }
-  return (pCurrent <= pThreshold);
+  Serial.print(F("CAPPER>OK: CAP FREE (CONFIDENCE "));
+  Serial.print(String(this->unscrewConfidence) + "%: " + this->getUnscrewReasons(reasons) + ")\n");
+  this->isThresholdArmed = false;
+  this->recorder.endCycle(true, reasons, this->unscrewConfidence);
+  return true;
 }
 
-bool CapperDecapper::closeContainer(int pThreshold=1000, float iThreshold=200.0, int timeout=10000) {
+byte CapperDecapper::unscrewUntilFree(int timeout) {
+  // Turns the wrist counter-clockwise until the cap is free. Combines the pressure release, the pressure threshold, the drop of the wrist current
+  // from the breakaway peak to the free-running current and the rotation time into a confidence, and stops the wrist once it is high enough.
+  const byte weights[4] = {50, 30, 40, 30};  // PRESSURE_RELEASE, PRESSURE_BELOW, CURRENT_FREE, MIN_TIME
+  const float filterWeight = 0.25;
+  unsigned int readingCount = this->currentSensors.readingCount[0];
   unsigned long startTime = millis();
-  int pCurrent = 0;
-  float iCurrent = 0.0;
+  unsigned long belowFractionTime = 0;
+  bool isBelowFraction = false;
+  float filtered = 0.0;
+  float peak = 0.0;
+  byte reasons = 0;
+  int confidence = 0;
+
+  this->turnWristCounterClockwise();
+  this->hasPressureEvent(PRESSURE_EVENT_RELEASE);
+  while (!isTimedOut(startTime, timeout) && confidence < this->unscrewProfile.minConfidence) {
+    this->updatePressureSensor();
+    if (this->hasPressureEvent(PRESSURE_EVENT_RELEASE)) {
+      reasons |= UNSCREW_PRESSURE_RELEASE;
+    }
+    if (this->isThresholdArmed && !this->isAboveThreshold) {
+      // Only meaningful if the threshold was set for this cycle (not for a plain "capper unscrew", where it is still the default)
+      reasons |= UNSCREW_PRESSURE_BELOW;
+    } else {
+      reasons &= ~UNSCREW_PRESSURE_BELOW;
+    }
+    if (isTimedOut(startTime, this->unscrewProfile.minRotationTime)) {
+      reasons |= UNSCREW_MIN_TIME;
+    }
+
+    if (this->currentSensors.update() && this->currentSensors.readingCount[0] != readingCount) {
+      readingCount = this->currentSensors.readingCount[0];
+      if (filtered == 0.0) {
+        filtered = this->readWristMotorCurrent();
+      } else {
+        filtered += filterWeight * (this->readWristMotorCurrent() - filtered);
+      }
+      if (isTimedOut(startTime, this->unscrewProfile.inrushTime)) {
+        peak = max(peak, filtered);
+        if (filtered < peak * this->unscrewProfile.currentDropFraction) {
+          if (!isBelowFraction) {
+            isBelowFraction = true;
+            belowFractionTime = millis();
+          } else if (isTimedOut(belowFractionTime, this->unscrewProfile.currentStableTime)) {
+            reasons |= UNSCREW_CURRENT_FREE;
+          }
+        } else {
+          isBelowFraction = false;
+        }
+      }
+    }
+
+    confidence = 0;
+    for (int i = 0; i < 4; i++) {
+      if (bitRead(reasons, i)) {
+        confidence += weights[i];
+      }
+    }
+  }
+  this->stopWristRotation();
+  this->unscrewConfidence = min(confidence, 100);
+  return reasons;
+}
+
+String CapperDecapper::getUnscrewReasons(byte reasons) {
+  static const char reasonNames[4][9] PROGMEM = {"RELEASE", "PRESSURE", "CURRENT", "TIME"};
+  String s = "";
+
+  for (int i = 0; i < 4; i++) {
+    if (bitRead(reasons, i)) {
+      if (s.length() > 0) {
+        s += ",";
+      }
+      s += String((const __FlashStringHelper *)reasonNames[i]);
+    }
+  }
+  return s;
+}
+
+bool CapperDecapper::closeContainer(int pThreshold, float iThreshold, int timeout) {
+  static const char reasonNames[4][8] PROGMEM = {"", "SLOPE", "PLATEAU", "LEVEL"};
+  unsigned long startTime = millis();
+  bool thresholdReached = false;
+  byte reason;
   
-  while (!isTimedOut(startTime, timeout) && pCurrent < pThreshold) {
-    pCurrent = this->readPressureSensor(64, true);
-    delay(10);
+  this->recorder.beginCycle(RECORDER_CYCLE_CLOSE, pThreshold, (int)iThreshold, timeout, 0);
+  this->recorder.setPhase(RECORDER_PHASE_WAIT_PRESSURE);
+  this->resetPressureEvents(pThreshold);
+  while (!isTimedOut(startTime, timeout) && !thresholdReached) {
+    this->updateSensors();
+    thresholdReached = this->hasPressureEvent(PRESSURE_EVENT_THRESHOLD_UP);
   }
 
-  if (pCurrent < pThreshold) {
+  if (!thresholdReached) {
     Serial.print("CAPPER>ERROR: TIMEOUT\n");
+    this->isThresholdArmed = false;
+    this->recorder.endCycle(false, TORQUE_NOT_SEATED, 0);
     return false;
   }
+  this->logPressureEvent(PRESSURE_EVENT_THRESHOLD_UP);
   Serial.print("CAPPER>OK: PRESSURE THRESHOLD REACHED\n");
   
-  this->turnWristClockwise();
-  delay(1000); // wait for 1 second before checking if the capping is done
-  
-  startTime = millis();
-  while (!isTimedOut(startTime, timeout) && abs(iCurrent) < abs(iThreshold)) {
-    iCurrent = this->readCurrentSensorDCMotor(2, true, false);
-    delay(10);
-  }
-  
-  if (abs(iCurrent) < abs(iThreshold)) {
+  this->recorder.setPhase(RECORDER_PHASE_TIGHTEN);
+  reason = this->tightenUntilSeated(iThreshold, timeout);
+  if (reason == TORQUE_NOT_SEATED) {
     Serial.print("CAPPER>ERROR: TIMEOUT\n");
   } else {
-    Serial.print("CAPPER>OK: CURRENT THRESHOLD REACHED\n");
+    Serial.print(F("CAPPER>OK: CAP SEATED ("));
+    Serial.print(String((const __FlashStringHelper *)reasonNames[reason]) + ") AT " + String(this->seatedCurrent) + " MA\n");
   }
   
+  this->recorder.setPhase(RECORDER_PHASE_CLAMP_OPEN);
   this->openClamp();
-  return (iCurrent > iThreshold);
+  this->isThresholdArmed = false;
+  this->recorder.endCycle(reason != TORQUE_NOT_SEATED, reason, (int)this->seatedCurrent);
+  return (reason != TORQUE_NOT_SEATED);
+}
+
+bool CapperDecapper::openContainerWithProfile(byte profileID) {
+  // Opens a container with the clamp width, thresholds, clamp speeds and timeout of the container profile <profileID>
+  ContainerProfile profile = this->getContainerProfile(profileID);
+  GripProfile gripProfile = this->gripProfile;
+  bool result;
+
+  this->gripProfile.fastStepTime = profile.fastStepTime;
+  this->gripProfile.fineStepTime = profile.fineStepTime;
+  result = this->openContainer(profile.clampPos, profile.openPressure, profile.openTimeout, profile.gripCurrent);
+  this->gripProfile = gripProfile;
+  return result;
+}
+
+bool CapperDecapper::closeContainerWithProfile(byte profileID) {
+  // Closes a container with the thresholds, clamp speed, final-torque phase and timeout of the container profile <profileID>
+  ContainerProfile profile = this->getContainerProfile(profileID);
+  GripProfile gripProfile = this->gripProfile;
+  int torqueTime = this->wristProfile.torqueTime;
+  bool result;
+
+  this->gripProfile.fastStepTime = profile.fastStepTime;
+  this->wristProfile.torqueTime = profile.torqueTime;
+  result = this->closeContainer(profile.closePressure, profile.seatLevel, profile.closeTimeout);
+  this->gripProfile = gripProfile;
+  this->wristProfile.torqueTime = torqueTime;
+  return result;
+}
+
+ContainerProfile CapperDecapper::getContainerProfile(byte profileID) {
+  // Reads the container profile <profileID> from the EEPROM. Profiles that were never written (or written with a different layout) return the defaults.
+  ContainerProfile profile;
+
+  if (profileID < CONTAINER_PROFILE_COUNT) {
+    EEPROM.get(CONTAINER_PROFILE_ADDRESS + profileID * sizeof(ContainerProfile), profile);
+    if (profile.version == CONTAINER_PROFILE_VERSION) {
+      return profile;
+    }
+  }
+  profile.version = 0;
+  profile.clampPos = 31;
+  profile.gripCurrent = 350.0;
+  profile.openPressure = 100;
+  profile.closePressure = 1000;
+  profile.seatLevel = this->torqueProfile.levelThreshold;
+  profile.fastStepTime = 15;
+  profile.fineStepTime = 25;
+  profile.openTimeout = 10000;
+  profile.closeTimeout = 10000;
+  profile.torqueTime = this->wristProfile.torqueTime;
+  return profile;
+}
+
+bool CapperDecapper::setContainerProfile(byte profileID, ContainerProfile profile) {
+  // EEPROM.put only writes the bytes that changed, so rewriting an unchanged profile does not wear the EEPROM
+  if (profileID >= CONTAINER_PROFILE_COUNT) {
+    return false;
+  }
+  profile.version = CONTAINER_PROFILE_VERSION;
+  profile.clampPos = constrain(profile.clampPos, this->servoClosedPosMillimeters, this->servoOpenedPosMillimeters);
+  EEPROM.put(CONTAINER_PROFILE_ADDRESS + profileID * sizeof(ContainerProfile), profile);
+  return true;
+}
+
+bool CapperDecapper::clearContainerProfile(byte profileID) {
+  if (profileID >= CONTAINER_PROFILE_COUNT) {
+    return false;
+  }
+  EEPROM.update(CONTAINER_PROFILE_ADDRESS + profileID * sizeof(ContainerProfile), 0xFF);  // invalidates the version
+  return true;
+}
+
+byte CapperDecapper::tightenUntilSeated(float levelThreshold, int timeout) {
+  // Turns the wrist clockwise until the cap is seated. Follows the filtered DC motor current after the inrush and stops the wrist as soon as
+  // the current rises steeply above the free-running current (slope), stays above it (plateau) or reaches the absolute level.
+  const byte historyLength = 8;  // the slope is calculated over the last 8 conversions (about 34 ms)
+  const float filterWeight = 0.25;
+  float history[historyLength];
+  unsigned long historyTime[historyLength];
+  byte historyIndex = 0;
+  byte historyCount = 0;
+  unsigned int readingCount = this->currentSensors.readingCount[0];
+  unsigned long startTime = millis();
+  unsigned long aboveRiseTime = 0;
+  bool isAboveRise = false;
+  float filtered = 0.0;
+  float baseline = 0.0;
+  float slope = 0.0;
+  byte reason = TORQUE_NOT_SEATED;
+
+  if (levelThreshold <= 0) {
+    levelThreshold = this->torqueProfile.levelThreshold;
+  }
+
+  this->turnWristClockwise();
+  while (!isTimedOut(startTime, timeout) && reason == TORQUE_NOT_SEATED) {
+    this->updatePressureSensor();
+    if (!this->currentSensors.update() || this->currentSensors.readingCount[0] == readingCount) {
+      continue;
+    }
+    readingCount = this->currentSensors.readingCount[0];
+
+    if (historyCount == 0) {
+      filtered = this->readWristMotorCurrent();
+    } else {
+      filtered += filterWeight * (this->readWristMotorCurrent() - filtered);
+    }
+    if (historyCount < historyLength) {
+      historyCount++;
+    } else {
+      slope = (filtered - history[historyIndex]) * 1000000.0 / (this->currentSensors.readingTime[0] - historyTime[historyIndex]);
+    }
+    history[historyIndex] = filtered;
+    historyTime[historyIndex] = this->currentSensors.readingTime[0];
+    historyIndex = (historyIndex + 1) % historyLength;
+
+    if (this->wristProfile.torqueTime > 0 && isTimedOut(startTime, this->wristProfile.torqueTime) && this->wristTargetDuty > this->wristProfile.torqueDuty) {
+      this->setWristSpeed(this->wristProfile.torqueDuty);  // slow final-torque phase, less energy in the rotor when the cap seats
+    }
+    if (isTimedOut(startTime, this->torqueProfile.inrushTime)) {
+      if (filtered >= levelThreshold) {
+        reason = TORQUE_SEATED_LEVEL;
+      } else if (filtered - baseline >= this->torqueProfile.riseThreshold) {
+        if (slope >= this->torqueProfile.slopeThreshold) {
+          reason = TORQUE_SEATED_SLOPE;
+        } else if (!isAboveRise) {
+          isAboveRise = true;
+          aboveRiseTime = millis();
+        } else if (isTimedOut(aboveRiseTime, this->torqueProfile.plateauTime)) {
+          reason = TORQUE_SEATED_PLATEAU;
+        }
+      } else {
+        isAboveRise = false;
+        baseline += (filtered - baseline) / 32;  // follow the free-running current slowly
+      }
+    } else {
+      baseline = filtered;
+    }
+  }
+  this->stopWristRotation();
+  this->seatedCurrent = filtered;
+  return reason;
 }
 
 void CapperDecapper::turnWristCounterClockwise() {
-  digitalWrite(this->dcMotorPin1, HIGH);
-  digitalWrite(this->dcMotorPin2, LOW);
+  this->turnWrist(WRIST_COUNTER_CLOCKWISE);
 }
 
 void CapperDecapper::turnWristClockwise() {
-  digitalWrite(this->dcMotorPin1, LOW);
-  digitalWrite(this->dcMotorPin2, HIGH);
+  this->turnWrist(WRIST_CLOCKWISE);
+}
+
+void CapperDecapper::turnWrist(byte direction) {
+  // Starts the wrist with a ramp from startDuty to cruiseDuty. The PWM is applied to the pin of the direction, the other pin stays LOW.
+  // If the wrist already turns in this direction, the ramp continues from the current duty.
+  byte pwmPin = (direction == WRIST_CLOCKWISE) ? this->dcMotorPin2 : this->dcMotorPin1;
+  byte lowPin = (direction == WRIST_CLOCKWISE) ? this->dcMotorPin1 : this->dcMotorPin2;
+
+  if (direction != this->wristDirection) {
+    eventTrace.add(TRACE_MOTION_START, TRACE_SOURCE_CAPPER, (direction == WRIST_CLOCKWISE) ? 1 : -1);
+    softPWMWrite(SOFT_PWM_CHANNEL_A, pwmPin, 0);
+    digitalWrite(lowPin, LOW);
+    this->isWristBraking = false;
+    this->wristDirection = direction;
+    this->wristDuty = this->wristProfile.startDuty;
+    softPWMWrite(SOFT_PWM_CHANNEL_A, pwmPin, this->wristDuty);
+  }
+  this->wristTargetDuty = this->wristProfile.cruiseDuty;
+  this->wristRampStartDuty = this->wristDuty;
+  this->wristRampStartTime = millis();
+}
+
+void CapperDecapper::setWristSpeed(byte duty) {
+  // The new duty is reached with the ramp rate of the wrist profile (also when slowing down, so the motor does not brake the wrist abruptly)
+  if (this->wristDirection == WRIST_STOPPED) {
+    return;
+  }
+  this->wristTargetDuty = duty;
+  this->wristRampStartDuty = this->wristDuty;
+  this->wristRampStartTime = millis();
+  this->updateWrist();
 }
 
 void CapperDecapper::stopWristRotation() {
-  digitalWrite(this->dcMotorPin1, LOW);
-  digitalWrite(this->dcMotorPin2, LOW);
+  // Active braking: both motor pins are driven HIGH for brakeTime (released by updateWrist) instead of letting the wrist coast
+  softPWMWrite(SOFT_PWM_CHANNEL_A, this->dcMotorPin1, 0);
+  if (this->wristDirection != WRIST_STOPPED) {
+    eventTrace.add(TRACE_MOTION_STOP, TRACE_SOURCE_CAPPER, 0);
+  }
+  if (this->wristDirection != WRIST_STOPPED && this->wristProfile.brakeTime > 0) {
+    digitalWrite(this->dcMotorPin1, HIGH);
+    digitalWrite(this->dcMotorPin2, HIGH);
+    this->isWristBraking = true;
+    this->wristRampStartTime = millis();
+  } else {
+    digitalWrite(this->dcMotorPin2, LOW);
+    this->isWristBraking = false;
+  }
+  this->wristDirection = WRIST_STOPPED;
+  this->wristDuty = 0;
+  this->wristTargetDuty = 0;
+}
+
+void CapperDecapper::updateWrist() {
+  // Ramps the PWM duty of the wrist and releases the brake, should be called as often as possible
+  byte pwmPin = (this->wristDirection == WRIST_CLOCKWISE) ? this->dcMotorPin2 : this->dcMotorPin1;
+  long duty;
+
+  if (this->isWristBraking) {
+    if (isTimedOut(this->wristRampStartTime, this->wristProfile.brakeTime)) {
+      digitalWrite(this->dcMotorPin1, LOW);
+      digitalWrite(this->dcMotorPin2, LOW);
+      this->isWristBraking = false;
+    }
+    return;
+  }
+  if (this->wristDirection == WRIST_STOPPED || this->wristDuty == this->wristTargetDuty) {
+    return;
+  }
+
+  duty = (long)max(this->wristProfile.cruiseDuty - this->wristProfile.startDuty, 1) * (millis() - this->wristRampStartTime) / max(this->wristProfile.rampTime, 1);
+  if (this->wristTargetDuty < this->wristDuty) {
+    duty = max(this->wristRampStartDuty - duty, (long)this->wristTargetDuty);
+  } else {
+    duty = min(this->wristRampStartDuty + duty, (long)this->wristTargetDuty);
+  }
+  if (duty != this->wristDuty) {
+    this->wristDuty = duty;
+    softPWMWrite(SOFT_PWM_CHANNEL_A, pwmPin, this->wristDuty);
+  }
+}
+
+float CapperDecapper::readWristMotorCurrent() {
+  // The supply current of the H-bridge is about the motor current times the PWM duty. Scaling it back keeps the thresholds of the detectors
+  // independent of the wrist speed.
+  float current = abs(this->currentSensors.current_mA[0]);
+
+  if (this->wristDuty > 0) {
+    current = current * 255.0 / this->wristDuty;
+  }
+  return current;
 }
 
 void CapperDecapper::setClampPosition(int clampPosition) {
@@ -148,166 +720,390 @@ void CapperDecapper::setClampPosition(int clampPosition) {
   this->currentPos = clampPosition;
 }
 
-void CapperDecapper::openClamp(float currentThreshold=1000.0, bool logResults=false) {
+void CapperDecapper::openClamp(float currentThreshold, bool logResults) {
+  // Opens the clamp in 1 mm steps every fastStepTime ms (the servo current is read in the background instead of after every step), until the
+  // open position is reached or the current stays above currentThreshold for 3 consecutive readings.
+  unsigned int readingCount = this->currentSensors.readingCount[1];
+  unsigned long stepTime = millis() - this->gripProfile.fastStepTime;
+  byte aboveThresholdCounter = 0;
   float iCurrent;
-  byte aboveThresholdCounter = 0; 
 
-  iCurrent = this->readCurrentSensorServoMotor(8, false, false);
-  if (abs(iCurrent) > abs(currentThreshold)) {
-    aboveThresholdCounter++;
+  while ((this->currentPos < this->servoOpenedPosMillimeters) && (aboveThresholdCounter < 3)) {
+    this->updateSensors();
+    if (this->currentSensors.readingCount[1] != readingCount) {
+      readingCount = this->currentSensors.readingCount[1];
+      iCurrent = this->currentSensors.current_mA[1];
+      if (abs(iCurrent) > abs(currentThreshold)) {
+        aboveThresholdCounter++;
+      } else {
+        aboveThresholdCounter = 0;
+      }
+      if (logResults) {
+        Serial.print(F("CAPPER>"));
+        Serial.println(String(iCurrent));
+      }
+    }
+    if (isTimedOut(stepTime, this->gripProfile.fastStepTime)) {
+      stepTime = millis();
+      this->currentPos += 1;
+      this->writeClampServo(this->currentPos);
+    }
   }
-  if (logResults) {
-    Serial.println("CAPPER>" + String(iCurrent));
+}
+
+bool CapperDecapper::closeClamp(float currentThreshold, bool logResults, int minPos, bool unscrewOnContact) {
+  // Force-controlled closing: moves in 1 mm steps while the servo current stays at its free-moving level, switches to 1 degree steps as soon as
+  // the current rises (contact, the position is stored as the measured diameter) and then regulates the position until the current stays within
+  // holdBand of currentThreshold for settleTime ms. The clamp never closes further than minPos (in mm). With unscrewOnContact, the wrist already
+  // starts turning counter-clockwise at contact, so the breakaway of the cap overlaps with the regulation of the grip.
+  // Returns false if there was no contact (errors = 3) or the servo current sensor delivered no readings (errors = 1, the clamp is not moved).
+  const float filterWeight = 0.5;
+  const int readingTimeout = 100;  // in ms, the INA219 delivers a new conversion every few ms
+  float fineStep = 1.0 / abs(this->degreesPerMillimeter);  // one degree in mm
+  float position = this->currentPos;
+  float filtered = 0.0;
+  float baseline = 0.0;
+  unsigned int readingCount = this->currentSensors.readingCount[1];
+  unsigned long startTime = millis();
+  unsigned long stepTime = millis();
+  unsigned long inBandTime = 0;
+  bool isInBand = false;
+  bool hasContact = false;
+  bool hasReading = false;
+  byte aboveCount = 0;
+  float iCurrent;
+
+  currentThreshold = abs(currentThreshold);
+  if (minPos < this->servoClosedPosMillimeters) {
+    minPos = this->servoClosedPosMillimeters;
   }
+  this->clampDiameter = 0.0;
 
-  while ((this->currentPos < this->servoOpenedPosMillimeters) && (aboveThresholdCounter < 1)) {
-    this->currentPos += 1;
-    this->clampServo.write(((this->currentPos - this->servoClosedPosMillimeters)*this->degreesPerMillimeter + this->servoClosedPosDegrees));
-    iCurrent = this->readCurrentSensorServoMotor(8, false, false);
-    if (abs(iCurrent) > abs(currentThreshold)) {
-      aboveThresholdCounter++;
-    } else {
-      aboveThresholdCounter = 0;
+  while (!isTimedOut(startTime, this->gripProfile.timeout)) {
+    this->updateSensors();
+    if (this->currentSensors.readingCount[1] != readingCount) {
+      readingCount = this->currentSensors.readingCount[1];
+      iCurrent = abs(this->currentSensors.current_mA[1]);
+      if (!hasReading) {
+        filtered = iCurrent;
+        baseline = iCurrent;
+        hasReading = true;
+      } else {
+        filtered += filterWeight * (iCurrent - filtered);
+      }
+      if (logResults) {
+        Serial.print(F("CAPPER>"));
+        Serial.println(String(iCurrent));
+      }
+      if (!hasContact) {
+        if (iCurrent - baseline > this->gripProfile.contactDelta || iCurrent >= currentThreshold * (1 - this->gripProfile.holdBand)) {
+          aboveCount++;  // short spikes while the servo moves to the next step are ignored
+        } else {
+          aboveCount = 0;
+          baseline += (iCurrent - baseline) / 8;
+        }
+        if (aboveCount >= 3) {
+          hasContact = true;
+          this->clampDiameter = position;
+          if (unscrewOnContact) {
+            this->turnWristCounterClockwise();
+            this->setWristSpeed(this->wristProfile.torqueDuty);  // spin up slowly while the clamp builds up the holding force
+          }
+        }
+      }
     }
-    if (logResults) {
-      Serial.println("CAPPER>" + String(iCurrent));
+    if (!hasReading) {
+      if (isTimedOut(startTime, readingTimeout)) {
+        break;
+      }
+      continue;
+    }
+
+    if (!hasContact) {
+      if (position <= minPos) {
+        break;
+      }
+      if (isTimedOut(stepTime, this->gripProfile.fastStepTime)) {
+        stepTime = millis();
+        position = max(position - 1.0, (float)minPos);
+        this->writeClampServo(position);
+      }
+      continue;
+    }
+
+    if (filtered > currentThreshold * (1 + this->gripProfile.holdBand)) {
+      isInBand = false;
+      if (isTimedOut(stepTime, this->gripProfile.fineStepTime)) {
+        stepTime = millis();
+        position = min(position + fineStep, (float)this->servoOpenedPosMillimeters);
+        this->writeClampServo(position);
+      }
+    } else if (filtered < currentThreshold * (1 - this->gripProfile.holdBand)) {
+      isInBand = false;
+      if (position - fineStep < minPos) {
+        break;
+      }
+      if (isTimedOut(stepTime, this->gripProfile.fineStepTime)) {
+        stepTime = millis();
+        position -= fineStep;
+        this->writeClampServo(position);
+      }
+    } else if (!isInBand) {
+      isInBand = true;
+      inBandTime = millis();
+    } else if (isTimedOut(inBandTime, this->gripProfile.settleTime)) {
+      break;
     }
   }
+  this->currentPos = (int)(position + 0.5);
+  if (!hasReading) {
+    this->errors = 1;
+    return false;
+  }
+  if (!hasContact) {
+    this->errors = 3;
+    return false;
+  }
+  this->errors = 0;
+  return true;
 }
 
-void CapperDecapper::closeClamp(float currentThreshold=350.0, bool logResults=false) {
-  float iCurrent;
-  byte aboveThresholdCounter = 0; 
+void CapperDecapper::writeClampServo(float positionMillimeters) {
+  this->clampServo.write((int)((positionMillimeters - this->servoClosedPosMillimeters) * this->degreesPerMillimeter + this->servoClosedPosDegrees + 0.5));
+}
 
-  iCurrent = this->readCurrentSensorServoMotor(8, false, false);
-  if (abs(iCurrent) > abs(currentThreshold)) {
-    aboveThresholdCounter++;
+void CapperDecapper::benchmark(String prefix) {
+  // Timing of the capper hardware for the "bench" command: duration of the I2C register reads and conversion interval of the INA219 current sensors
+  // (measured with the background reader for 200 ms), and the latency of Servo.write() (the servo is written with its current position)
+  const int duration = 200;  // in ms
+  unsigned long startTime = millis();
+  unsigned long minTransferTime = 0xFFFFFFFF;
+  unsigned long maxTransferTime = 0;
+  unsigned long totalTransferTime = 0;
+  unsigned int transfers = 0;
+  unsigned int transferCount = this->currentSensors.transferCount;
+  unsigned int busErrors = this->currentSensors.busErrors;
+  unsigned int firstReadingCount[2];
+  unsigned long firstReadingTime[2];
+  unsigned long servoStartTime;
+  float servoTime;
+
+  for (int i = 0; i < 2; i++) {
+    this->currentSensors.waitForNewReading(i);
+    firstReadingCount[i] = this->currentSensors.readingCount[i];
+    firstReadingTime[i] = this->currentSensors.readingTime[i];
   }
-  if (logResults) {
-    Serial.println("CAPPER>" + String(iCurrent));
+  while (!isTimedOut(startTime, duration)) {
+    this->currentSensors.update();
+    if (this->currentSensors.transferCount != transferCount) {
+      transferCount = this->currentSensors.transferCount;
+      minTransferTime = min(minTransferTime, this->currentSensors.transferTime);
+      maxTransferTime = max(maxTransferTime, this->currentSensors.transferTime);
+      totalTransferTime += this->currentSensors.transferTime;
+      transfers++;
+    }
+  }
+  Serial.print(prefix + ">I2C " + String(transfers) + ";" + String((transfers > 0) ? minTransferTime : 0) + ";" + String((transfers > 0) ? totalTransferTime / transfers : 0) + ";" + String(maxTransferTime) + ";" + String(this->currentSensors.busErrors - busErrors) + "\n");
+  for (int i = 0; i < 2; i++) {
+    unsigned int readings = this->currentSensors.readingCount[i] - firstReadingCount[i];
+    Serial.print(prefix + ">INA219 " + String(i) + " " + String(readings) + ";" + String((readings > 0) ? (this->currentSensors.readingTime[i] - firstReadingTime[i]) / readings : 0) + "\n");
   }
 
-  while ((this->currentPos > this->servoClosedPosMillimeters) && (aboveThresholdCounter < 1)) {
-    this->currentPos -= 1;
-    this->clampServo.write(((this->currentPos - this->servoClosedPosMillimeters)*this->degreesPerMillimeter + this->servoClosedPosDegrees));
-    iCurrent = this->readCurrentSensorServoMotor(8, false, false);;
-    if (abs(iCurrent) > abs(currentThreshold)) {
-      aboveThresholdCounter++;
-    } else {
-      aboveThresholdCounter = 0;
-    }
-    if (logResults) {
-      Serial.println("CAPPER>" + String(iCurrent));
-    }
+  servoStartTime = micros();
+  for (int i = 0; i < BENCH_REPETITIONS; i++) {
+    this->writeClampServo(this->currentPos);
   }
+  servoTime = (float)(micros() - servoStartTime) / BENCH_REPETITIONS;
+  Serial.print(prefix + ">SERVO " + String(servoTime) + "\n");
 }
 
-int CapperDecapper::readPressureSensor(byte averages=16, bool logResults=true) {
-  long pressureSensorSignal=0;
-  analogRead(pressureSensorPin); // Discard first reading after switching analog input pins
-  delay(25);
+int CapperDecapper::readPressureSensor(byte averages, bool logResults) {
+  const byte oversampling = 16;  // ADC samples per value of the background sampling
+  float pressureSensorSignal = 0.0;
+  byte values = max(1, averages / oversampling);
 
-  for (int i = 0; i < averages; i++) {  // Average a few readings to reduce noise
-    pressureSensorSignal += analogRead(pressureSensorPin);
-    delayMicroseconds(100);
+  for (int i = 0; i < values; i++) {  // Wait for the next value(s) of the background sampling instead of taking extra readings
+    while (!this->updatePressureSensor()) {
+    }
+    pressureSensorSignal += this->pressure;
   }
-  pressureSensorSignal /= averages;
+  pressureSensorSignal /= values;
   if (logResults) {
-    Serial.print("CAPPER>" + String(pressureSensorSignal));
+    Serial.print(F("CAPPER>"));
+    Serial.print(String((int)(pressureSensorSignal + 0.5)));
     Serial.print("\n");
   }
-  return pressureSensorSignal;
+  return (int)(pressureSensorSignal + 0.5);
 }
 
-float CapperDecapper::readCurrentSensorDCMotor(byte averages=8, bool logResults=true, bool logAll=false) {
-  float val = 0.0;
-  float current_mA = 0.0;
-  float shuntVoltage_mV = 0.0;
-  float loadVoltage_V = 0.0;
-  float busVoltage_V = 0.0;
-  float power_mW = 0.0; 
-  bool ina219_overflow = false;
-  
-  this->currentSensorDCMotor.startSingleMeasurement();  // Discard first measurement
-  delayMicroseconds(100);
-  
-  for (int i = 0; i < averages; i++) {  // Average a few readings to reduce noise
-    this->currentSensorDCMotor.startSingleMeasurement();
-    val += this->currentSensorDCMotor.getCurrent_mA();
-
-    if (logResults && logAll) {
-      shuntVoltage_mV += this->currentSensorDCMotor.getShuntVoltage_mV();
-      busVoltage_V += this->currentSensorDCMotor.getBusVoltage_V();
-      power_mW += this->currentSensorDCMotor.getBusPower();
-      loadVoltage_V += busVoltage_V + (shuntVoltage_mV/1000);
-      ina219_overflow &= this->currentSensorDCMotor.getOverflow();
+bool CapperDecapper::updatePressureSensor() {
+  // Background sampling of the pressure sensor, should be called as often as possible. Takes at most one ADC sample every samplePeriod us and
+  // sums up 16 samples to one oversampled value with 2 bits of extra resolution. Returns true if a new value is available.
+  const unsigned long samplePeriod = 250;  // in us, gives a new pressure value about every 4 ms
+  const byte oversampling = 16;  // 4^n samples for n extra bits of resolution
+  const unsigned long maxGap = 50000;  // in us, discard the partial sum and the slope history if sampling was interrupted for longer than this
+  unsigned long now = micros();
+
+  this->updateStream();  // all sampling loops of the capper end up here, so the stream and the wrist ramp are also serviced while a capper command is running
+  this->updateWrist();
+
+  if (now - this->lastPressureSampleTime < samplePeriod) {
+    return false;
+  }
+  if (now - this->lastPressureSampleTime > maxGap) {
+    this->pressureSampleSum = 0;
+    this->pressureSampleCount = 0;
+    this->pressureHistoryCount = 0;
+  }
+  if (now - this->lastPressureSampleTime > 4 * samplePeriod) {
+    analogRead(this->pressureSensorPin); // Discard first reading, another analog input might have been read in the meantime
+  }
+  this->lastPressureSampleTime = now;
+  this->pressureSampleSum += analogRead(this->pressureSensorPin);
+  this->pressureSampleCount++;
+  if (this->pressureSampleCount < oversampling) {
+    return false;
+  }
+
+  this->pressure = (this->pressureSampleSum >> 2) / 4.0;  // 12 bit value, scaled to the 10 bit range of analogRead
+  this->pressureTime = now;
+  this->pressureSampleSum = 0;
+  this->pressureSampleCount = 0;
+  this->detectPressureEvents();
+  this->recorder.addSample((int)(this->pressure * 4), (int)(this->currentSensors.current_mA[0] * 10));
+  return true;
+}
+
+void CapperDecapper::detectPressureEvents() {
+  const byte historyLength = 8;  // the slope is calculated over the last 8 values (about 32 ms)
+  float oldestPressure = this->pressureHistory[this->pressureHistoryIndex] / 4.0;
+  byte event = PRESSURE_EVENT_COUNT;
+
+  this->pressureHistory[this->pressureHistoryIndex] = (int)(this->pressure * 4);
+  this->pressureHistoryIndex = (this->pressureHistoryIndex + 1) % historyLength;
+  if (this->pressureHistoryCount < historyLength) {
+    if (this->pressureHistoryCount == 0 && !this->isInContact) {
+      this->pressureBaseline = this->pressure;
     }
-    
-    delayMicroseconds(100);
+    this->pressureHistoryCount++;
+    this->pressureSlope = 0.0;
+  } else {
+    this->pressureSlope = this->pressure - oldestPressure;
   }
-  
-  val /= averages;
-  shuntVoltage_mV /= averages;
-  busVoltage_V /= averages;
-  power_mW /= averages;
-  loadVoltage_V /= averages;
 
-  if (logResults && !logAll) {
-    Serial.print("CAPPER>" + String(val));
-    Serial.print("\n");
-  } else if (logResults && logAll) {
-    Serial.print("CAPPER>Current[mA]: " + String(val));
-    Serial.print("\n");
-    Serial.print("CAPPER>Shunt Voltage [mV]: " + String(shuntVoltage_mV));
-    Serial.print("\n");
-    Serial.print("CAPPER>Bus Voltage [V]: " + String(busVoltage_V));
-    Serial.print("\n");
-    Serial.print("CAPPER>Load Voltage [V]: " + String(loadVoltage_V));
-    Serial.print("\n");
-    Serial.print("CAPPER>Bus Power [mW]: " + String(power_mW));
-    Serial.print("\n");
-    if(!ina219_overflow){
-      Serial.print("CAPPER>No overflow: OK");
+  // Contact: fast rise above the baseline, the baseline follows slow drifts while there is no contact
+  if (!this->isInContact) {
+    if (this->pressure - this->pressureBaseline > this->contactDelta && this->pressureSlope > this->contactSlope) {
+      this->isInContact = true;
+      event = PRESSURE_EVENT_CONTACT;
     } else {
-      Serial.print("CAPPER>Overflow: Lower Gain");
+      this->pressureBaseline += (this->pressure - this->pressureBaseline) / 16;
     }
-    Serial.print("\n");
+  } else if (this->pressure - this->pressureBaseline < this->contactDelta / 2) {
+    this->isInContact = false;
+  }
+  if (event < PRESSURE_EVENT_COUNT) {
+    bitSet(this->pressureEvents, event);
+    this->pressureEventTime[event] = this->pressureTime;
+    this->pressureEventValue[event] = this->pressure;
+    eventTrace.add(TRACE_CONTACT + event, TRACE_SOURCE_CAPPER, (int)this->pressure, this->pressureTime);
+  }
+
+  // Threshold crossings with hysteresis
+  event = PRESSURE_EVENT_COUNT;
+  if (!this->isAboveThreshold && this->pressure > this->pressureThreshold + this->pressureHysteresis) {
+    this->isAboveThreshold = true;
+    event = PRESSURE_EVENT_THRESHOLD_UP;
+  } else if (this->isAboveThreshold && this->pressure < this->pressureThreshold - this->pressureHysteresis) {
+    this->isAboveThreshold = false;
+    event = PRESSURE_EVENT_THRESHOLD_DOWN;
+  }
+  if (event < PRESSURE_EVENT_COUNT) {
+    bitSet(this->pressureEvents, event);
+    this->pressureEventTime[event] = this->pressureTime;
+    this->pressureEventValue[event] = this->pressure;
+    eventTrace.add(TRACE_CONTACT + event, TRACE_SOURCE_CAPPER, (int)this->pressure, this->pressureTime);
+  }
+
+  // Release: sudden pressure drop, re-armed once the pressure is stable again
+  if (this->isReleaseArmed && -this->pressureSlope > this->releaseDelta) {
+    this->isReleaseArmed = false;
+    bitSet(this->pressureEvents, PRESSURE_EVENT_RELEASE);
+    this->pressureEventTime[PRESSURE_EVENT_RELEASE] = this->pressureTime;
+    this->pressureEventValue[PRESSURE_EVENT_RELEASE] = this->pressure;
+    eventTrace.add(TRACE_RELEASE, TRACE_SOURCE_CAPPER, (int)this->pressure, this->pressureTime);
+  } else if (!this->isReleaseArmed && -this->pressureSlope < this->releaseDelta / 2) {
+    this->isReleaseArmed = true;
   }
-  return val;
 }
 
-float CapperDecapper::readCurrentSensorServoMotor(byte averages=8, bool logResults=true, bool logAll=false) {
+void CapperDecapper::resetPressureEvents(int pThreshold) {
+  // Clears all pending events and sets a new threshold. A pressure that is already above the threshold triggers a new PRESSURE_EVENT_THRESHOLD_UP.
+  this->pressureThreshold = pThreshold;
+  this->isThresholdArmed = true;
+  this->isAboveThreshold = false;
+  this->pressureEvents = 0;
+}
+
+bool CapperDecapper::hasPressureEvent(byte event) {
+  // Returns true (and clears the event) if the event occured since the last call
+  if (bitRead(this->pressureEvents, event)) {
+    bitClear(this->pressureEvents, event);
+    return true;
+  }
+  return false;
+}
+
+void CapperDecapper::logPressureEvent(byte event) {
+  static const char eventNames[PRESSURE_EVENT_COUNT][15] PROGMEM = {"CONTACT", "THRESHOLD UP", "THRESHOLD DOWN", "RELEASE"};
+
+  Serial.print(F("CAPPER>"));
+  Serial.print(String((const __FlashStringHelper *)eventNames[event]) + " AT " + String(this->pressureEventTime[event]) + " US: " + String(this->pressureEventValue[event]));
+  Serial.print("\n");
+}
+
+float CapperDecapper::readCurrentSensorDCMotor(byte averages, bool logResults, bool logAll) {
+  return this->readCurrentSensor(0, averages, logResults, logAll);
+}
+
+float CapperDecapper::readCurrentSensorServoMotor(byte averages, bool logResults, bool logAll) {
+  return this->readCurrentSensor(1, averages, logResults, logAll);
+}
+
+float CapperDecapper::getLatestCurrent(byte sensor) {
+  // Latest conversion of the sensor (0: DC motor, 1: servo motor) that was fetched in the background, in mA. Does not wait for a new reading.
+  return this->currentSensors.current_mA[sensor];
+}
+
+float CapperDecapper::readCurrentSensor(byte sensor, byte averages, bool logResults, bool logAll) {
+  // Averages the next <averages> conversions of the sensor (0: DC motor, 1: servo motor) that are fetched in the background
   float val = 0.0;
-  float current_mA = 0.0;
   float shuntVoltage_mV = 0.0;
-  float loadVoltage_V = 0.0;
   float busVoltage_V = 0.0;
   float power_mW = 0.0; 
   bool ina219_overflow = false;
-  
-  this->currentSensorServoMotor.startSingleMeasurement();  // Discard first measurement
-  delayMicroseconds(100);
+  byte readings = 0;
   
   for (int i = 0; i < averages; i++) {  // Average a few readings to reduce noise
-    this->currentSensorServoMotor.startSingleMeasurement();
-    val += this->currentSensorServoMotor.getCurrent_mA();
-
-    if (logResults && logAll) {
-      shuntVoltage_mV += this->currentSensorServoMotor.getShuntVoltage_mV();
-      busVoltage_V += this->currentSensorServoMotor.getBusVoltage_V();
-      power_mW += this->currentSensorServoMotor.getBusPower();
-      loadVoltage_V += busVoltage_V + (shuntVoltage_mV/1000);
-      ina219_overflow &= this->currentSensorServoMotor.getOverflow();
+    if (!this->currentSensors.waitForNewReading(sensor)) {
+      this->errors = 1;
+      break;
     }
-    
-    delayMicroseconds(100);
+    this->updatePressureSensor();
+    val += this->currentSensors.current_mA[sensor];
+    shuntVoltage_mV += this->currentSensors.shuntVoltage_mV[sensor];
+    busVoltage_V += this->currentSensors.busVoltage_V[sensor];
+    power_mW += this->currentSensors.power_mW[sensor];
+    ina219_overflow |= this->currentSensors.overflow[sensor];
+    readings++;
   }
   
-  val /= averages;
-  shuntVoltage_mV /= averages;
-  busVoltage_V /= averages;
-  power_mW /= averages;
-  loadVoltage_V /= averages;
+  if (readings > 0) {
+    val /= readings;
+    shuntVoltage_mV /= readings;
+    busVoltage_V /= readings;
+    power_mW /= readings;
+  }
 
   if (logResults && !logAll) {
     Serial.print("CAPPER>" + String(val));
@@ -319,7 +1115,8 @@ float CapperDecapper::readCurrentSensorServoMotor(byte averages=8, bool logResul
     Serial.print("\n");
     Serial.print("CAPPER>Bus Voltage [V]: " + String(busVoltage_V));
     Serial.print("\n");
-    Serial.print("CAPPER>Load Voltage [V]: " + String(loadVoltage_V));
+    Serial.print(F("CAPPER>Load Voltage [V]: "));
+    Serial.print(String(busVoltage_V + (shuntVoltage_mV/1000)));
     Serial.print("\n");
     Serial.print("CAPPER>Bus Power [mW]: " + String(power_mW));
     Serial.print("\n");
@@ -333,7 +1130,13 @@ float CapperDecapper::readCurrentSensorServoMotor(byte averages=8, bool logResul
   return val;
 }
 
-void CapperDecapper::logSensorSignals(unsigned long timeout=5000, bool logResults=true) {
+void CapperDecapper::updateSensors() {
+  // Keeps the background sampling of all capper sensors going, should be called as often as possible
+  this->updatePressureSensor();
+  this->currentSensors.update();
+}
+
+void CapperDecapper::logSensorSignals(unsigned long timeout, bool logResults) {
   float pressureSensorSignal=0.0;
   float currentSensorDCMotorSignal=0.0;
   float currentSensorServoMotorSignal=0.0;
@@ -366,7 +1169,7 @@ bool CapperDecapper::initializeCurrentSensor(INA219_WE *currentSensor) {
     return false;
   }
   currentSensor->setADCMode(SAMPLE_MODE_4); // Set ADC Mode for Bus and ShuntVoltage (BIT_MODE_12 is default (available: 9, 10, 11, 12), SAMPLE_MODE_32 means averaging 32 samples which takes 17.02 ms (available: 2, 4, 8, 16, 32, 64, 128))
-  currentSensor->setMeasureMode(TRIGGERED); // Set measure mode (available: POWER_DOWN, TRIGGERED, ADC_OFF, CONTINUOUS)
+  currentSensor->setMeasureMode(CONTINUOUS); // Set measure mode (available: POWER_DOWN, TRIGGERED, ADC_OFF, CONTINUOUS), the results are fetched in the background by AsyncCurrentSensors
   currentSensor->setPGain(PG_160); // Gain setting (available: PG_40 (40mV, 0.4A), PG_80 (80mV, 0.8A), PG_160 (160mV, 1.6A), PG_320 (320mV, 3.2A))
   currentSensor->setBusRange(BRNG_32); // Set Bus Voltage Range (available: BRNG_16 -> 16 V, BRNG_32 -> 32 V (DEFAULT))
   // currentSensor->setCorrectionFactor(0.98); // insert correction factor if necessary
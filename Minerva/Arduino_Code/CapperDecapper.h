@@ -11,29 +11,169 @@
 #include <Servo.h>
 #include <Wire.h>
 #include <INA219_WE.h>
+#include <EEPROM.h>
 #include <Arduino.h>
 #include "HelperFunctions.h"
+#include "AsyncCurrentSensors.h"
+#include "FlightRecorder.h"
+#include "SoftPWM.h"
+
+// Events detected by the background sampling of the pressure sensor
+const byte PRESSURE_EVENT_CONTACT = 0;  // pressure rises quickly above the baseline (cap touches the gripper)
+const byte PRESSURE_EVENT_THRESHOLD_UP = 1;  // pressure rises above the threshold (plus hysteresis)
+const byte PRESSURE_EVENT_THRESHOLD_DOWN = 2;  // pressure falls below the threshold (minus hysteresis)
+const byte PRESSURE_EVENT_RELEASE = 3;  // sudden pressure drop (cap is released from the thread)
+const byte PRESSURE_EVENT_COUNT = 4;
+
+// Reasons reported by the end-of-capping (torque) detector
+const byte TORQUE_NOT_SEATED = 0;  // timeout
+const byte TORQUE_SEATED_SLOPE = 1;  // fast current rise above the free-running current
+const byte TORQUE_SEATED_PLATEAU = 2;  // current stays above the free-running current for plateauTime
+const byte TORQUE_SEATED_LEVEL = 3;  // current exceeds the absolute level
+
+// Signals that indicate that the cap is free when unscrewing (bit mask)
+const byte UNSCREW_PRESSURE_RELEASE = 0x01;  // sudden pressure drop when the cap jumps out of the thread
+const byte UNSCREW_PRESSURE_BELOW = 0x02;  // pressure below the threshold
+const byte UNSCREW_CURRENT_FREE = 0x04;  // wrist current dropped from the breakaway peak to the free-running current
+const byte UNSCREW_MIN_TIME = 0x08;  // wrist turned for at least the minimum rotation time
+
+// Channels of the binary sensor stream (bit mask), every channel adds one int16 to a record
+const byte STREAM_PRESSURE = 0x01;  // oversampled pressure, 12 bit (0-4092)
+const byte STREAM_DC_CURRENT = 0x02;  // wrist motor current in 0.1 mA
+const byte STREAM_SERVO_CURRENT = 0x04;  // servo current in 0.1 mA
+const byte STREAM_BUS_VOLTAGE = 0x08;  // bus voltage of the wrist motor in mV
+const byte STREAM_CHANNEL_COUNT = 4;
+const byte STREAM_SYNC = 0xA5;  // first byte of every record
+
+// Tunables of the end-of-capping detector (can be different for each container type)
+struct TorqueProfile {
+  int inrushTime;  // in ms, the motor current is ignored during start-up
+  float levelThreshold;  // in mA, absolute current that always ends the capping
+  float riseThreshold;  // in mA above the free-running current while the cap is screwed on
+  float slopeThreshold;  // in mA/s of the filtered current
+  int plateauTime;  // in ms
+};
+
+// Tunables of the uncapping completion detector
+struct UnscrewProfile {
+  int inrushTime;  // in ms, the motor current is ignored during start-up
+  int minRotationTime;  // in ms
+  float currentDropFraction;  // the wrist current is considered free-running below this fraction of its peak
+  int currentStableTime;  // in ms the current has to stay below the fraction
+  byte minConfidence;  // in percent
+};
+
+// Tunables of the force-controlled gripper
+struct GripProfile {
+  int fastStepTime;  // in ms per mm while the clamp moves freely
+  int fineStepTime;  // in ms per degree after contact
+  float contactDelta;  // in mA above the free-moving servo current
+  float holdBand;  // fraction of the holding current that is accepted
+  int settleTime;  // in ms the current has to stay within the band
+  int timeout;  // in ms
+};
+
+// Directions of the wrist
+const byte WRIST_STOPPED = 0;
+const byte WRIST_CLOCKWISE = 1;
+const byte WRIST_COUNTER_CLOCKWISE = 2;
+
+// Tunables of the PWM drive of the wrist
+struct WristProfile {
+  byte startDuty;  // PWM duty (0-255) at the start of the ramp
+  byte cruiseDuty;  // PWM duty at the end of the ramp
+  int rampTime;  // in ms from startDuty to cruiseDuty
+  byte torqueDuty;  // PWM duty of the slow final-torque phase when tightening, and while the clamp closes when gripping and unscrewing
+  int torqueTime;  // in ms after the start of tightening at which the slow final-torque phase begins (0: no slow phase)
+  int brakeTime;  // in ms both motor pins are driven HIGH after stopping
+};
+
+// Table of container profiles in the EEPROM
+const byte CONTAINER_PROFILE_COUNT = 8;
+const int CONTAINER_PROFILE_ADDRESS = 0;  // EEPROM address of the first profile
+const byte CONTAINER_PROFILE_VERSION = 2;  // marks a written profile, change when the layout of ContainerProfile changes
+
+// Capping parameters of one container type (e.g. 15 mL tube, 50 mL tube, vial), stored in the EEPROM and selected by a small ID
+struct ContainerProfile {
+  byte version;  // CONTAINER_PROFILE_VERSION if the profile was written, otherwise the defaults are used
+  byte clampPos;  // in mm, the clamp does not close further than this when opening a container
+  float gripCurrent;  // in mA, holding current of the clamp
+  int openPressure;  // pressure threshold for opening
+  int closePressure;  // pressure threshold for closing
+  float seatLevel;  // in mA, current level that ends the capping
+  int fastStepTime;  // in ms per mm while the clamp moves freely
+  int fineStepTime;  // in ms per degree after contact
+  int openTimeout;  // in ms
+  int closeTimeout;  // in ms
+  int torqueTime;  // in ms after the start of tightening at which the wrist slows down to the final-torque duty (0: no slow phase)
+};
+
 class CapperDecapper {
 public:
   CapperDecapper(void);
   CapperDecapper(byte dcMotorPin1, byte dcMotorPin2, byte servoPin, int pressureSensorPin, int currentSensorDCMotorAddress=0x40, int currentSensorServoMotorAddress=0x41, int servoClosedPosDegrees=0, int servoOpenedPosDegrees=180, int servoClosedPosMillimeters = 4, int servoOpenedPosMillimeters=59);
   int readPressureSensor(byte averages=16, bool logResults=true);
+  bool updatePressureSensor(void);
+  void resetPressureEvents(int pThreshold);
+  bool hasPressureEvent(byte event);
+  void updateSensors(void);
+  byte tightenUntilSeated(float levelThreshold=-1, int timeout=10000);
+  byte unscrewUntilFree(int timeout=10000);
+  String getUnscrewReasons(byte reasons);
   float readCurrentSensorDCMotor(byte averages=8, bool logResults=true, bool logAll=false);
   float readCurrentSensorServoMotor(byte averages=8, bool logResults=true, bool logAll=false);
+  float getLatestCurrent(byte sensor);
   void logSensorSignals(unsigned long timeout=5000, bool logResults=true);
-  bool openContainer(int pos=31, int pThreshold=100, int timeout=10000);
+  bool startStream(byte channels, unsigned long period, byte decimation, unsigned long duration, unsigned long maxByteRate);
+  void stopStream(void);
+  void updateStream(void);
+  bool openContainer(int pos=31, int pThreshold=100, int timeout=10000, float gripCurrent=350.0);
   bool closeContainer(int pThreshold=1000, float iThreshold=200.0, int timeout=10000);
+  bool openContainerWithProfile(byte profileID);
+  bool closeContainerWithProfile(byte profileID);
+  ContainerProfile getContainerProfile(byte profileID);
+  bool setContainerProfile(byte profileID, ContainerProfile profile);
+  bool clearContainerProfile(byte profileID);
   void turnWristClockwise(void);
   void turnWristCounterClockwise(void);
   void stopWristRotation(void);
+  void setWristSpeed(byte duty);
+  void updateWrist(void);
   void setClampPosition(int clampPosition);
   void openClamp(float currentThreshold=1000.0, bool logResults=false);
-  void closeClamp(float currentThreshold=350.0, bool logResults=false);
+  bool closeClamp(float currentThreshold=350.0, bool logResults=false, int minPos=-1, bool unscrewOnContact=false);
+  void benchmark(String prefix);
   int currentPos;
   int sensorSignals[3];
+  float pressure;
+  float pressureSlope;
+  unsigned long pressureTime;
+  unsigned long pressureEventTime[PRESSURE_EVENT_COUNT];
+  float pressureEventValue[PRESSURE_EVENT_COUNT];
+  float pressureHysteresis;
+  float contactDelta;
+  float contactSlope;
+  float releaseDelta;
+  TorqueProfile torqueProfile;
+  float seatedCurrent;
+  UnscrewProfile unscrewProfile;
+  byte unscrewConfidence;
+  bool isStreaming;
+  GripProfile gripProfile;
+  float clampDiameter;
+  FlightRecorder recorder;
+  WristProfile wristProfile;
+  byte wristDirection;
+  byte wristDuty;
   byte errors;
 private:
-  bool CapperDecapper::initializeCurrentSensor(INA219_WE *currentSensor);
+  bool initializeCurrentSensor(INA219_WE *currentSensor);
+  float readCurrentSensor(byte sensor, byte averages, bool logResults, bool logAll);
+  void detectPressureEvents(void);
+  void logPressureEvent(byte event);
+  void writeClampServo(float positionMillimeters);
+  void turnWrist(byte direction);
+  float readWristMotorCurrent(void);
   byte dcMotorPin1;
   byte dcMotorPin2;
   byte servoPin;
@@ -45,8 +185,37 @@ private:
   int servoClosedPosMillimeters;
   int servoOpenedPosMillimeters;
   float degreesPerMillimeter;
+  int pressureThreshold;
+  bool isThresholdArmed;  // true from resetPressureEvents until the end of the open or close cycle, i.e. while pressureThreshold was set by a command
+  float pressureBaseline;
+  int pressureHistory[8];
+  byte pressureHistoryIndex;
+  byte pressureHistoryCount;
+  unsigned long pressureSampleSum;
+  byte pressureSampleCount;
+  unsigned long lastPressureSampleTime;
+  byte pressureEvents;
+  bool isInContact;
+  bool isAboveThreshold;
+  bool isReleaseArmed;
+  byte streamChannels;
+  byte streamDecimation;
+  byte streamSampleCount;
+  byte streamSequence;
+  long streamSums[STREAM_CHANNEL_COUNT];
+  unsigned long streamTicks;
+  unsigned long streamStartTime;
+  unsigned long streamDuration;
+  unsigned long streamRecords;
+  unsigned long streamDropped;
+  unsigned long streamMissed;
+  byte wristTargetDuty;
+  byte wristRampStartDuty;
+  unsigned long wristRampStartTime;
+  bool isWristBraking;
   Servo clampServo;
   INA219_WE currentSensorDCMotor;
   INA219_WE currentSensorServoMotor;
+  AsyncCurrentSensors currentSensors;
 };
 #endif
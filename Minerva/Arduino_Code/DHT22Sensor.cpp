@@ -18,21 +18,98 @@ DHT22Sensor::DHT22Sensor(byte sensorPin) {
   this->sensorPin = sensorPin;
   this->dhtSensor = SimpleDHT22(this->sensorPin);
   this->errors = 0;
+  this->historyIndex = 0;
+  this->historyCount = 0;
+  this->lastReadingTime = 0;
+  this->lastAttemptTime = 0;
+  this->failures = 0;
+  this->readDuration = 0;
 }
 
-float * DHT22Sensor::measure() {
+bool DHT22Sensor::update() {
+  // Background sampler, should only be called while the loop is idle: the read busy-waits for about 5 ms. Reads the sensor at its maximum
+  // rate and adds the reading to the cache and the statistics window. Returns true if a new reading was added.
+  const int sampleInterval = 2100;  // in ms, the sensor does not answer if it is read more often than every 2 s
   float t = 0;
   float h = 0;
-  int err = SimpleDHTErrSuccess;
-  static float res[2];
-  
-  if ((err = this->dhtSensor.read2(&t, &h, NULL)) != SimpleDHTErrSuccess) {
+  unsigned long startTime;
+  int result;
+
+  if (!isTimedOut(this->lastAttemptTime, sampleInterval)) {
+    return false;
+  }
+  this->lastAttemptTime = millis();
+  startTime = micros();
+  result = this->dhtSensor.read2(&t, &h, NULL);
+  this->readDuration = micros() - startTime;
+  if (result != SimpleDHTErrSuccess) {
+    if (this->failures < 255) {
+      this->failures++;
+    }
+    return false;
+  }
+
+  this->failures = 0;
+  this->lastReadingTime = millis();
+  this->temperatureHistory[this->historyIndex] = round(t * 10);
+  this->humidityHistory[this->historyIndex] = round(h * 10);
+  this->historyIndex = (this->historyIndex + 1) % DHT22_WINDOW_SIZE;
+  if (this->historyCount < DHT22_WINDOW_SIZE) {
+    this->historyCount++;
+  }
+  return true;
+}
+
+float * DHT22Sensor::measure() {
+  // Returns the cached reading without accessing the sensor: temperature, humidity, followed by minimum, maximum and mean of the temperature
+  // and of the humidity over the statistics window
+  static float res[8];
+  byte latest = (this->historyIndex + DHT22_WINDOW_SIZE - 1) % DHT22_WINDOW_SIZE;
+  long temperatureSum = 0;
+  long humiditySum = 0;
+
+  if (this->historyCount == 0 || this->failures >= DHT22_MAX_FAILURES) {
     this->errors = 1;
     return NULL;
-  } else {
-    res[0] = t;
-    res[1] = h;
-    this->errors = 0;
-    return res;
   }
+
+  res[0] = this->temperatureHistory[latest] / 10.0;
+  res[1] = this->humidityHistory[latest] / 10.0;
+  res[2] = res[0];
+  res[3] = res[0];
+  res[5] = res[1];
+  res[6] = res[1];
+  for (int i = 0; i < this->historyCount; i++) {
+    res[2] = min(res[2], this->temperatureHistory[i] / 10.0);
+    res[3] = max(res[3], this->temperatureHistory[i] / 10.0);
+    res[5] = min(res[5], this->humidityHistory[i] / 10.0);
+    res[6] = max(res[6], this->humidityHistory[i] / 10.0);
+    temperatureSum += this->temperatureHistory[i];
+    humiditySum += this->humidityHistory[i];
+  }
+  res[4] = temperatureSum / (10.0 * this->historyCount);
+  res[7] = humiditySum / (10.0 * this->historyCount);
+  this->errors = 0;
+  return res;
+}
+
+float DHT22Sensor::getTemperature() {
+  // Latest cached temperature in centigrades for the background tasks, NAN if there is no valid reading
+  if (this->historyCount == 0 || this->failures >= DHT22_MAX_FAILURES) {
+    return NAN;
+  }
+  return this->temperatureHistory[(this->historyIndex + DHT22_WINDOW_SIZE - 1) % DHT22_WINDOW_SIZE] / 10.0;
+}
+
+float DHT22Sensor::getHumidity() {
+  // Latest cached humidity in percent, NAN if there is no valid reading
+  if (this->historyCount == 0 || this->failures >= DHT22_MAX_FAILURES) {
+    return NAN;
+  }
+  return this->humidityHistory[(this->historyIndex + DHT22_WINDOW_SIZE - 1) % DHT22_WINDOW_SIZE] / 10.0;
+}
+
+unsigned long DHT22Sensor::getAge() {
+  // Age of the cached reading in ms
+  return millis() - this->lastReadingTime;
 }
@@ -12,14 +12,29 @@
 #include "SimpleDHT.h"
 #include "HelperFunctions.h"
 
+const byte DHT22_WINDOW_SIZE = 30;  // readings in the statistics window (about one minute)
+const byte DHT22_MAX_FAILURES = 5;  // the sensor is considered to be disconnected after 5 failed reads in a row
+
 class DHT22Sensor {
 public:
   DHT22Sensor(void);
   DHT22Sensor(byte sensorPin);
   float * measure();
+  bool update(void);
+  float getTemperature(void);
+  float getHumidity(void);
+  unsigned long getAge(void);
   byte errors;
+  unsigned long readDuration;  // in us, duration of the last read of the sensor
 private:
   SimpleDHT22 dhtSensor;
   int sensorPin;
+  int temperatureHistory[DHT22_WINDOW_SIZE];  // in 0.1 centigrades
+  int humidityHistory[DHT22_WINDOW_SIZE];  // in 0.1 percent
+  byte historyIndex;
+  byte historyCount;
+  unsigned long lastReadingTime;
+  unsigned long lastAttemptTime;
+  byte failures;
 };
 #endif
@@ -21,14 +21,79 @@ Electromagnet::Electromagnet(byte electromagnetPin1, byte electromagnetPin2) {
   
   this->electromagnetPin1 = electromagnetPin1;
   this->electromagnetPin2 = electromagnetPin2;
+  this->waveform = MAGNET_WAVEFORM_OFF;
+  this->duty = 0;
+  this->reversedPolarity = false;
+  this->halfPeriod = 0;
+  this->duration = 0;
+  this->startTime = 0;
+  this->phaseStartTime = 0;
 }
 
-void Electromagnet::magnetOn(bool reversedPolarity = false) {
-  digitalWrite(this->electromagnetPin1, !reversedPolarity);
-  digitalWrite(this->electromagnetPin2, reversedPolarity);
+void Electromagnet::magnetOn(bool reversedPolarity, byte duty) {
+  this->play(MAGNET_WAVEFORM_CONSTANT, duty, 0, 0, reversedPolarity);
 }
 
 void Electromagnet::magnetOff(void) {
-  digitalWrite(this->electromagnetPin1, LOW);
-  digitalWrite(this->electromagnetPin2, LOW);
+  this->waveform = MAGNET_WAVEFORM_OFF;
+  this->writeOutput(false, 0);
+}
+
+void Electromagnet::play(byte waveform, byte duty, float frequency, unsigned long duration, bool reversedPolarity) {
+  // Starts a waveform that is played in the background by update(). The magnet is turned off after <duration> ms (0: keeps playing until
+  // it is turned off, the release waveform ends by itself). For the alternating and the release waveform, the polarity changes with <frequency> Hz.
+  this->waveform = waveform;
+  this->duty = duty;
+  this->reversedPolarity = (waveform == MAGNET_WAVEFORM_RELEASE) ? !reversedPolarity : reversedPolarity;
+  this->halfPeriod = (frequency > 0) ? max(500.0 / frequency, 1.0) : 0;
+  this->duration = duration;
+  this->startTime = millis();
+  this->phaseStartTime = this->startTime;
+  this->writeOutput(this->reversedPolarity, this->duty);
+}
+
+void Electromagnet::update(void) {
+  // Plays the current waveform, should be called as often as possible
+  const float releaseDecay = 0.5;  // duty of each release pulse relative to the previous one
+  const byte releaseMinDuty = 20;  // the release ends once the duty drops below this
+
+  if (this->waveform == MAGNET_WAVEFORM_OFF) {
+    return;
+  }
+  if (this->duration > 0 && millis() - this->startTime >= this->duration) {
+    this->magnetOff();
+    return;
+  }
+  if (this->waveform == MAGNET_WAVEFORM_CONSTANT || this->halfPeriod == 0 || millis() - this->phaseStartTime < this->halfPeriod) {
+    return;
+  }
+
+  this->phaseStartTime += this->halfPeriod;
+  this->reversedPolarity = !this->reversedPolarity;
+  if (this->waveform == MAGNET_WAVEFORM_RELEASE) {
+    this->duty = this->duty * releaseDecay;
+    if (this->duty < releaseMinDuty) {
+      this->magnetOff();
+      return;
+    }
+  }
+  this->writeOutput(this->reversedPolarity, this->duty);
+}
+
+unsigned long Electromagnet::getRemainingTime(void) {
+  // Remaining time of the current waveform in ms (0 if it plays until it is turned off or ends by itself)
+  if (this->waveform == MAGNET_WAVEFORM_OFF || this->duration == 0) {
+    return 0;
+  }
+  return this->duration - min(millis() - this->startTime, this->duration);
+}
+
+void Electromagnet::writeOutput(bool reversedPolarity, byte duty) {
+  // The PWM is applied to the pin of the polarity (software PWM channel B), the other pin stays LOW
+  byte pwmPin = reversedPolarity ? this->electromagnetPin2 : this->electromagnetPin1;
+  byte lowPin = reversedPolarity ? this->electromagnetPin1 : this->electromagnetPin2;
+
+  softPWMWrite(SOFT_PWM_CHANNEL_B, pwmPin, 0);
+  digitalWrite(lowPin, LOW);
+  softPWMWrite(SOFT_PWM_CHANNEL_B, pwmPin, duty);
 }
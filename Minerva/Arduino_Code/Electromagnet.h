@@ -9,15 +9,34 @@
 #ifndef Electromagnet_h
 #define Electromagnet_h
 #include "HelperFunctions.h"
+#include "SoftPWM.h"
+
+// Waveforms of the pulse sequencer
+const byte MAGNET_WAVEFORM_OFF = 0;
+const byte MAGNET_WAVEFORM_CONSTANT = 1;  // fixed polarity with the PWM duty
+const byte MAGNET_WAVEFORM_ALTERNATE = 2;  // polarity alternates with the frequency (stirring, agitation)
+const byte MAGNET_WAVEFORM_RELEASE = 3;  // reverse pulse followed by pulses of alternating polarity with decaying duty (clean release of the stir bar)
+
 class Electromagnet {
 public:
   Electromagnet(void);
   Electromagnet(byte electromagnetPin1, byte electromagnetPin2);
-  void magnetOn(bool reversedPolarity=false);
+  void magnetOn(bool reversedPolarity=false, byte duty=255);
   void magnetOff(void);
+  void play(byte waveform, byte duty=255, float frequency=10.0, unsigned long duration=0, bool reversedPolarity=false);
+  void update(void);
+  unsigned long getRemainingTime(void);
+  byte waveform;
   byte errors;
 private:
+  void writeOutput(bool reversedPolarity, byte duty);
   byte electromagnetPin1;
   byte electromagnetPin2;
+  byte duty;
+  bool reversedPolarity;
+  unsigned long halfPeriod;
+  unsigned long duration;
+  unsigned long startTime;
+  unsigned long phaseStartTime;
 };
 #endif
@@ -0,0 +1,89 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <Arduino.h>
+#include "EventTrace.h"
+
+EventTrace eventTrace;
+
+EventTrace::EventTrace(void) {
+  this->addedCount = 0;
+  this->clear();
+}
+
+void EventTrace::add(byte type, byte source, int value) {
+  this->add(type, source, value, micros());
+}
+
+void EventTrace::add(byte type, byte source, int value, unsigned long time) {
+  // The oldest event is overwritten when the buffer is full
+  TraceEvent *event = &this->events[this->nextEvent];
+
+  event->time = time;
+  event->type = type;
+  event->source = source;
+  event->value = value;
+  this->nextEvent = (this->nextEvent + 1) % TRACE_EVENTS;
+  this->addedCount++;
+  if (this->eventCount < TRACE_EVENTS) {
+    this->eventCount++;
+  } else if (this->overwrittenCount < 0xFFFF) {
+    this->overwrittenCount++;
+  }
+}
+
+void EventTrace::clear() {
+  this->nextEvent = 0;
+  this->eventCount = 0;
+  this->overwrittenCount = 0;
+}
+
+void EventTrace::dump(String prefix) {
+  // Sends a header (current time in us, number of events, number of overwritten events) followed by the events (oldest first) as one binary block
+  // with fixed-size events of TRACE_EVENT_SIZE bytes (little endian), preceded by a line with the number of bytes that follow.
+  TraceEvent *event;
+
+  Serial.println(prefix + ">DUMP " + String(TRACE_HEADER_SIZE + this->eventCount * TRACE_EVENT_SIZE));
+  this->writeValue(micros(), 4);
+  this->writeValue(this->eventCount, 2);
+  this->writeValue(this->overwrittenCount, 2);
+  for (int i = 0; i < this->eventCount; i++) {
+    event = &this->events[(this->nextEvent + TRACE_EVENTS - this->eventCount + i) % TRACE_EVENTS];
+    this->writeValue(event->time, 4);
+    this->writeValue(event->type, 1);
+    this->writeValue(event->source, 1);
+    this->writeValue(event->value, 2);
+  }
+}
+
+bool EventTrace::get(unsigned long sequence, TraceEvent *event) {
+  // Copies the event with the sequence number <sequence> (counted since the start), false if it was not added yet or is no longer in the buffer
+  if (sequence >= this->addedCount || this->addedCount - sequence > this->eventCount) {
+    return false;
+  }
+  *event = this->events[(this->nextEvent + TRACE_EVENTS - (this->addedCount - sequence)) % TRACE_EVENTS];
+  return true;
+}
+
+void EventTrace::writeValue(unsigned long value, byte length) {
+  for (int i = 0; i < length; i++) {
+    Serial.write((byte)((value >> (8 * i)) & 0xFF));
+  }
+}
+
+byte getTraceSource(String command) {
+  // Device type and number addressed by a (lower case) command, e.g. TRACE_SOURCE_VALVE + 2 for "valve2pos3"
+  static const char prefixes[6][12] PROGMEM = {"valve", "magnet", "clamp", "fan", "dht22sensor", "capper"};
+
+  for (byte i = 0; i < 6; i++) {
+    if (strncmp_P(command.c_str(), prefixes[i], strlen_P(prefixes[i])) == 0) {
+      return ((i + 1) << 4) | (command.substring(strlen_P(prefixes[i])).toInt() & 0x0F);
+    }
+  }
+  return TRACE_SOURCE_GENERAL;
+}
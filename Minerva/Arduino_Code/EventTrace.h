@@ -0,0 +1,69 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#ifndef EventTrace_h
+#define EventTrace_h
+#include <Arduino.h>
+
+const byte TRACE_EVENTS = 64;  // number of events that are kept (each event takes 8 bytes of RAM)
+const byte TRACE_EVENT_SIZE = 8;  // in bytes when dumped
+const byte TRACE_HEADER_SIZE = 8;  // in bytes when dumped
+
+// Types of the traced events and the meaning of their value
+const byte TRACE_COMMAND_RECEIVED = 1;  // bytes still waiting in the serial receive buffer
+const byte TRACE_COMMAND_DONE = 2;  // bytes waiting in the serial receive buffer (commands that were queued during the execution)
+const byte TRACE_MOTION_START = 3;  // target position or direction
+const byte TRACE_MOTION_STOP = 4;  // reached position or 0
+const byte TRACE_CONTACT = 5;  // measured value (5-8 are in the same order as the pressure events of the capper)
+const byte TRACE_THRESHOLD_UP = 6;  // measured value (or the threshold)
+const byte TRACE_THRESHOLD_DOWN = 7;  // measured value
+const byte TRACE_RELEASE = 8;  // measured value
+const byte TRACE_LIMIT_SWITCH = 9;  // direction of the movement
+const byte TRACE_HALL_PEAK = 10;  // deviation of the Hall sensor signal from the idle signal
+const byte TRACE_PHASE = 11;  // phase of the device, 0: end of the last phase
+const byte TRACE_ERROR = 12;  // error code or reason
+
+// Sources of the events: device type in the upper 4 bits (same order as the command types of the runtime statistics), device number in the lower 4 bits
+const byte TRACE_SOURCE_GENERAL = 0x00;
+const byte TRACE_SOURCE_VALVE = 0x10;
+const byte TRACE_SOURCE_MAGNET = 0x20;
+const byte TRACE_SOURCE_CLAMP = 0x30;
+const byte TRACE_SOURCE_FAN = 0x40;
+const byte TRACE_SOURCE_DHT22SENSOR = 0x50;
+const byte TRACE_SOURCE_CAPPER = 0x60;
+
+struct TraceEvent {
+  unsigned long time;  // in us (micros(), wraps after about 71 minutes)
+  byte type;
+  byte source;
+  int value;
+};
+
+// RAM ring buffer with the last TRACE_EVENTS timestamped state transitions of the devices (commands, motions, threshold crossings, limit switches,
+// Hall sensor peaks, phases and errors). Adding an event only takes a few microseconds, so it can be used inside the blocking loops of the drivers.
+class EventTrace {
+public:
+  EventTrace(void);
+  void add(byte type, byte source, int value=0);
+  void add(byte type, byte source, int value, unsigned long time);
+  void clear(void);
+  void dump(String prefix);
+  bool get(unsigned long sequence, TraceEvent *event);
+  unsigned long addedCount;  // sequence number of the next event, not reset by clear()
+private:
+  void writeValue(unsigned long value, byte length);
+  TraceEvent events[TRACE_EVENTS];
+  byte nextEvent;
+  byte eventCount;
+  unsigned int overwrittenCount;
+};
+
+byte getTraceSource(String command);
+
+extern EventTrace eventTrace;  // shared by the main loop and all drivers, see "trace"
+#endif
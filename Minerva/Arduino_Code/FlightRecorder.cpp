@@ -0,0 +1,139 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include "FlightRecorder.h"
+#include "HelperFunctions.h"
+#include "EventTrace.h"
+
+FlightRecorder::FlightRecorder(void) {
+  this->isRecording = false;
+  this->nextCycle = 0;
+  this->cycleCount = 0;
+  this->cycleNumber = 0;
+}
+
+void FlightRecorder::beginCycle(byte type, int pThreshold, int iThreshold, int timeout, int parameter) {
+  const unsigned int initialSampleInterval = 20;  // in ms
+  CycleRecord *cycle = &this->cycles[this->nextCycle];
+
+  cycle->number = ++this->cycleNumber;
+  cycle->type = type;
+  cycle->startTime = millis();
+  cycle->pThreshold = pThreshold;
+  cycle->iThreshold = iThreshold;
+  cycle->timeout = timeout;
+  cycle->parameter = parameter;
+  cycle->outcome = 0;
+  cycle->reason = 0;
+  cycle->value = 0;
+  cycle->duration = 0;
+  cycle->sampleInterval = initialSampleInterval;
+  cycle->phaseCount = 0;
+  cycle->sampleCount = 0;
+  this->isRecording = true;
+}
+
+void FlightRecorder::setPhase(byte phase) {
+  CycleRecord *cycle = &this->cycles[this->nextCycle];
+
+  if (!this->isRecording) {
+    return;
+  }
+  eventTrace.add(TRACE_PHASE, TRACE_SOURCE_CAPPER, phase);  // the phases of the capper cycles are also shown in the event trace
+  if (cycle->phaseCount >= RECORDER_PHASES) {
+    return;
+  }
+  cycle->phases[cycle->phaseCount] = phase;
+  cycle->phaseTimes[cycle->phaseCount] = millis() - cycle->startTime;
+  cycle->phaseCount++;
+}
+
+void FlightRecorder::addSample(int pressure, int current) {
+  // Can be called as often as new values are available. Sample i is due i * sampleInterval ms after the start of the cycle, if the values were
+  // not updated in time (e.g. during a blocking servo move), the following values fill the gap to keep the time axis uniform.
+  CycleRecord *cycle = &this->cycles[this->nextCycle];
+
+  if (!this->isRecording || millis() - cycle->startTime < (unsigned long)cycle->sampleCount * cycle->sampleInterval) {
+    return;
+  }
+  if (cycle->sampleCount >= RECORDER_SAMPLES) {
+    for (int i = 0; i < RECORDER_SAMPLES / 2; i++) {
+      cycle->samples[i][0] = (cycle->samples[2 * i][0] + cycle->samples[2 * i + 1][0]) / 2;
+      cycle->samples[i][1] = (cycle->samples[2 * i][1] + cycle->samples[2 * i + 1][1]) / 2;
+    }
+    cycle->sampleCount = RECORDER_SAMPLES / 2;
+    cycle->sampleInterval *= 2;
+  }
+  cycle->samples[cycle->sampleCount][0] = pressure;
+  cycle->samples[cycle->sampleCount][1] = current;
+  cycle->sampleCount++;
+}
+
+void FlightRecorder::endCycle(bool outcome, byte reason, int value) {
+  CycleRecord *cycle = &this->cycles[this->nextCycle];
+
+  if (!this->isRecording) {
+    return;
+  }
+  cycle->outcome = outcome;
+  cycle->reason = reason;
+  cycle->value = value;
+  cycle->duration = min(millis() - cycle->startTime, 65535UL);
+  eventTrace.add(TRACE_PHASE, TRACE_SOURCE_CAPPER, 0);
+  if (!outcome) {
+    eventTrace.add(TRACE_ERROR, TRACE_SOURCE_CAPPER, reason);
+  }
+  this->isRecording = false;
+  this->nextCycle = (this->nextCycle + 1) % RECORDER_CYCLES;
+  this->cycleCount = min(this->cycleCount + 1, (int)RECORDER_CYCLES);
+}
+
+void FlightRecorder::clear() {
+  this->isRecording = false;
+  this->nextCycle = 0;
+  this->cycleCount = 0;
+}
+
+void FlightRecorder::dump(String prefix) {
+  // Sends the completed cycles (oldest first) as one binary block with fixed-size cycles of RECORDER_CYCLE_SIZE bytes (little endian,
+  // unused phases and samples are sent as zeros), preceded by a line with the number of bytes that follow.
+  CycleRecord *cycle;
+
+  Serial.println(prefix + ">DUMP " + String(this->cycleCount * RECORDER_CYCLE_SIZE));
+  for (int i = 0; i < this->cycleCount; i++) {
+    cycle = &this->cycles[(this->nextCycle + RECORDER_CYCLES - this->cycleCount + i) % RECORDER_CYCLES];
+    this->writeValue(cycle->number, 2);
+    this->writeValue(cycle->type, 1);
+    this->writeValue(cycle->startTime, 4);
+    this->writeValue(cycle->pThreshold, 2);
+    this->writeValue(cycle->iThreshold, 2);
+    this->writeValue(cycle->timeout, 2);
+    this->writeValue(cycle->parameter, 2);
+    this->writeValue(cycle->outcome, 1);
+    this->writeValue(cycle->reason, 1);
+    this->writeValue(cycle->value, 2);
+    this->writeValue(cycle->duration, 2);
+    this->writeValue(cycle->sampleInterval, 2);
+    this->writeValue(cycle->phaseCount, 1);
+    for (int j = 0; j < RECORDER_PHASES; j++) {
+      this->writeValue(j < cycle->phaseCount ? cycle->phases[j] : 0, 1);
+      this->writeValue(j < cycle->phaseCount ? cycle->phaseTimes[j] : 0, 2);
+    }
+    this->writeValue(cycle->sampleCount, 1);
+    for (int j = 0; j < RECORDER_SAMPLES; j++) {
+      this->writeValue(j < cycle->sampleCount ? cycle->samples[j][0] : 0, 2);
+      this->writeValue(j < cycle->sampleCount ? cycle->samples[j][1] : 0, 2);
+    }
+  }
+}
+
+void FlightRecorder::writeValue(unsigned long value, byte length) {
+  for (int i = 0; i < length; i++) {
+    Serial.write((byte)((value >> (8 * i)) & 0xFF));
+  }
+}
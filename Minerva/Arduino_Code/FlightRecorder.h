@@ -0,0 +1,69 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#ifndef FlightRecorder_h
+#define FlightRecorder_h
+#include <Arduino.h>
+
+const byte RECORDER_CYCLES = 4;  // number of cycles that are kept (each cycle takes 241 bytes of RAM)
+const byte RECORDER_PHASES = 8;
+const byte RECORDER_SAMPLES = 48;
+const int RECORDER_CYCLE_SIZE = 25 + 3 * RECORDER_PHASES + 4 * RECORDER_SAMPLES;  // in bytes when dumped
+
+// Types of the recorded cycles
+const byte RECORDER_CYCLE_OPEN = 1;
+const byte RECORDER_CYCLE_CLOSE = 2;
+
+// Phases of the recorded cycles
+const byte RECORDER_PHASE_WAIT_PRESSURE = 1;
+const byte RECORDER_PHASE_CLAMP_CLOSE = 2;
+const byte RECORDER_PHASE_UNSCREW = 3;
+const byte RECORDER_PHASE_TIGHTEN = 4;
+const byte RECORDER_PHASE_CLAMP_OPEN = 5;
+
+struct CycleRecord {
+  unsigned int number;
+  byte type;
+  unsigned long startTime;  // in ms
+  int pThreshold;
+  int iThreshold;  // in mA
+  int timeout;  // in ms
+  int parameter;  // e.g. the clamp position
+  byte outcome;  // 1 if successful
+  byte reason;  // reason code or bit mask of the detector
+  int value;  // e.g. the confidence or the current when the cap was seated
+  unsigned int duration;  // in ms
+  unsigned int sampleInterval;  // in ms
+  byte phaseCount;
+  byte phases[RECORDER_PHASES];
+  unsigned int phaseTimes[RECORDER_PHASES];  // in ms after the start of the cycle
+  byte sampleCount;
+  int samples[RECORDER_SAMPLES][2];  // pressure (12 bit) and wrist motor current (in 0.1 mA)
+};
+
+// RAM ring buffer that keeps a compact trace of the last RECORDER_CYCLES capper cycles: phase transitions, downsampled pressure and current,
+// the thresholds that were used and the outcome. The sample interval starts at 20 ms and is doubled (averaging pairs of samples) whenever the
+// buffer of a cycle is full, so a cycle is always covered completely.
+class FlightRecorder {
+public:
+  FlightRecorder(void);
+  void beginCycle(byte type, int pThreshold, int iThreshold, int timeout, int parameter);
+  void setPhase(byte phase);
+  void addSample(int pressure, int current);
+  void endCycle(bool outcome, byte reason, int value);
+  void clear(void);
+  void dump(String prefix);
+  bool isRecording;
+private:
+  void writeValue(unsigned long value, byte length);
+  CycleRecord cycles[RECORDER_CYCLES];
+  byte nextCycle;
+  byte cycleCount;
+  unsigned int cycleNumber;
+};
+#endif
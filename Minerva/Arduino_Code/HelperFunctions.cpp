@@ -14,6 +14,7 @@ int mod(int x, int y){
 }
 
 bool isTimedOut(unsigned long startTime, int timeout) {
+  yield();  // every blocking loop polls isTimedOut, so the background tasks of the sketch keep running while a command is executed
   return ((unsigned long)(millis() - startTime) > timeout);  // subtract and cast to unsigned long to avoid overflow problem
 }
 
@@ -27,6 +28,20 @@ String getErrorMessage(byte errors) {
   } else if (errors == 3) {
     return "TIMEOUT ERROR";
   }
+  return "UNKNOWN ERROR";
+}
+
+bool isNumber(String s) {
+  // true if s is a non-negative integer without any other characters (toInt() silently returns 0 for those)
+  if (s.length() == 0) {
+    return false;
+  }
+  for (unsigned int i = 0; i < s.length(); i++) {
+    if (s.charAt(i) < '0' || s.charAt(i) > '9') {
+      return false;
+    }
+  }
+  return true;
 }
 
 void displayHelp() {
@@ -39,7 +54,21 @@ void displayHelp() {
     "******************************************\n"
     "esr                                         Request Emergency Stop\n"
     "ces                                         Clear Emergency Stop Request\n"
-    "help                                        Display this help text\n\n"
+    "help                                        Display this help text\n"
+    "stats                                       Runtime statistics: TIME <uptime;executing commands;waiting for devices during commands;idle phase of the loop;sensor sampling in the idle phase> in ms, LOOP <idle iterations;min;mean;max period;mean jitter> in us, SERIAL <receive buffer found full>, MEMORY <heap;stack;peak stack;min. free> in bytes, "
+    "CMD <type> <count;min;mean;max> in us and histogram counts of the execution times (<1, <4, <16, <64, <256, <1024, <4096, >=4096 ms) per command type\n"
+    "stats reset                                 Clear the runtime statistics\n"
+    "trace                                       Dumps the event trace (last 64 timestamped commands, motions, threshold crossings, limit switches, Hall sensor peaks, phases and errors) in binary\n"
+    "trace clear                                 Clear the event trace\n"
+    "subscribe [channel;int p]                   Pushes the value of the <channel> every <p> ms (20 ms minimum, 0 unsubscribes) as TELEMETRY>DATA <time in ms>;<channel>=<value>;... until it is unsubscribed (or lists the subscriptions). Values are only pushed while no command is running. "
+    "Channels: hall1, hall2 (Hall sensor signal - idle signal), valve1, valve2 (position), pressure, motor_current, servo_current (capper, in mA), clamp1, clamp2, clamp3 (motor current in mA), switches (bit mask of the triggered limit switches: clamp 1 down, up, clamp 2 down, up, clamp 3 down, up, clamp 4), temperature1, humidity1\n"
+    "unsubscribe [channel]                       Stops pushing the value of the <channel> (or of all channels)\n"
+    "watch [channel;int m;float t;float h]       Sends EVENT>WATCH <time in ms>;<channel>;<rising|falling|change>;<value> when the value of the telemetry <channel> meets the condition <m> (0: disarm, 1: rises above <t> + <h>, 2: falls below <t> - <h>, 3: both, 4: changes by at least <h>, the default). "
+    "Armed until unwatched (or lists the watches). Like the telemetry, the conditions are only checked while no command is running.\n"
+    "watch <motion|limits|errors>                Sends EVENT>TRACE <time in ms>;<type>;<source>;<value> (see trace) for every motion stop, limit switch or error of the devices, right after the reply of the command in which it happened\n"
+    "unwatch [channel]                           Disarms the watch of the <channel> (or all watches)\n"
+    "bench                                       Measures the timing of the board (takes about 1 s): DELAY <requested;measured> duration of delayMicroseconds in us, ANALOG <pin> <us per analogRead;max. deviation of the first reading after another channel without;with 100 us settle time> in ADC counts, "
+    "DIGITALWRITE <us>, STEP <max. step rate of AccelStepper in steps/s>, I2C <register reads;min;mean;max in us;bus errors>, INA219 <sensor> <readings;mean conversion interval in us>, SERVO <us per write>, DHT22 <duration of the last read in us>, SERIAL <bytes;us;bytes/s;nominal bytes/s>\n\n"
     "******************************************\n"
     "*             Valve Commands             *\n"
     "******************************************\n"
@@ -50,10 +79,12 @@ void displayHelp() {
     "******************************************\n"
     "*         Electromagnet Commands         *\n"
     "******************************************\n"
-    "magnet<int number> on                       Turn the magnet with the number <number> on\n"
+    "magnet<int number> on [int d] [int t]       Turn the magnet with the number <number> on (with the PWM duty [d] between 1 and 255, for [t] ms)\n"
     "magnet<int number> off                      Turn the magnet with the number <number> off\n"
-    "magnet<int number> rev                      Reverse the polarity of the magnet with the number <number>\n"
-    "magnet<int number> rel                      Release the stirbar from the magnet with the number <number> (briefly reverses polarity and turns the magnet off)\n\n"
+    "magnet<int number> rev [int d] [int t]      Turn the magnet with the number <number> on with reversed polarity (with the PWM duty [d], for [t] ms)\n"
+    "magnet<int number> rel [int d] [float f]    Release the stirbar from the magnet with the number <number> in the background: reverse pulse followed by pulses of alternating polarity and decaying duty (starting at duty [d], [f] polarity changes per second)\n"
+    "magnet<int number> stir <float f> [int d] [int t]  Alternate the polarity of the magnet with the number <number> with the frequency <f> in Hz (with the PWM duty [d], for [t] ms) in the background\n"
+    "magnet<int number> status                   Query the waveform (0: off, 1: constant, 2: alternating, 3: release) and its remaining time in ms\n\n"
     "******************************************\n"
     "*        Hotplate Clamp Commands         *\n"
     "******************************************\n"
@@ -62,12 +93,20 @@ void displayHelp() {
     "clamp<int number> stop                      Stops movement of the clamp with the number <number>\n"
     "clamp<int number> motor_current             Returns the DC Motor current for clamp number <number>\n"
     "clamp<int number> open [int angle] [int d]  Open the clamp (up to a servo angle of [angle], or all the way if not specified), slowing down for the first d degrees\n"
-    "clamp<int number> close [int angle] [int d] Close the clamp (up to a servo angle of [angle], or all the way if not specified), slowing down for the last d degrees\n\n"
+    "clamp<int number> close [int angle] [int d] Close the clamp (up to a servo angle of [angle], or all the way if not specified), slowing down for the last d degrees\n"
+    "clamp<int number> lower_and_close [int a]   Move the stage down and start closing the clamp (up to servo angle [a]) during the last part of the descent\n"
+    "clamp<int number> open_and_raise [int x]    Release the container and open the clamp while the stage is moving up (x: servo angle for DC motor clamps, position in mm for stepper motor clamps)\n"
+    "clamp<int number> home                      Stepper motor clamps only: Home the stage (fast approach, back off, slow re-approach of the limit switch)\n"
+    "clamp<int number> goto <int pos>            Stepper motor clamps only: Move the stage to the absolute position <pos> in millimeters above the home position. Like lower_and_close and open_and_raise, it is refused until the stage was homed (or its position was set)\n"
+    "clamp<int number> pos [int pos]             Stepper motor clamps only: Query the current stage position, or set it to <pos> millimeters without moving\n"
+    "clamp<int number> status                    Stepper motor clamps only: Returns HOMED or NOT HOMED and the current stage position\n\n"
     "******************************************\n"
     "*         Hotplate Fan Commands          *\n"
     "******************************************\n"
-    "fan<int number> on                          Turns the fan with the number <number> on.\n"
-    "fan<int number> off                         Turns the fan with the number <number> off.\n\n"
+    "fan<int number> on [int d]                  Turns the fan with the number <number> on (with the PWM duty [d] between 1 and 255, fans 3 and 4 only, fans 1 and 2 run with full speed).\n"
+    "fan<int number> off                         Turns the fan with the number <number> off.\n"
+    "fan<int number> cool <int d;int t[;float T]>  Cool-down profile: runs the fan with the number <number> with the PWM duty <d> for <t> ms (0: no time limit) or until the temperature drops below [T] in centigrades, then turns it off. Runs in the background.\n"
+    "fan<int number> status                      Query the state (0: off, 1: on, 2: cool-down), the PWM duty and the maximum remaining time of the cool-down in ms\n\n"
     "******************************************\n"
     "*       Capper/Decapper Commands         *\n"
     "******************************************\n"
@@ -77,17 +116,33 @@ void displayHelp() {
     "capper motor_current [all]                  Query dc motor current in mA (or all values provided by the sensor if [all] is specified)\n"
     "capper servo_current [all]                  Query servo motor current in mA (or all values provided by the sensor if [all] is specified)\n"
     "capper log <int timeout>                    Logs pressure, motor current, and servo current for the specified time (in milliseconds)\n"
-    "capper open <int pos> <int p> [int to]      Opens a container: Wait until the pressure threshold <p> or timeout [to] is reached, close the gripper to position <pos>, rotate wrist until 'jumping' occurs or timeout [to] is reached\n"
-    "capper close <int p> <float i> [int to]     Closes a container: Wait until pressure threshold <p> or timeout [to] is reached, rotate wrist until current threshold <i> in mA or timeout [to] is reached, open gripper\n"
+    "capper stream [int c;int p;int d;int t]     Streams binary records of the channels <c> (1: pressure, 2: motor current, 4: servo current, 8: bus voltage) every <p> us (500-32000), averaged over <d> samples, for <t> ms (0: until stopped). Rejected if the records do not fit the serial port (9600 baud: 960 / (7 + 2 * channels) records per second)\n"
+    "capper stream_stop                          Stops the binary sensor stream\n"
+    "capper recorder                             Dumps the flight recorder (trace of the last 4 open/close cycles) in binary\n"
+    "capper recorder_clear                       Clears the flight recorder\n"
+    "capper open <int pos> <int p> [int to]      Opens a container: Wait until the pressure threshold <p> or timeout [to] is reached, close the gripper (not further than position <pos>), rotate wrist until the cap is free (pressure release, current drop and rotation time) or timeout [to] is reached\n"
+    "capper close <int p> <float i> [int to]     Closes a container: Wait until pressure threshold <p> or timeout [to] is reached, rotate wrist until the cap is seated (current rise or current level <i> in mA) or timeout [to] is reached, open gripper\n"
+    "capper open_profile <int id>                Opens a container with the parameters of the container profile <id> (0-7)\n"
+    "capper close_profile <int id>               Closes a container with the parameters of the container profile <id> (0-7)\n"
+    "capper profile <int id>[;int pos;float i;int po;int pc;float l;int f;int s;int to;int tc;int tt]  Query or store the container profile <id> in the EEPROM: clamp position <pos> in mm, holding current <i> in mA, pressure thresholds for opening <po> and closing <pc>, seating level <l> in mA, clamp step times <f> in ms/mm and <s> in ms/degree, timeouts for opening <to> and closing <tc> in ms, start of the slow final-torque phase <tt> in ms (0: none)\n"
+    "capper profile_clear <int id>               Resets the container profile <id> to the defaults\n"
+    "capper tighten [float i] [int to]           Rotates the wrist clockwise until the cap is seated (current rise or current level [i] in mA) or timeout [to] is reached, then stops the wrist\n"
+    "capper tighten_release [float i] [int to]   Same as tighten, but opens the clamp right after the wrist was stopped\n"
+    "capper torque_profile [int t;float l;float r;float s;int p]  Query or set the cap seating detection: inrush time <t> in ms, level <l> in mA, rise <r> in mA, slope <s> in mA/s, plateau time <p> in ms\n"
+    "capper grip_unscrew [float i] [int to]      Closes the clamp with the holding current [i] in mA, starts the wrist at contact and rotates it counter-clockwise until the cap is free or timeout [to] is reached\n"
+    "capper unscrew [int to]                     Rotates the wrist counter-clockwise until the cap is free or timeout [to] is reached, then stops the wrist\n"
+    "capper unscrew_profile [int t;int m;float f;int s;int c]  Query or set the uncapping detection: inrush time <t> in ms, min. rotation time <m> in ms, current drop fraction <f>, stable time <s> in ms, min. confidence <c> in %\n"
     "capper turn_cw                              Rotates the wrist of the capper clockwise\n"
     "capper turn_ccw                             Rotates the wrist of the capper counter-clockwise\n"
-    "capper turn_stop                            Stops wrist rotation\n"
+    "capper turn_stop                            Stops wrist rotation (brakes actively)\n"
+    "capper wrist_profile [int s;int c;int r;int d;int t;int b]  Query or set the PWM drive of the wrist: start duty <s> and cruise duty <c> (0-255), ramp time <r> in ms, final-torque duty <d>, start of the final-torque phase <t> in ms after the start of tightening (0: none), brake time <b> in ms\n"
     "capper clamp_open [float threshold]         Open the clamp (until the current threshold [threshold] in mA or the open position is reached)\n"
-    "capper clamp_close [float threshold]        Close the clamp (until the current threshold [threshold] in mA or the closed position is reached)\n\n"
+    "capper clamp_close [float threshold]        Close the clamp with force control: fast until contact, then fine steps until the holding current [threshold] in mA is reached and stable. Reports the measured diameter in mm\n"
+    "capper grip_profile [int f;int s;float c;float b;int t;int to]  Query or set the gripper control: fast step time <f> in ms/mm, fine step time <s> in ms/degree, contact delta <c> in mA, holding band <b> (fraction), settle time <t> in ms, timeout <to> in ms\n\n"
     "******************************************\n"
     "*            DHT22 Commands              *\n"
     "******************************************\n"
-    "dht22sensor<int number> measure             Performs a measurement with the sensor number <number> and returns the temperature (in centrigrades) and humidity (in percent) readings.\n\n"
+    "dht22sensor<int number> measure             Returns the latest temperature (in centrigrades) and humidity (in percent) readings of the sensor number <number>, the age of the readings in ms, and min;max;mean of the temperature and of the humidity over the last 30 readings. The sensor is read in the background every 2.1 s while no command is running.\n\n"
     "******************************************\n"
     "*              Error Codes               *\n"
     "******************************************\n"
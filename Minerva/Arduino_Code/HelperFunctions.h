@@ -12,5 +12,6 @@
 int mod(int x, int y);
 bool isTimedOut(unsigned long startTime, int timeout);
 String getErrorMessage(byte errors);
+bool isNumber(String s);
 void displayHelp(void);
 #endif
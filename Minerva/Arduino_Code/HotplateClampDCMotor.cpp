@@ -10,11 +10,12 @@
 #include <Servo.h>
 #include "HotplateClampDCMotor.h"
 #include "HelperFunctions.h"
+#include "EventTrace.h"
 
 HotplateClampDCMotor::HotplateClampDCMotor(void) {
 }
 
-HotplateClampDCMotor::HotplateClampDCMotor(byte dcMotorPin1, byte dcMotorPin2, byte servoPin, byte currentSensorPin, byte switchPinUp, byte switchPinDown , int servoClosedPos=0, int servoOpenedPos=180) {
+HotplateClampDCMotor::HotplateClampDCMotor(byte dcMotorPin1, byte dcMotorPin2, byte servoPin, byte currentSensorPin, byte switchPinUp, byte switchPinDown , int servoClosedPos, int servoOpenedPos) {
   
   pinMode(dcMotorPin1, OUTPUT);
   pinMode(dcMotorPin2, OUTPUT);
@@ -23,6 +24,11 @@ HotplateClampDCMotor::HotplateClampDCMotor(byte dcMotorPin1, byte dcMotorPin2, b
   pinMode(switchPinUp, INPUT);
   pinMode(switchPinDown, INPUT);  
   this->errors = 0;
+  this->traceSource = TRACE_SOURCE_CLAMP;
+  this->descentTime = 0;
+  this->ascentTime = 0;
+  this->isAtTop = false;
+  this->lastServoStepTime = 0;
   
   this->dcMotorPin1 = dcMotorPin1;
   this->dcMotorPin2 = dcMotorPin2;
@@ -42,21 +48,29 @@ HotplateClampDCMotor::HotplateClampDCMotor(byte dcMotorPin1, byte dcMotorPin2, b
 bool HotplateClampDCMotor::goUp(int currentThreshold) {
   const int timeout = 30000;  // if the target position was not reached after 30 sec, give up
   unsigned long startTime = millis();
+
+  this->isAtTop = false;
   
   digitalWrite(this->dcMotorPin1, HIGH);
   digitalWrite(this->dcMotorPin2, LOW);
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, 1);
   HotplateClampDCMotor::getCurrentSensorData();
   delay(1500); //wait for 1500 ms before taking the first current reading
   while ((abs(HotplateClampDCMotor::getCurrentSensorData()) < abs(currentThreshold)) && !isTimedOut(startTime, timeout)) {
     delay(10);
   }
+  if (!isTimedOut(startTime, timeout)) {
+    eventTrace.add(TRACE_THRESHOLD_UP, this->traceSource, currentThreshold);
+  }
   digitalWrite(this->dcMotorPin1, LOW);
   digitalWrite(this->dcMotorPin2, LOW);
   if (isTimedOut(startTime, timeout)) {
     this->errors = 3;
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
     return false;
   } else {
     this->errors = 0;
+    eventTrace.add(TRACE_MOTION_STOP, this->traceSource, 0);
     return true;
   }
 }
@@ -65,13 +79,19 @@ bool HotplateClampDCMotor::goUp() {
   const int timeout = 30000;  // if the target position was not reached after 30 sec, give up
   unsigned long startTime = millis();
 
+  this->isAtTop = false;
+
   digitalWrite(this->dcMotorPin1, HIGH);
   digitalWrite(this->dcMotorPin2, LOW);
   
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, 1);
   while (digitalRead(this->switchPinUp)==HIGH && !isTimedOut(startTime, timeout))
   {
     delayMicroseconds(2000);
   }
+  if (digitalRead(this->switchPinUp)==LOW) {
+    eventTrace.add(TRACE_LIMIT_SWITCH, this->traceSource, 1);
+  }
 
   digitalWrite(this->dcMotorPin1, LOW);
   digitalWrite(this->dcMotorPin2, LOW);
@@ -79,8 +99,10 @@ bool HotplateClampDCMotor::goUp() {
   delayMicroseconds(2000);
   if (digitalRead(this->switchPinUp)==HIGH) {
     this->errors = 3;  // timeout
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
     return false;    
   }
+  this->ascentTime = millis() - startTime;
   // back off a little bit from the top position
   digitalWrite(this->dcMotorPin1, LOW);
   digitalWrite(this->dcMotorPin2, HIGH);
@@ -88,6 +110,8 @@ bool HotplateClampDCMotor::goUp() {
   digitalWrite(this->dcMotorPin1, LOW);
   digitalWrite(this->dcMotorPin2, LOW);
   
+  this->isAtTop = true;
+  eventTrace.add(TRACE_MOTION_STOP, this->traceSource, 0);
   return true;
 }
 
@@ -95,20 +119,28 @@ bool HotplateClampDCMotor::goDown(int currentThreshold) {
   const int timeout = 30000;  // if the target position was not reached after 30 sec, give up
   unsigned long startTime = millis();
 
+  this->isAtTop = false;
+
   digitalWrite(this->dcMotorPin1, LOW);
   digitalWrite(this->dcMotorPin2, HIGH);
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, -1);
   HotplateClampDCMotor::getCurrentSensorData();
   delay(500);  //wait for 500 ms before taking the first current reading
   while ((abs(HotplateClampDCMotor::getCurrentSensorData()) < abs(currentThreshold)) && !isTimedOut(startTime, timeout)) {
     delay(10);
   }
+  if (!isTimedOut(startTime, timeout)) {
+    eventTrace.add(TRACE_THRESHOLD_UP, this->traceSource, currentThreshold);
+  }
   digitalWrite(this->dcMotorPin1, LOW);
   digitalWrite(this->dcMotorPin2, LOW);
   if (isTimedOut(startTime, timeout)) {
     this->errors = 3;
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
     return false;
   } else {
     this->errors = 0;
+    eventTrace.add(TRACE_MOTION_STOP, this->traceSource, 0);
     return true;
   }
 }
@@ -116,14 +148,20 @@ bool HotplateClampDCMotor::goDown(int currentThreshold) {
 bool HotplateClampDCMotor::goDown() {
   const int timeout = 30000;  // if the target position was not reached after 30 sec, give up
   unsigned long startTime = millis();
+  bool fromTop = this->isAtTop;  // only a descent from the top position gives the travel time that lowerAndClose relies on
 
+  this->isAtTop = false;
   digitalWrite(this->dcMotorPin1, LOW);
   digitalWrite(this->dcMotorPin2, HIGH);
   
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, -1);
   while (digitalRead(this->switchPinDown)==HIGH && !isTimedOut(startTime, timeout))
   {
     delayMicroseconds(2000);
   }
+  if (digitalRead(this->switchPinDown)==LOW) {
+    eventTrace.add(TRACE_LIMIT_SWITCH, this->traceSource, -1);
+  }
 
   digitalWrite(this->dcMotorPin1, LOW);
   digitalWrite(this->dcMotorPin2, LOW);
@@ -131,8 +169,12 @@ bool HotplateClampDCMotor::goDown() {
   delayMicroseconds(2000);
   if (digitalRead(this->switchPinDown)==HIGH) {
     this->errors = 3;  // timeout
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
     return false;    
   }
+  if (fromTop) {
+    this->descentTime = millis() - startTime;
+  }
   // back off a little bit from the bottom position
   digitalWrite(this->dcMotorPin1, HIGH);
   digitalWrite(this->dcMotorPin2, LOW);
@@ -140,6 +182,7 @@ bool HotplateClampDCMotor::goDown() {
   digitalWrite(this->dcMotorPin1, LOW);
   digitalWrite(this->dcMotorPin2, LOW);
   
+  eventTrace.add(TRACE_MOTION_STOP, this->traceSource, 0);
   return true;
 }
 
@@ -149,7 +192,7 @@ bool HotplateClampDCMotor::stopStage() {
   return true;
 }
 
-float HotplateClampDCMotor::getCurrentSensorData(int averages=3) {
+float HotplateClampDCMotor::getCurrentSensorData(int averages) {
   float current = 6000.f;
   float r;
   analogRead(this->currentSensorPin);  // discard first reading
@@ -165,7 +208,7 @@ float HotplateClampDCMotor::getCurrentSensorData(int averages=3) {
   return current;
 }
 
-void HotplateClampDCMotor::openClamp(int servoPos=-1, int slowdownDegrees=20) {
+void HotplateClampDCMotor::openClamp(int servoPos, int slowdownDegrees) {
   int inc;
   const int waitPerStep = 100;
 
@@ -191,8 +234,8 @@ void HotplateClampDCMotor::openClamp(int servoPos=-1, int slowdownDegrees=20) {
     delay(waitPerStep);
   }  
   
-  this->clampServo.write(this->servoOpenedPos - inc*slowdownDegrees);
-  this->currentServoPos = this->servoOpenedPos - inc*slowdownDegrees;
+  this->clampServo.write(servoPos - inc*slowdownDegrees);
+  this->currentServoPos = servoPos - inc*slowdownDegrees;
 
   for (int i=0; i<slowdownDegrees; i++) {
     this->currentServoPos += inc;
@@ -202,7 +245,7 @@ void HotplateClampDCMotor::openClamp(int servoPos=-1, int slowdownDegrees=20) {
 
 }
 
-void HotplateClampDCMotor::closeClamp(int servoPos=-1, int slowdownDegrees=25) {
+void HotplateClampDCMotor::closeClamp(int servoPos, int slowdownDegrees) {
   int inc;
   const int waitPerStep = 100;
 
@@ -233,3 +276,206 @@ void HotplateClampDCMotor::closeClamp(int servoPos=-1, int slowdownDegrees=25) {
 
   this->currentServoPos = servoPos;
 }
+
+float HotplateClampDCMotor::sampleCurrent() {
+  // Single, non-blocking reading of the ACS712 current sensor in mA (for polling while the stage is moving and for the telemetry)
+  return (2.5 - (analogRead(this->currentSensorPin)*5.0)/1024.0)/0.185*1000;
+}
+
+bool HotplateClampDCMotor::stepServoTowards(int servoPos) {
+  // Non-blocking version of the slow servo approach: moves the servo by one degree at most every waitPerStep ms
+  const int waitPerStep = 100;
+
+  if (this->currentServoPos == servoPos) {
+    return true;
+  }
+  if (millis() - this->lastServoStepTime >= waitPerStep) {
+    this->currentServoPos += (this->currentServoPos < servoPos) ? 1 : -1;
+    this->clampServo.write(this->currentServoPos);
+    this->lastServoStepTime = millis();
+  }
+  return (this->currentServoPos == servoPos);
+}
+
+bool HotplateClampDCMotor::lowerAndClose(int servoPos, int slowdownDegrees) {
+  const int timeout = 30000;  // if the target position was not reached after 30 sec, give up
+  const int waitPerStep = 100;
+  const int maxOverlap = 1500;  // start the slow servo approach at most 1500 ms before the stage is expected to reach the bottom
+  const int inrushTime = 500;  // ignore the motor current for the first 500 ms
+  const int cruiseWindow = 300;  // average the cruise current over the first 300 ms after the inrush
+  const float currentRise = 100.0;  // a current rise of more than 100 mA above the cruise current means the stage is about to stall at the bottom
+  const byte filterLength = 8;  // running mean over 8 samples, a single ADC count of the ACS712 is already about 26 mA
+  const byte riseSamples = 25;  // the rise has to be seen on 25 consecutive filtered samples (about 50 ms, the stall current stays up)
+  unsigned long startTime = millis();
+  unsigned long overlap;
+  float samples[filterLength];
+  float sampleSum = 0;
+  byte sampleIndex = 0;
+  byte sampleCount = 0;
+  float cruiseSum = 0;
+  unsigned int cruiseCount = 0;
+  byte riseCount = 0;
+  float current;
+  bool closing = false;
+  bool fromTop = this->isAtTop;  // only a descent from the top position gives the travel time for the next overlap
+  int inc;
+
+  if (servoPos == -1) {
+    servoPos = this->servoClosedPos;
+  }
+  slowdownDegrees = min(abs(this->currentServoPos - servoPos), slowdownDegrees);
+  if (this->currentServoPos >= servoPos) {
+    inc = -1;
+  } else {
+    inc = 1;
+  }
+  overlap = min((unsigned long)slowdownDegrees * waitPerStep, (unsigned long)maxOverlap);
+
+  this->isAtTop = false;
+  digitalWrite(this->dcMotorPin1, LOW);
+  digitalWrite(this->dcMotorPin2, HIGH);
+
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, -1);
+  while (digitalRead(this->switchPinDown)==HIGH && !isTimedOut(startTime, timeout)) {
+    if (!closing) {
+      // Start closing either based on the travel time learned from the previous descent, or (if not known yet) when the motor current starts rising
+      if (this->descentTime > overlap && millis() - startTime >= this->descentTime - overlap) {
+        closing = true;
+      } else if (this->descentTime == 0 && millis() - startTime >= inrushTime) {
+        current = abs(this->sampleCurrent());
+        if (sampleCount == filterLength) {
+          sampleSum -= samples[sampleIndex];
+        } else {
+          sampleCount++;
+        }
+        samples[sampleIndex] = current;
+        sampleSum += current;
+        sampleIndex = (sampleIndex + 1) % filterLength;
+        if (millis() - startTime < inrushTime + cruiseWindow) {
+          cruiseSum += current;
+          cruiseCount++;
+        } else if (cruiseCount > 0) {
+          if (sampleSum / sampleCount - cruiseSum / cruiseCount > currentRise) {
+            riseCount++;
+          } else {
+            riseCount = 0;
+          }
+          closing = (riseCount >= riseSamples);
+        }
+      }
+      if (closing) {
+        this->clampServo.write(servoPos - inc * slowdownDegrees);
+        this->currentServoPos = servoPos - inc * slowdownDegrees;
+        this->lastServoStepTime = millis();
+      }
+    } else {
+      this->stepServoTowards(servoPos);
+    }
+    delayMicroseconds(2000);
+  }
+  if (digitalRead(this->switchPinDown)==LOW) {
+    eventTrace.add(TRACE_LIMIT_SWITCH, this->traceSource, -1);
+  }
+
+  digitalWrite(this->dcMotorPin1, LOW);
+  digitalWrite(this->dcMotorPin2, LOW);
+
+  delayMicroseconds(2000);
+  if (digitalRead(this->switchPinDown)==HIGH) {
+    this->errors = 3;  // timeout
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
+    return false;
+  }
+  if (fromTop) {
+    this->descentTime = millis() - startTime;
+  }
+
+  // back off a little bit from the bottom position
+  digitalWrite(this->dcMotorPin1, HIGH);
+  digitalWrite(this->dcMotorPin2, LOW);
+  delay(150);
+  digitalWrite(this->dcMotorPin1, LOW);
+  digitalWrite(this->dcMotorPin2, LOW);
+
+  // finish the slow servo approach (or do all of it if the descent was too short for an overlap)
+  if (!closing) {
+    this->clampServo.write(servoPos - inc * slowdownDegrees);
+    this->currentServoPos = servoPos - inc * slowdownDegrees;
+    this->lastServoStepTime = millis();
+  }
+  while (!this->stepServoTowards(servoPos)) {
+    delay(1);
+  }
+
+  this->errors = 0;
+  eventTrace.add(TRACE_MOTION_STOP, this->traceSource, 0);
+  return true;
+}
+
+bool HotplateClampDCMotor::openAndRaise(int servoPos, int slowdownDegrees) {
+  const int timeout = 30000;  // if the target position was not reached after 30 sec, give up
+  const int waitPerStep = 100;
+  unsigned long startTime;
+  int inc;
+
+  if (servoPos == -1) {
+    servoPos = this->servoOpenedPos;
+  }
+  slowdownDegrees = min(abs(this->currentServoPos - servoPos), slowdownDegrees);
+  if (this->currentServoPos >= servoPos) {
+    inc = -1;
+  } else {
+    inc = 1;
+  }
+
+  // Release the container slowly, the stage can start moving up as soon as the clamp does not hold the container anymore
+  for (int i=0; i<slowdownDegrees; i++) {
+    this->currentServoPos += inc;
+    this->clampServo.write(this->currentServoPos);
+    delay(waitPerStep);
+  }
+  this->clampServo.write(servoPos - inc*slowdownDegrees);
+  this->currentServoPos = servoPos - inc*slowdownDegrees;
+  this->lastServoStepTime = millis();
+
+  startTime = millis();
+  this->isAtTop = false;
+  digitalWrite(this->dcMotorPin1, HIGH);
+  digitalWrite(this->dcMotorPin2, LOW);
+
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, 1);
+  while (digitalRead(this->switchPinUp)==HIGH && !isTimedOut(startTime, timeout)) {
+    this->stepServoTowards(servoPos);
+    delayMicroseconds(2000);
+  }
+  if (digitalRead(this->switchPinUp)==LOW) {
+    eventTrace.add(TRACE_LIMIT_SWITCH, this->traceSource, 1);
+  }
+
+  digitalWrite(this->dcMotorPin1, LOW);
+  digitalWrite(this->dcMotorPin2, LOW);
+
+  delayMicroseconds(2000);
+  if (digitalRead(this->switchPinUp)==HIGH) {
+    this->errors = 3;  // timeout
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
+    return false;
+  }
+  this->ascentTime = millis() - startTime;
+
+  // back off a little bit from the top position
+  digitalWrite(this->dcMotorPin1, LOW);
+  digitalWrite(this->dcMotorPin2, HIGH);
+  delay(250);
+  digitalWrite(this->dcMotorPin1, LOW);
+  digitalWrite(this->dcMotorPin2, LOW);
+
+  while (!this->stepServoTowards(servoPos)) {
+    delay(1);
+  }
+
+  this->isAtTop = true;
+  this->errors = 0;
+  eventTrace.add(TRACE_MOTION_STOP, this->traceSource, 0);
+  return true;
+}
@@ -22,11 +22,19 @@ public:
   bool stopStage();
   bool homePosition();
   float getCurrentSensorData(int averages=3);
+  float sampleCurrent();
   void openClamp(int servoPos=-1, int slowdownDegrees=20);
   void closeClamp(int servoPos=-1, int slowdownDegrees=25);
+  bool lowerAndClose(int servoPos=-1, int slowdownDegrees=25);
+  bool openAndRaise(int servoPos=-1, int slowdownDegrees=20);
   int currentServoPos;
+  unsigned long descentTime;  // travel time of the last descent that started at the top position (0: not known yet)
+  unsigned long ascentTime;
+  bool isAtTop;  // true after the stage was raised to the upper limit switch and has not moved since
   byte errors;
+  byte traceSource;
 private:
+  bool stepServoTowards(int servoPos);
   int dcMotorPin1;
   int dcMotorPin2;
   int servoPin;
@@ -35,6 +43,7 @@ private:
   int currentSensorPin;
   int servoClosedPos;
   int servoOpenedPos;
+  unsigned long lastServoStepTime;
   Servo clampServo;
 };
 #endif
@@ -11,12 +11,14 @@
 #include <Servo.h>
 #include "HotplateClampStepperMotor.h"
 #include "HelperFunctions.h"
+#include "EventTrace.h"
 
 HotplateClampStepperMotor::HotplateClampStepperMotor(void) {
 }
 
-HotplateClampStepperMotor::HotplateClampStepperMotor(byte dirPin, byte stepPin, byte sleepPin, byte servoPin, byte switchPin, int servoClosedPos=0, int servoOpenedPos=180, byte microSteppingFactor=1, int stepsPerRevolution=200, float mmPerRevolution=4.0) {
+HotplateClampStepperMotor::HotplateClampStepperMotor(byte dirPin, byte stepPin, byte sleepPin, byte servoPin, byte switchPin, int servoClosedPos, int servoOpenedPos, byte microSteppingFactor, int stepsPerRevolution, float mmPerRevolution, float maxSpeedMmPerSecond, float accelerationMmPerSecond2, int maxPos) {
   const byte motorInterfaceType = 1;  // Motor interface type for AccelStepper library. Must be set to 1 when using a stepper motor driver
+  const float maxStepsPerSecond = 4000.0;  // AccelStepper cannot reliably generate more than about 4000 steps/s on a 16 MHz Arduino
   
   pinMode(dirPin, OUTPUT);
   pinMode(stepPin, OUTPUT);
@@ -25,7 +27,12 @@ HotplateClampStepperMotor::HotplateClampStepperMotor(byte dirPin, byte stepPin,
   pinMode(switchPin, INPUT);
   
   this->currentPos = 100;
+  this->raisedPos = 100;
+  this->maxPos = maxPos;
+  this->isHomed = false;
+  this->lastServoStepTime = 0;
   this->errors = 0;
+  this->traceSource = TRACE_SOURCE_CLAMP;
   
   this->dirPin = dirPin;
   this->stepPin = stepPin;
@@ -37,9 +44,14 @@ HotplateClampStepperMotor::HotplateClampStepperMotor(byte dirPin, byte stepPin,
   this->microSteppingFactor = microSteppingFactor;
   this->stepsPerRevolution = stepsPerRevolution;
   this->mmPerRevolution = mmPerRevolution;
+  this->stepsPerMillimeter = (float)stepsPerRevolution * microSteppingFactor / mmPerRevolution;
+  this->maxSpeed = min(maxSpeedMmPerSecond * this->stepsPerMillimeter, maxStepsPerSecond);
+  this->acceleration = accelerationMmPerSecond2 * this->stepsPerMillimeter;
   
   this->stageStepper = AccelStepper(motorInterfaceType, stepPin, dirPin);
-  this->stageStepper.setMaxSpeed(2400);
+  this->stageStepper.setMaxSpeed(this->maxSpeed);
+  this->stageStepper.setAcceleration(this->acceleration);
+  this->stageStepper.setCurrentPosition(this->mmToSteps(this->currentPos));
   
   this->clampServo = Servo();
   this->clampServo.write(servoOpenedPos);
@@ -47,7 +59,7 @@ HotplateClampStepperMotor::HotplateClampStepperMotor(byte dirPin, byte stepPin,
   this->currentServoPos = servoOpenedPos;
 }
 
-void HotplateClampStepperMotor::takeSteps(int dir, int steps, int stepsPerSecond = 600) {
+void HotplateClampStepperMotor::takeSteps(int dir, int steps, int stepsPerSecond) {
   const int timeout = 15000;  // if the target position was not reached after 15 sec, give up
   unsigned long startTime = millis();
 
@@ -64,55 +76,147 @@ void HotplateClampStepperMotor::takeSteps(int dir, int steps, int stepsPerSecond
   }
 }
 
+long HotplateClampStepperMotor::mmToSteps(float mm) {
+  // The stage moves up (away from the limit switch at the home position) for negative step counts
+  return -lround(mm * this->stepsPerMillimeter);
+}
+
+bool HotplateClampStepperMotor::runToStep(long targetStep, int timeout) {
+  unsigned long startTime = millis();
+
+  this->stageStepper.setMaxSpeed(this->maxSpeed);
+  this->stageStepper.setAcceleration(this->acceleration);
+  this->stageStepper.moveTo(targetStep);
+  while (this->stageStepper.distanceToGo() != 0 && !isTimedOut(startTime, timeout)) {
+    if (this->stageStepper.distanceToGo() > 0 && digitalRead(this->switchPin) == LOW) {
+      // Hit the limit switch while moving down, so the stage is at the home position
+      this->stageStepper.setCurrentPosition(0);
+      eventTrace.add(TRACE_LIMIT_SWITCH, this->traceSource, -1);
+      return (targetStep >= 0);
+    }
+    this->stageStepper.run();
+  }
+  return (this->stageStepper.distanceToGo() == 0);
+}
+
+bool HotplateClampStepperMotor::runUntilSwitch(int dir, float stepsPerSecond, int timeout) {
+  unsigned long startTime = millis();
+
+  this->stageStepper.setSpeed(dir*abs(stepsPerSecond));
+  while (digitalRead(this->switchPin) == HIGH && !isTimedOut(startTime, timeout)) {
+    this->stageStepper.runSpeed();
+  }
+  if (digitalRead(this->switchPin) == LOW) {
+    eventTrace.add(TRACE_LIMIT_SWITCH, this->traceSource, -1);
+    return true;
+  }
+  return false;
+}
+
+bool HotplateClampStepperMotor::rampUntilSwitch(int dir, int timeout) {
+  // Like runUntilSwitch at maxSpeed, but accelerates to it first: the target lies far beyond the travel of the stage, so the move only ends at the switch
+  const float overtravelMillimeters = 1000.0;
+  unsigned long startTime = millis();
+
+  this->stageStepper.setMaxSpeed(this->maxSpeed);
+  this->stageStepper.setAcceleration(this->acceleration);
+  this->stageStepper.moveTo(this->stageStepper.currentPosition() + dir * lround(overtravelMillimeters * this->stepsPerMillimeter));
+  while (digitalRead(this->switchPin) == HIGH && this->stageStepper.distanceToGo() != 0 && !isTimedOut(startTime, timeout)) {
+    this->stageStepper.run();
+  }
+  this->stageStepper.setCurrentPosition(this->stageStepper.currentPosition());  // stop right at the switch, discards the remaining target steps
+  if (digitalRead(this->switchPin) == LOW) {
+    eventTrace.add(TRACE_LIMIT_SWITCH, this->traceSource, -1);
+    return true;
+  }
+  return false;
+}
+
 bool HotplateClampStepperMotor::setCurrentPosition(int currentPos) {
+  this->stageStepper.setCurrentPosition(this->mmToSteps(currentPos));
   this->currentPos = currentPos;
+  this->isHomed = true;  // the position was set by the user instead
   return true;
 }
 
 bool HotplateClampStepperMotor::gotoPosition(int targetPos) {
-  int dir;
-
-  if (targetPos > this->currentPos) {
-    dir = 1;
-  } else {
-    dir = -1;
-  }
+  const int timeout = 30000;  // if the target position was not reached after 30 sec, give up
+  bool success;
 
   digitalWrite(this->sleepPin, HIGH);
-  this->takeSteps(dir, (int)abs(((float)(targetPos - this->currentPos)/this->mmPerRevolution)*this->stepsPerRevolution*this->microSteppingFactor));
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, targetPos);
+  success = this->runToStep(this->mmToSteps(targetPos), timeout);
   digitalWrite(this->sleepPin, LOW);
 
-  this->currentPos = targetPos;
+  if (!success) {
+    this->currentPos = (int)round(-this->stageStepper.currentPosition() / this->stepsPerMillimeter);
+    this->errors = 3;  // timeout or limit switch hit before reaching the target
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
+    return false;
+  }
+
+  // Take the position from the stepper, the limit switch may have ended a move towards the home position early
+  this->currentPos = (int)round(-this->stageStepper.currentPosition() / this->stepsPerMillimeter);
+  this->errors = 0;
+  eventTrace.add(TRACE_MOTION_STOP, this->traceSource, this->currentPos);
   return true;
 }
 
 bool HotplateClampStepperMotor::homePosition() {
   const int dir = 1;
-  const int stepsPerSecond = 600;
+  const float slowStepsPerSecond = 0.5 * this->stepsPerMillimeter;  // 0.5 mm/s for the precise re-approach
+  const float backoffMillimeters = 2.0;
   const int timeout = 30000;  // if the target position was not reached after 30 sec, give up
-  unsigned long startTime = millis();
 
   digitalWrite(this->sleepPin, HIGH);
-  while (digitalRead(this->switchPin)==HIGH && !isTimedOut(startTime, timeout))
-  {
-    this->stageStepper.setSpeed(dir*abs(stepsPerSecond));
-    this->stageStepper.runSpeed();
-    delayMicroseconds(2000);
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, 0);
+
+  // Fast approach, accelerating to full speed, until the limit switch triggers
+  eventTrace.add(TRACE_PHASE, this->traceSource, 1);
+  if (!this->rampUntilSwitch(dir, timeout)) {
+    digitalWrite(this->sleepPin, LOW);
+    this->errors = 3;  // timeout
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
+    return false;
   }
-  digitalWrite(this->sleepPin, LOW);
 
-  delayMicroseconds(2000);
-  if (digitalRead(this->switchPin)==HIGH) {
-    this->errors = 1;  // timeout
-    return false;    
+  // Back off from the switch with an acceleration profile
+  eventTrace.add(TRACE_PHASE, this->traceSource, 2);
+  this->stageStepper.setCurrentPosition(0);
+  this->runToStep(this->mmToSteps(backoffMillimeters), timeout);
+  if (digitalRead(this->switchPin) == LOW) {
+    digitalWrite(this->sleepPin, LOW);
+    this->errors = 1;  // switch did not release, probably stuck
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
+    return false;
+  }
+
+  // Slow and precise re-approach
+  eventTrace.add(TRACE_PHASE, this->traceSource, 3);
+  if (!this->runUntilSwitch(dir, slowStepsPerSecond, timeout)) {
+    digitalWrite(this->sleepPin, LOW);
+    this->errors = 3;  // timeout
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
+    return false;
   }
+  digitalWrite(this->sleepPin, LOW);
 
   this->stageStepper.setCurrentPosition(0);
   this->currentPos = 0;
+  this->isHomed = true;
+  this->errors = 0;
+  eventTrace.add(TRACE_PHASE, this->traceSource, 0);
+  eventTrace.add(TRACE_MOTION_STOP, this->traceSource, 0);
   return true;
 }
 
-void HotplateClampStepperMotor::openClamp(int servoPos=-1, int slowdownDegrees=20) {
+bool HotplateClampStepperMotor::stopStage() {
+  this->stageStepper.setCurrentPosition(this->stageStepper.currentPosition());  // discards any remaining target steps
+  digitalWrite(this->sleepPin, LOW);
+  return true;
+}
+
+void HotplateClampStepperMotor::openClamp(int servoPos, int slowdownDegrees) {
   int inc;
   const int waitPerStep = 100;
 
@@ -142,7 +246,7 @@ void HotplateClampStepperMotor::openClamp(int servoPos=-1, int slowdownDegrees=2
   this->currentServoPos = servoPos;
 }
 
-void HotplateClampStepperMotor::closeClamp(int servoPos=-1, int slowdownDegrees=20) {
+void HotplateClampStepperMotor::closeClamp(int servoPos, int slowdownDegrees) {
   int inc;
   const int waitPerStep = 100;
 
@@ -173,3 +277,166 @@ void HotplateClampStepperMotor::closeClamp(int servoPos=-1, int slowdownDegrees=
 
   this->currentServoPos = servoPos;
 }
+
+long HotplateClampStepperMotor::stepsBeforeStop(unsigned long ms) {
+  // Number of steps the stage still travels during the last ms milliseconds of a move (deceleration ramp followed by cruising at maxSpeed)
+  float t = ms / 1000.0;
+  float rampTime = this->maxSpeed / this->acceleration;
+
+  if (t <= rampTime) {
+    return (long)(0.5 * this->acceleration * t * t);
+  }
+  return (long)(0.5 * this->maxSpeed * rampTime + this->maxSpeed * (t - rampTime));
+}
+
+bool HotplateClampStepperMotor::stepServoTowards(int servoPos) {
+  // Non-blocking version of the slow servo approach: moves the servo by one degree at most every waitPerStep ms
+  const int waitPerStep = 100;
+
+  if (this->currentServoPos == servoPos) {
+    return true;
+  }
+  if (millis() - this->lastServoStepTime >= waitPerStep) {
+    this->currentServoPos += (this->currentServoPos < servoPos) ? 1 : -1;
+    this->clampServo.write(this->currentServoPos);
+    this->lastServoStepTime = millis();
+  }
+  return (this->currentServoPos == servoPos);
+}
+
+bool HotplateClampStepperMotor::lowerAndClose(int servoPos, int slowdownDegrees) {
+  const int timeout = 30000;  // if the target position was not reached after 30 sec, give up
+  const int waitPerStep = 100;
+  const int maxOverlap = 1500;  // start the slow servo approach at most 1500 ms before the stage reaches the bottom
+  unsigned long startTime = millis();
+  long closeStartSteps;
+  bool closing = false;
+  bool success;
+  int inc;
+
+  if (servoPos == -1) {
+    servoPos = this->servoClosedPos;
+  }
+  slowdownDegrees = min(abs(this->currentServoPos - servoPos), slowdownDegrees);
+  if (this->currentServoPos >= servoPos) {
+    inc = -1;
+  } else {
+    inc = 1;
+  }
+  closeStartSteps = this->stepsBeforeStop(min((unsigned long)slowdownDegrees * waitPerStep, (unsigned long)maxOverlap));
+  if (this->currentPos > 0) {
+    this->raisedPos = this->currentPos;
+  }
+
+  digitalWrite(this->sleepPin, HIGH);
+  this->stageStepper.setMaxSpeed(this->maxSpeed);
+  this->stageStepper.setAcceleration(this->acceleration);
+  this->stageStepper.moveTo(this->mmToSteps(0));
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, 0);
+  while (this->stageStepper.distanceToGo() != 0 && !isTimedOut(startTime, timeout)) {
+    if (this->stageStepper.distanceToGo() > 0 && digitalRead(this->switchPin) == LOW) {
+      // Hit the limit switch, so the stage is at the home position
+      this->stageStepper.setCurrentPosition(0);
+      eventTrace.add(TRACE_LIMIT_SWITCH, this->traceSource, -1);
+      break;
+    }
+    if (!closing && abs(this->stageStepper.distanceToGo()) <= closeStartSteps) {
+      this->clampServo.write(servoPos - inc * slowdownDegrees);
+      this->currentServoPos = servoPos - inc * slowdownDegrees;
+      this->lastServoStepTime = millis();
+      closing = true;
+    } else if (closing) {
+      this->stepServoTowards(servoPos);
+    }
+    this->stageStepper.run();
+  }
+  success = (this->stageStepper.distanceToGo() == 0);
+  digitalWrite(this->sleepPin, LOW);
+
+  this->currentPos = (int)round(-this->stageStepper.currentPosition() / this->stepsPerMillimeter);
+  if (!success) {
+    this->errors = 3;  // timeout
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
+    return false;
+  }
+
+  if (!closing) {
+    this->clampServo.write(servoPos - inc * slowdownDegrees);
+    this->currentServoPos = servoPos - inc * slowdownDegrees;
+    this->lastServoStepTime = millis();
+  }
+  while (!this->stepServoTowards(servoPos)) {
+    delay(1);
+  }
+
+  this->errors = 0;
+  eventTrace.add(TRACE_MOTION_STOP, this->traceSource, this->currentPos);
+  return true;
+}
+
+bool HotplateClampStepperMotor::openAndRaise(int targetPos, int servoPos, int slowdownDegrees) {
+  const int timeout = 30000;  // if the target position was not reached after 30 sec, give up
+  const int waitPerStep = 100;
+  unsigned long startTime;
+  bool success;
+  int inc;
+
+  if (targetPos == -1) {
+    targetPos = this->raisedPos;
+  }
+  if (servoPos == -1) {
+    servoPos = this->servoOpenedPos;
+  }
+  slowdownDegrees = min(abs(this->currentServoPos - servoPos), slowdownDegrees);
+  if (this->currentServoPos >= servoPos) {
+    inc = -1;
+  } else {
+    inc = 1;
+  }
+
+  // Release the container slowly, the stage can start moving up as soon as the clamp does not hold the container anymore
+  for (int i=0; i<slowdownDegrees; i++) {
+    this->currentServoPos += inc;
+    this->clampServo.write(this->currentServoPos);
+    delay(waitPerStep);
+  }
+  this->clampServo.write(servoPos - inc*slowdownDegrees);
+  this->currentServoPos = servoPos - inc*slowdownDegrees;
+  this->lastServoStepTime = millis();
+
+  // Open the rest of the way while the stage is moving up
+  startTime = millis();
+  digitalWrite(this->sleepPin, HIGH);
+  this->stageStepper.setMaxSpeed(this->maxSpeed);
+  this->stageStepper.setAcceleration(this->acceleration);
+  this->stageStepper.moveTo(this->mmToSteps(targetPos));
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, targetPos);
+  while (this->stageStepper.distanceToGo() != 0 && !isTimedOut(startTime, timeout)) {
+    if (this->stageStepper.distanceToGo() > 0 && digitalRead(this->switchPin) == LOW) {
+      // Hit the limit switch while moving down, so the stage is at the home position
+      this->stageStepper.setCurrentPosition(0);
+      eventTrace.add(TRACE_LIMIT_SWITCH, this->traceSource, -1);
+      break;
+    }
+    this->stepServoTowards(servoPos);
+    this->stageStepper.run();
+  }
+  success = (this->stageStepper.distanceToGo() == 0 && this->stageStepper.currentPosition() == this->mmToSteps(targetPos));
+  digitalWrite(this->sleepPin, LOW);
+
+  while (!this->stepServoTowards(servoPos)) {
+    delay(1);
+  }
+
+  if (!success) {
+    this->currentPos = (int)round(-this->stageStepper.currentPosition() / this->stepsPerMillimeter);
+    this->errors = 3;  // timeout or limit switch hit before reaching the target
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
+    return false;
+  }
+
+  this->currentPos = targetPos;
+  this->errors = 0;
+  eventTrace.add(TRACE_MOTION_STOP, this->traceSource, this->currentPos);
+  return true;
+}
@@ -15,17 +15,30 @@
 class HotplateClampStepperMotor {
 public:
   HotplateClampStepperMotor(void);
-  HotplateClampStepperMotor(byte dirPin, byte stepPin, byte sleepPin, byte servoPin, byte switchPin, int servoClosedPos=0, int servoOpenedPos=180, byte microSteppingFactor=1, int stepsPerRevolution=200, float mmPerRevolution=4.0);
+  HotplateClampStepperMotor(byte dirPin, byte stepPin, byte sleepPin, byte servoPin, byte switchPin, int servoClosedPos=0, int servoOpenedPos=180, byte microSteppingFactor=1, int stepsPerRevolution=200, float mmPerRevolution=4.0, float maxSpeedMmPerSecond=8.0, float accelerationMmPerSecond2=40.0, int maxPos=100);
   void takeSteps(int dir, int steps, int stepsPerSecond=600);
   bool gotoPosition(int targetPos);
   bool homePosition();
   bool setCurrentPosition(int currentPos);
+  bool stopStage();
   void openClamp(int servoPos=-1, int slowdownDegrees=20);
   void closeClamp(int servoPos=-1, int slowdownDegrees=20);
+  bool lowerAndClose(int servoPos=-1, int slowdownDegrees=20);
+  bool openAndRaise(int targetPos=-1, int servoPos=-1, int slowdownDegrees=20);
   int currentPos;
+  int raisedPos;
+  int maxPos;  // travel of the stage in mm above the home position
   int currentServoPos;
+  bool isHomed;  // false until the stage was homed or its position was set, absolute moves are refused before that
   byte errors;
+  byte traceSource;
 private:
+  long mmToSteps(float mm);
+  bool runToStep(long targetStep, int timeout);
+  bool runUntilSwitch(int dir, float stepsPerSecond, int timeout);
+  bool rampUntilSwitch(int dir, int timeout);
+  long stepsBeforeStop(unsigned long ms);
+  bool stepServoTowards(int servoPos);
   int dirPin;
   int stepPin;
   int sleepPin;
@@ -36,6 +49,10 @@ private:
   int microSteppingFactor;
   int stepsPerRevolution;
   float mmPerRevolution;
+  float stepsPerMillimeter;
+  float maxSpeed;
+  float acceleration;
+  unsigned long lastServoStepTime;
   AccelStepper stageStepper;
   Servo clampServo;
 };
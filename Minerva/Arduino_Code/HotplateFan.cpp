@@ -16,12 +16,79 @@ HotplateFan::HotplateFan(void) {
 HotplateFan::HotplateFan(byte enablePin) {
   pinMode(enablePin, OUTPUT);
   this->enablePin = enablePin;
+  this->state = FAN_OFF;
+  this->duty = 0;
+  this->targetTemperature = NAN;
+  this->duration = 0;
+  this->startTime = 0;
+  this->isKickStarting = false;
+  this->writeOutput(0);
 }
 
-void HotplateFan::turnOn(void) {
-  digitalWrite(this->enablePin, HIGH);
+void HotplateFan::turnOn(byte duty) {
+  this->coolDown(duty, 0);
+  this->state = FAN_ON;
 }
 
 void HotplateFan::turnOff(void) {
-  digitalWrite(this->enablePin, LOW);
-}
\ No newline at end of file
+  this->state = FAN_OFF;
+  this->duty = 0;
+  this->isKickStarting = false;
+  this->writeOutput(0);
+}
+
+void HotplateFan::coolDown(byte duty, unsigned long duration, float targetTemperature) {
+  // Starts a cool-down profile that is run in the background by update(): the fan runs with <duty> until the temperature drops below
+  // <targetTemperature> (if given) or until <duration> ms have passed (0: no time limit), then it is turned off
+  if (duty == 0) {
+    this->turnOff();
+    return;
+  }
+  // A fan that is standing still might not start with a low duty, so it is started with full speed first
+  this->isKickStarting = (this->duty == 0 && duty < 255 && digitalPinHasPWM(this->enablePin));
+  this->state = FAN_COOLING_DOWN;
+  this->duty = duty;
+  this->targetTemperature = targetTemperature;
+  this->duration = duration;
+  this->startTime = millis();
+  this->writeOutput(this->isKickStarting ? 255 : this->duty);
+}
+
+void HotplateFan::update(float temperature) {
+  // Runs the cool-down profile, should be called regularly with the latest temperature reading (NAN if no valid reading is available, in
+  // that case only the duration ends the profile)
+  const unsigned long kickStartTime = 300;  // in ms
+
+  if (this->state == FAN_OFF) {
+    return;
+  }
+  if (this->isKickStarting && millis() - this->startTime >= kickStartTime) {
+    this->isKickStarting = false;
+    this->writeOutput(this->duty);
+  }
+  if (this->state != FAN_COOLING_DOWN) {
+    return;
+  }
+  if (this->duration > 0 && millis() - this->startTime >= this->duration) {
+    this->turnOff();
+  } else if (!isnan(this->targetTemperature) && !isnan(temperature) && temperature < this->targetTemperature) {
+    this->turnOff();
+  }
+}
+
+unsigned long HotplateFan::getRemainingTime(void) {
+  // Maximum remaining time of the cool-down profile in ms (0 if it has no time limit or if no profile is running)
+  if (this->state != FAN_COOLING_DOWN || this->duration == 0) {
+    return 0;
+  }
+  return this->duration - min(millis() - this->startTime, this->duration);
+}
+
+void HotplateFan::writeOutput(byte duty) {
+  // Fans on pins without hardware PWM can only be switched on or off, they run with full speed for any duty above 0
+  if (digitalPinHasPWM(this->enablePin)) {
+    analogWrite(this->enablePin, duty);
+  } else {
+    digitalWrite(this->enablePin, (duty > 0) ? HIGH : LOW);
+  }
+}
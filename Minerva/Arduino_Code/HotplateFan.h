@@ -10,13 +10,29 @@
 #define HotplateFan_h
 #include <Arduino.h>
 #include "HelperFunctions.h"
+
+// States of the fan
+const byte FAN_OFF = 0;
+const byte FAN_ON = 1;
+const byte FAN_COOLING_DOWN = 2;  // runs a cool-down profile and turns off by itself
+
 class HotplateFan {
 public:
   HotplateFan(void);
   HotplateFan(byte enablePin);
-  void turnOn();
+  void turnOn(byte duty=255);
   void turnOff();
+  void coolDown(byte duty, unsigned long duration, float targetTemperature=NAN);
+  void update(float temperature);
+  unsigned long getRemainingTime(void);
+  byte state;
+  byte duty;
+  float targetTemperature;
 private:
+  void writeOutput(byte duty);
   int enablePin;
+  unsigned long duration;
+  unsigned long startTime;
+  bool isKickStarting;
 };
 #endif
@@ -0,0 +1,236 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <Arduino.h>
+#include "RuntimeStatistics.h"
+#include "EventTrace.h"
+
+#if defined(__AVR__)
+extern char __heap_start;
+extern char *__brkval;
+#endif
+
+RuntimeStatistics::RuntimeStatistics(void) {
+  this->reset();
+}
+
+void RuntimeStatistics::reset() {
+  for (byte i = 0; i < STATS_COMMAND_TYPES; i++) {
+    this->commands[i].count = 0;
+    this->commands[i].minTime = 0xFFFFFFFF;
+    this->commands[i].maxTime = 0;
+    this->commands[i].totalTime = 0;
+    for (byte j = 0; j < STATS_HISTOGRAM_BINS; j++) {
+      this->commands[i].histogram[j] = 0;
+    }
+  }
+  this->commandType = 0;
+  this->isCommandRunning = false;
+  this->startTime = millis();
+  this->loopCount = 0;
+  this->loopStartTime = 0;
+  this->lastLoopPeriod = 0;
+  this->minLoopPeriod = 0xFFFFFFFF;
+  this->maxLoopPeriod = 0;
+  this->totalLoopPeriod = 0;
+  this->totalLoopJitter = 0;
+  this->jitterCount = 0;
+  this->wasIdle = false;
+  this->commandTime = 0;
+  this->waitTime = 0;
+  this->hasWaitPoll = false;
+  this->samplingTime = 0;
+  this->idleTime = 0;
+  this->serialBufferFull = 0;
+  this->paintStack();
+}
+
+void RuntimeStatistics::loopStarted() {
+  // Period and jitter are only taken from iterations without a command, which only consist of the idle phase
+  unsigned long now = micros();
+  unsigned long period = now - this->loopStartTime;
+
+  if (this->wasIdle) {
+    this->loopCount++;
+    this->totalLoopPeriod += period;
+    this->minLoopPeriod = min(this->minLoopPeriod, period);
+    this->maxLoopPeriod = max(this->maxLoopPeriod, period);
+    if (this->lastLoopPeriod > 0) {
+      this->totalLoopJitter += (period > this->lastLoopPeriod) ? period - this->lastLoopPeriod : this->lastLoopPeriod - period;
+      this->jitterCount++;
+    }
+    this->lastLoopPeriod = period;
+  } else {
+    this->lastLoopPeriod = 0;
+  }
+  this->loopStartTime = now;
+  this->wasIdle = true;
+}
+
+void RuntimeStatistics::commandStarted(String command) {
+  this->commandType = getTraceSource(command) >> 4;  // device type of the command
+  this->wasIdle = false;
+  this->isCommandRunning = true;
+  this->hasWaitPoll = false;
+  this->commandStartTime = micros();
+}
+
+void RuntimeStatistics::commandFinished() {
+  // The execution time ends when the reply has been handed to the serial buffer (it may still be transmitting)
+  unsigned long duration = micros() - this->commandStartTime;
+  CommandStatistics *s = &this->commands[this->commandType];
+  unsigned long limit = 1000;  // upper limit of the first histogram bin in us
+  byte bin = 0;
+
+  if (!this->isCommandRunning) {
+    return;
+  }
+  this->isCommandRunning = false;
+  s->count++;
+  s->minTime = min(s->minTime, duration);
+  s->maxTime = max(s->maxTime, duration);
+  s->totalTime += duration;
+  while (bin < STATS_HISTOGRAM_BINS - 1 && duration >= limit) {
+    bin++;
+    limit *= 4;
+  }
+  if (s->histogram[bin] < 0xFFFF) {
+    s->histogram[bin]++;
+  }
+  this->commandTime += duration;
+}
+
+void RuntimeStatistics::waitPolled() {
+  // Called from yield(): a command that keeps calling delay() or isTimedOut() is waiting for a device, so the time between two closely
+  // spaced calls is counted as waiting. The time before the first and after the last call, and longer gaps, are computation.
+  unsigned long now = micros();
+
+  if (!this->isCommandRunning) {
+    return;
+  }
+  if (this->hasWaitPoll && now - this->lastWaitPollTime <= STATS_WAIT_POLL_GAP) {
+    this->waitTime += now - this->lastWaitPollTime;
+  }
+  this->lastWaitPollTime = now;
+  this->hasWaitPoll = true;
+}
+
+void RuntimeStatistics::idleStarted() {
+  this->idleStartTime = micros();
+}
+
+void RuntimeStatistics::idleFinished() {
+  this->idleTime += micros() - this->idleStartTime;
+}
+
+void RuntimeStatistics::samplingStarted() {
+  this->samplingStartTime = micros();
+}
+
+void RuntimeStatistics::samplingFinished() {
+  this->samplingTime += micros() - this->samplingStartTime;
+}
+
+void RuntimeStatistics::checkSerialBuffer() {
+  // The serial port silently drops incoming bytes while its receive buffer is full (i.e., while a long command runs and more is sent)
+  if (Serial.available() >= SERIAL_RX_BUFFER_SIZE - 1) {
+    this->serialBufferFull++;
+  }
+}
+
+void RuntimeStatistics::paintStack() {
+  // Fills the free memory between the end of the heap and the current stack with a pattern, so the lowest address ever reached by the stack
+  // (including the interrupts) can be found later. Stops a few bytes below the current stack pointer to leave room for this function.
+#if defined(__AVR__)
+  uint8_t marker;
+  uint8_t *p = (uint8_t *)((__brkval == 0) ? &__heap_start : __brkval);
+  while (p < &marker - 32) {
+    *p++ = STATS_STACK_PAINT;
+  }
+#endif
+}
+
+unsigned int RuntimeStatistics::getStackPeak() {
+  // Scans down from the stack pointer: the deepest point of the stack is just above the first run of STATS_STACK_PAINT_RUN painted bytes.
+  // Scanning up from the end of the heap does not work, because free() lowers __brkval and leaves the old heap data above it.
+  // A few bytes of the stack that happen to match the pattern are skipped, since they do not form a long enough run.
+#if defined(__AVR__)
+  uint8_t *heapEnd = (uint8_t *)((__brkval == 0) ? &__heap_start : __brkval);
+  uint8_t *p = (uint8_t *)SP;
+  byte run = 0;
+
+  while (p >= heapEnd) {
+    if (*p == STATS_STACK_PAINT) {
+      run++;
+      if (run >= STATS_STACK_PAINT_RUN) {
+        return RAMEND - (unsigned int)(p + run - 1);  // everything above the highest painted byte of the run was used by the stack
+      }
+    } else {
+      run = 0;
+    }
+    p--;
+  }
+  return RAMEND - (unsigned int)heapEnd + 1;  // no painted memory left, the stack reached the heap
+#else
+  return 0;
+#endif
+}
+
+void RuntimeStatistics::printCommandTypeName(byte commandType) {
+  switch (commandType) {
+    case 1: Serial.print(F("valve")); break;
+    case 2: Serial.print(F("magnet")); break;
+    case 3: Serial.print(F("clamp")); break;
+    case 4: Serial.print(F("fan")); break;
+    case 5: Serial.print(F("dht22sensor")); break;
+    case 6: Serial.print(F("capper")); break;
+    default: Serial.print(F("general")); break;
+  }
+}
+
+void RuntimeStatistics::print() {
+  // Compact report, one line per group:
+  // TIME <uptime of the statistics ms>;<executing commands without waiting ms>;<waiting in delay() and isTimedOut() during commands ms>;<idle phase ms>;
+  //      <background sampling during the idle phase ms>
+  // LOOP <idle iterations>;<min period us>;<mean period us>;<max period us>;<mean jitter us>
+  // SERIAL <receive buffer found full>
+  // MEMORY <heap bytes>;<stack bytes>;<peak stack bytes>;<minimum free bytes>
+  // CMD <type> <count>;<min us>;<mean us>;<max us>;<histogram counts separated by commas> (only for the command types that were used)
+  unsigned int heap = 0;
+  unsigned int stack = 0;
+  unsigned int stackPeak = this->getStackPeak();
+  unsigned int freeMemory = 0;
+
+#if defined(__AVR__)
+  char *heapEnd = (__brkval == 0) ? &__heap_start : __brkval;
+  heap = (unsigned int)(heapEnd - &__heap_start);
+  stack = RAMEND - SP;
+  freeMemory = RAMEND - (unsigned int)heapEnd + 1 - stackPeak;
+#endif
+  Serial.print(F("STATS>TIME "));
+  Serial.print(String(millis() - this->startTime) + ";" + String((unsigned long)((this->commandTime - min(this->waitTime, this->commandTime)) / 1000)) + ";" + String((unsigned long)(this->waitTime / 1000)) + ";" + String((unsigned long)(this->idleTime / 1000)) + ";" + String((unsigned long)(this->samplingTime / 1000)) + "\n");
+  Serial.print(F("STATS>LOOP "));
+  Serial.print(String(this->loopCount) + ";" + String((this->loopCount > 0) ? this->minLoopPeriod : 0) + ";" + String((this->loopCount > 0) ? (unsigned long)(this->totalLoopPeriod / this->loopCount) : 0) + ";" + String(this->maxLoopPeriod) + ";" + String((this->jitterCount > 0) ? (unsigned long)(this->totalLoopJitter / this->jitterCount) : 0) + "\n");
+  Serial.print(F("STATS>SERIAL "));
+  Serial.print(String(this->serialBufferFull) + "\n");
+  Serial.print(F("STATS>MEMORY "));
+  Serial.print(String(heap) + ";" + String(stack) + ";" + String(stackPeak) + ";" + String(freeMemory) + "\n");
+  for (byte i = 0; i < STATS_COMMAND_TYPES; i++) {
+    CommandStatistics *s = &this->commands[i];
+    if (s->count == 0) {
+      continue;
+    }
+    Serial.print(F("STATS>CMD "));
+    this->printCommandTypeName(i);
+    Serial.print(" " + String(s->count) + ";" + String(s->minTime) + ";" + String((unsigned long)(s->totalTime / s->count)) + ";" + String(s->maxTime) + ";");
+    for (byte j = 0; j < STATS_HISTOGRAM_BINS; j++) {
+      Serial.print(String(s->histogram[j]) + ((j < STATS_HISTOGRAM_BINS - 1) ? "," : "\n"));
+    }
+  }
+  Serial.println(F("STATS>OK"));
+}
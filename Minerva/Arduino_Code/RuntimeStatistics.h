@@ -0,0 +1,71 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#ifndef RuntimeStatistics_h
+#define RuntimeStatistics_h
+#include <Arduino.h>
+
+const byte STATS_COMMAND_TYPES = 7;  // general (esr, ces, help, stats, unknown), valve, magnet, clamp, fan, dht22sensor, capper
+const byte STATS_HISTOGRAM_BINS = 8;  // execution times below 1, 4, 16, 64, 256, 1024, 4096 ms and above
+const byte STATS_STACK_PAINT = 0xC5;  // pattern written to the free memory between heap and stack
+const byte STATS_STACK_PAINT_RUN = 16;  // number of consecutive painted bytes that mark memory the stack has never reached
+const unsigned int STATS_WAIT_POLL_GAP = 2000;  // in us, longer gaps between two calls of yield() during a command are counted as work, not waiting
+
+struct CommandStatistics {
+  unsigned long count;
+  unsigned long minTime;  // in us
+  unsigned long maxTime;  // in us
+  unsigned long long totalTime;  // in us
+  unsigned int histogram[STATS_HISTOGRAM_BINS];
+};
+
+class RuntimeStatistics {
+public:
+  RuntimeStatistics(void);
+  void reset(void);
+  void loopStarted(void);
+  void commandStarted(String command);
+  void commandFinished(void);
+  void waitPolled(void);
+  void idleStarted(void);
+  void idleFinished(void);
+  void samplingStarted(void);
+  void samplingFinished(void);
+  void checkSerialBuffer(void);
+  void print(void);
+private:
+  void paintStack(void);
+  void printCommandTypeName(byte commandType);
+  unsigned int getStackPeak(void);
+  CommandStatistics commands[STATS_COMMAND_TYPES];
+  byte commandType;
+  bool isCommandRunning;
+  unsigned long commandStartTime;  // in us
+  unsigned long startTime;  // in ms, start of the statistics
+  // Period of the idle iterations of loop()
+  unsigned long loopCount;
+  unsigned long loopStartTime;  // in us
+  unsigned long lastLoopPeriod;  // in us
+  unsigned long minLoopPeriod;  // in us
+  unsigned long maxLoopPeriod;  // in us
+  unsigned long long totalLoopPeriod;  // in us
+  unsigned long long totalLoopJitter;  // in us, sum of the changes of the period between successive idle iterations
+  unsigned long jitterCount;
+  bool wasIdle;  // the previous iteration of loop() did not execute a command
+  // Time budget
+  unsigned long long commandTime;  // in us, executing commands (loop() is blocked)
+  unsigned long long waitTime;  // in us, part of commandTime spent polling in delay() and in the isTimedOut() loops
+  unsigned long lastWaitPollTime;  // in us
+  bool hasWaitPoll;  // yield() was already called during the current command
+  unsigned long long samplingTime;  // in us, background sampling of the sensors while idle
+  unsigned long long idleTime;  // in us, idle phase of loop() including the background sampling
+  unsigned long idleStartTime;  // in us
+  unsigned long samplingStartTime;  // in us
+  unsigned long serialBufferFull;  // number of times the serial receive buffer was found full (bytes were probably lost)
+};
+#endif
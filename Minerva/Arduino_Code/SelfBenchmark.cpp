@@ -0,0 +1,101 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <Arduino.h>
+#include <AccelStepper.h>
+#include "SelfBenchmark.h"
+
+float benchmarkDelayMicroseconds(unsigned int delayTime) {
+  // Mean duration of delayMicroseconds(delayTime), including the overhead of the call and of micros()
+  unsigned long startTime = micros();
+
+  for (int i = 0; i < BENCH_REPETITIONS; i++) {
+    delayMicroseconds(delayTime);
+  }
+  return (float)(micros() - startTime) / BENCH_REPETITIONS;
+}
+
+float benchmarkAnalogRead(int pin) {
+  // Mean duration of one conversion of the analog input <pin>
+  unsigned long startTime;
+
+  analogRead(pin);  // select the channel first
+  startTime = micros();
+  for (int i = 0; i < BENCH_REPETITIONS; i++) {
+    analogRead(pin);
+  }
+  return (float)(micros() - startTime) / BENCH_REPETITIONS;
+}
+
+int benchmarkAnalogSettling(int pin, int otherPin, unsigned int settleTime) {
+  // Deviation (in ADC counts) of the first reading of <pin> after reading <otherPin> and waiting <settleTime> us from the settled value of <pin>.
+  // Shows whether the discarded first readings and the settle delays of the drivers are needed (and long enough) with the actual wiring.
+  long settled = 0;
+  int deviation = 0;
+  int reading;
+
+  analogRead(pin);
+  for (int i = 0; i < 8; i++) {
+    settled += analogRead(pin);
+  }
+  settled /= 8;
+  for (int i = 0; i < 8; i++) {
+    analogRead(otherPin);
+    delayMicroseconds(settleTime);
+    reading = analogRead(pin);
+    deviation = max(deviation, abs(reading - (int)settled));
+  }
+  return deviation;
+}
+
+float benchmarkDigitalWrite(byte pin) {
+  // Mean duration of digitalWrite(), the pin is left LOW
+  unsigned long startTime = micros();
+
+  for (int i = 0; i < BENCH_REPETITIONS / 2; i++) {
+    digitalWrite(pin, HIGH);
+    digitalWrite(pin, LOW);
+  }
+  return (float)(micros() - startTime) / (2 * (BENCH_REPETITIONS / 2));
+}
+
+float benchmarkStepRate(byte stepPin, byte dirPin) {
+  // Highest step rate (in steps per second) that AccelStepper::runSpeed() achieves on this board. The motor driver of the pins has to be disabled.
+  const float requestedSpeed = 20000;  // more than the board can reach
+  AccelStepper stepper = AccelStepper(1, stepPin, dirPin);
+  unsigned long startTime;
+  unsigned long duration;
+  long steps = 0;
+
+  stepper.setMaxSpeed(requestedSpeed);
+  stepper.setSpeed(requestedSpeed);
+  startTime = micros();
+  do {
+    if (stepper.runSpeed()) {
+      steps++;
+    }
+    duration = micros() - startTime;
+  } while (duration < BENCH_STEP_TIME * 1000UL);
+  digitalWrite(stepPin, LOW);
+  return steps * 1000000.0 / duration;
+}
+
+unsigned long benchmarkSerial(String prefix) {
+  // Time needed to send a line of BENCH_SERIAL_BYTES bytes (including the line feed), starting with an empty transmit buffer
+  String line = prefix + ">TX ";
+  unsigned long startTime;
+
+  while (line.length() < BENCH_SERIAL_BYTES - 1) {
+    line += "-";
+  }
+  Serial.flush();
+  startTime = micros();
+  Serial.print(line + "\n");
+  Serial.flush();
+  return micros() - startTime;
+}
@@ -0,0 +1,24 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#ifndef SelfBenchmark_h
+#define SelfBenchmark_h
+#include <Arduino.h>
+
+const int BENCH_REPETITIONS = 100;  // repetitions of the short measurements (analogRead, digitalWrite, delayMicroseconds, Servo.write)
+const int BENCH_STEP_TIME = 100;  // in ms, duration of the step rate measurement
+const int BENCH_SERIAL_BYTES = 120;  // bytes sent for the serial throughput measurement
+
+// Timing measurements of the board, used by the "bench" command. All times are in us.
+float benchmarkDelayMicroseconds(unsigned int delayTime);
+float benchmarkAnalogRead(int pin);
+int benchmarkAnalogSettling(int pin, int otherPin, unsigned int settleTime);
+float benchmarkDigitalWrite(byte pin);
+float benchmarkStepRate(byte stepPin, byte dirPin);
+unsigned long benchmarkSerial(String prefix);
+#endif
@@ -0,0 +1,95 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include "SoftPWM.h"
+
+byte softPWMPin[SOFT_PWM_CHANNEL_COUNT] = {0xFF, 0xFF};  // pin of each channel (0xFF: none)
+
+#if defined(__AVR__)
+// Timer2 runs in fast PWM mode with the output pins disconnected: the overflow interrupt sets the pins of all active channels at the start of
+// every period, the compare match interrupt of each channel clears its pin again. OCR2A/B are double buffered, a new duty starts with the next period.
+volatile uint8_t *softPWMPort[SOFT_PWM_CHANNEL_COUNT];
+volatile byte softPWMMask[SOFT_PWM_CHANNEL_COUNT] = {0, 0};  // bit mask of the pin of each active channel, 0 if the channel is inactive
+
+ISR(TIMER2_OVF_vect) {
+  // The compare match interrupts have a higher priority: if another interrupt delayed this one past a short pulse, the compare match has
+  // already cleared the pin and setting it now would keep it HIGH for the whole period, so the pulse is skipped for this period instead
+  byte count = TCNT2;
+  if (softPWMMask[0] && count < OCR2A) {
+    *softPWMPort[0] |= softPWMMask[0];
+  }
+  if (softPWMMask[1] && count < OCR2B) {
+    *softPWMPort[1] |= softPWMMask[1];
+  }
+}
+
+ISR(TIMER2_COMPA_vect) {
+  if (softPWMMask[0]) {
+    *softPWMPort[0] &= ~softPWMMask[0];
+  }
+}
+
+ISR(TIMER2_COMPB_vect) {
+  if (softPWMMask[1]) {
+    *softPWMPort[1] &= ~softPWMMask[1];
+  }
+}
+
+void softPWMWrite(byte channel, byte pin, byte duty) {
+  // Sets the duty cycle (0-255) of <pin> on <channel>. 0 and 255 write the pin LOW or HIGH without interrupts, a different pin releases
+  // the previous pin of the channel (LOW).
+  if (channel >= SOFT_PWM_CHANNEL_COUNT) {
+    return;
+  }
+
+  noInterrupts();
+  softPWMMask[channel] = 0;
+  interrupts();
+  if (softPWMPin[channel] != pin && softPWMPin[channel] != 0xFF) {
+    digitalWrite(softPWMPin[channel], LOW);
+  }
+  softPWMPin[channel] = pin;
+  pinMode(pin, OUTPUT);
+  if (duty == 0 || duty == 255) {
+    digitalWrite(pin, duty == 0 ? LOW : HIGH);
+    if (softPWMMask[0] == 0 && softPWMMask[1] == 0) {
+      TIMSK2 = 0;
+    }
+    return;
+  }
+
+  if (TIMSK2 == 0) {
+    TCCR2A = _BV(WGM21) | _BV(WGM20);  // fast PWM, TOP = 0xFF, OC2A/OC2B disconnected
+    TCCR2B = _BV(CS22);  // prescaler of 64, 976.6 Hz at 16 MHz
+  }
+  if (channel == SOFT_PWM_CHANNEL_A) {
+    OCR2A = duty;
+  } else {
+    OCR2B = duty;
+  }
+  noInterrupts();
+  softPWMPort[channel] = portOutputRegister(digitalPinToPort(pin));
+  softPWMMask[channel] = digitalPinToBitMask(pin);
+  TIMSK2 = _BV(TOIE2) | _BV(OCIE2A) | _BV(OCIE2B);
+  interrupts();
+}
+
+#else
+// Other cores (and the host build): hardware PWM of the core
+void softPWMWrite(byte channel, byte pin, byte duty) {
+  if (channel >= SOFT_PWM_CHANNEL_COUNT) {
+    return;
+  }
+  if (softPWMPin[channel] != pin && softPWMPin[channel] != 0xFF) {
+    analogWrite(softPWMPin[channel], 0);
+  }
+  softPWMPin[channel] = pin;
+  pinMode(pin, OUTPUT);
+  analogWrite(pin, duty);
+}
+#endif
@@ -0,0 +1,20 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#ifndef SoftPWM_h
+#define SoftPWM_h
+#include <Arduino.h>
+
+// Software PWM with 8 bit resolution at about 976 Hz on two arbitrary output pins. The Servo library occupies Timer5 (and with it the hardware
+// PWM of pins 44-46), so the pulses are generated by the overflow and compare match interrupts of Timer2 (tone() is not used in this sketch).
+const byte SOFT_PWM_CHANNEL_A = 0;  // compare match A of Timer2
+const byte SOFT_PWM_CHANNEL_B = 1;  // compare match B of Timer2
+const byte SOFT_PWM_CHANNEL_COUNT = 2;
+
+void softPWMWrite(byte channel, byte pin, byte duty);
+#endif
@@ -11,11 +11,12 @@
 #include <AccelStepper.h>
 #include "SwitchingValve.h"
 #include "HelperFunctions.h"
+#include "EventTrace.h"
 
 SwitchingValve::SwitchingValve(void) {
 }
 
-SwitchingValve::SwitchingValve(byte dirPin, byte stepPin, byte sleepPin, int hallSensorPin, byte microSteppingFactor=1, int stepsPerRevolution=200, byte reversedPolarityPos=3, byte ports=6, bool clockwiseNumbering=false, bool enableIsHigh=true) {
+SwitchingValve::SwitchingValve(byte dirPin, byte stepPin, byte sleepPin, int hallSensorPin, byte microSteppingFactor, int stepsPerRevolution, byte reversedPolarityPos, byte ports, bool clockwiseNumbering, bool enableIsHigh) {
   const byte motorInterfaceType = 1;  // Motor interface type for AccelStepper library. Must be set to 1 when using a stepper motor driver
   
   pinMode(dirPin, OUTPUT);
@@ -27,6 +28,7 @@ SwitchingValve::SwitchingValve(byte dirPin, byte stepPin, byte sleepPin, int hal
   this->errors = 0;
   this->hallSensorIdleSignal = 0;
   this->hallSensorThreshold = 0;
+  this->traceSource = TRACE_SOURCE_VALVE;
   
   this->dirPin = dirPin;
   this->stepPin = stepPin;
@@ -46,7 +48,7 @@ SwitchingValve::SwitchingValve(byte dirPin, byte stepPin, byte sleepPin, int hal
   this->logHallSensorData = false;  // set to true for debugging
 }
 
-void SwitchingValve::takeSteps(int dir, int steps, int stepsPerSec = 400) {
+void SwitchingValve::takeSteps(int dir, int steps, int stepsPerSec) {
   stepsPerSec *= this->microSteppingFactor;
   if (this->clockwiseNumbering) {
     dir *= -1;
@@ -59,7 +61,7 @@ void SwitchingValve::takeSteps(int dir, int steps, int stepsPerSec = 400) {
   }
 }
 
-int SwitchingValve::readHallSensorSignal(bool logResults=true) {
+int SwitchingValve::readHallSensorSignal(bool logResults) {
   int hallAnalogSignal=0;
   const int AVG = 4;
   
@@ -101,6 +103,7 @@ bool SwitchingValve::gotoPosition(byte targetPos) {
   }
 
   digitalWrite(this->sleepPin, this->enableIsHigh);
+  eventTrace.add(TRACE_MOTION_START, this->traceSource, targetPos);
   // Coarse adjustment: move in multiple steps
   while (signalCounter <= signalSteps) {
     this->takeSteps(dir, mul, this->stepsPerSecond);
@@ -108,27 +111,32 @@ bool SwitchingValve::gotoPosition(byte targetPos) {
     if (isTimedOut(startTime, timeout)) {
       digitalWrite(this->sleepPin, !(this->enableIsHigh));
       this->errors = 3;
+      eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
       return true;  
     }
     hallSignal = this->readHallSensorSignal();
     if (!isAboveThreshold && ((abs(hallSignal - this->hallSensorIdleSignal) >= this->hallSensorThreshold))) {
       signalCounter ++;
       isAboveThreshold = true;
+      eventTrace.add(TRACE_HALL_PEAK, this->traceSource, hallSignal - this->hallSensorIdleSignal);
     }
     if ((abs(hallSignal - this->hallSensorIdleSignal) < this->hallSensorThreshold)) {
       isAboveThreshold = false;
-      if (signalCounter == signalSteps) {
+      if (signalCounter == signalSteps && mul != this->microSteppingFactor) {
         mul = this->microSteppingFactor;  // Reduce step width on falling flank of second to last peak for more precision when approaching last peak
+        eventTrace.add(TRACE_PHASE, this->traceSource, 1);
       }
     }
   }
 
   // Fine adjustment: move in single steps
+  eventTrace.add(TRACE_PHASE, this->traceSource, 2);
   int lastRead = hallSignal;
   while (!isAboveThreshold || (isAboveThreshold && (abs(lastRead - this->hallSensorIdleSignal) <= abs(hallSignal - this->hallSensorIdleSignal)))) {
     if (isTimedOut(startTime, timeout)) {
       digitalWrite(this->sleepPin, !(this->enableIsHigh));
       this->errors = 3;
+      eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
       return false;  
     }
     takeSteps(dir, 1, this->stepsPerSecond);
@@ -140,6 +148,7 @@ bool SwitchingValve::gotoPosition(byte targetPos) {
   digitalWrite(this->sleepPin, !(this->enableIsHigh));
   this->currentPos = targetPos;
   this->errors = 0;
+  eventTrace.add(TRACE_MOTION_STOP, this->traceSource, this->currentPos);
   return true;
 }
 
@@ -167,6 +176,7 @@ bool SwitchingValve::initializeValve(void) {
   }
   if (this->hallSensorIdleSignal == 0) {
     this->errors = 1;
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
     return false;
   }
   
@@ -235,6 +245,7 @@ bool SwitchingValve::initializeValve(void) {
   if (abs(posPolarityCounter - negPolarityCounter) != this->ports - 2) {
     digitalWrite(this->sleepPin, !(this->enableIsHigh));
     this->errors = 2;
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
     return false;
   }
 
@@ -249,6 +260,7 @@ bool SwitchingValve::initializeValve(void) {
       if (isTimedOut(startTime, timeout)) {
         digitalWrite(this->sleepPin, !(this->enableIsHigh));
         this->errors = 3;
+        eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
         return false;
       }
       hallSignal = this->readHallSensorSignal();
@@ -268,6 +280,7 @@ bool SwitchingValve::initializeValve(void) {
   if (signalCounter >= 2*this->ports) {
     digitalWrite(this->sleepPin, !(this->enableIsHigh));
     this->errors = 2;
+    eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
     return false;
   }
 
@@ -277,6 +290,7 @@ bool SwitchingValve::initializeValve(void) {
     if (isTimedOut(startTime, timeout)) {
       digitalWrite(this->sleepPin, !(this->enableIsHigh));
       this->errors = 3;
+      eventTrace.add(TRACE_ERROR, this->traceSource, this->errors);
       return false;  
     }
     takeSteps(dir, 1, this->stepsPerSecond);
@@ -25,6 +25,7 @@ public:
   byte errors;
   int hallSensorIdleSignal;
   int hallSensorThreshold;
+  byte traceSource;
 private:
   int dirPin;
   int stepPin;
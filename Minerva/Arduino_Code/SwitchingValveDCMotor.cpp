@@ -14,7 +14,7 @@
 SwitchingValveDCMotor::SwitchingValveDCMotor(void) {
 }
 
-SwitchingValveDCMotor::SwitchingValveDCMotor(byte dcMotorPin1, byte dcMotorPin2, int hallSensorPin, byte reversedPolarityPos=5, byte ports=10, bool clockwiseNumbering=false) {
+SwitchingValveDCMotor::SwitchingValveDCMotor(byte dcMotorPin1, byte dcMotorPin2, int hallSensorPin, byte reversedPolarityPos, byte ports, bool clockwiseNumbering) {
   
   pinMode(dcMotorPin1, OUTPUT);
   pinMode(dcMotorPin2, OUTPUT);
@@ -50,7 +50,7 @@ void SwitchingValveDCMotor::stopTurning() {
   digitalWrite(this->dcMotorPin2, LOW);
 }
 
-int SwitchingValveDCMotor::readHallSensorSignal(bool logResults=true) {
+int SwitchingValveDCMotor::readHallSensorSignal(bool logResults) {
   int hallAnalogSignal=0;
   const int AVG = 4;
   
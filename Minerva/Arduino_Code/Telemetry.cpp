@@ -0,0 +1,235 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <Arduino.h>
+#include "Telemetry.h"
+
+// The name tables are kept in flash (PROGMEM), fixed-width rows so they can be read without a table of pointers
+const char TELEMETRY_CHANNEL_NAMES[TELEMETRY_CHANNELS][14] PROGMEM = {"hall1", "hall2", "valve1", "valve2", "pressure", "motor_current", "servo_current", "clamp1", "clamp2", "clamp3", "switches", "temperature1", "humidity1"};
+const byte TELEMETRY_CHANNEL_DECIMALS[TELEMETRY_CHANNELS] = {0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 0, 1, 1};
+const char WATCH_TRACE_NAMES[WATCH_TRACE_TYPES][7] PROGMEM = {"motion", "limits", "errors"};
+const byte WATCH_TRACE_EVENTS[WATCH_TRACE_TYPES] = {TRACE_MOTION_STOP, TRACE_LIMIT_SWITCH, TRACE_ERROR};
+
+Telemetry::Telemetry(void) {
+  this->unsubscribeAll();
+  this->unwatchAll();
+}
+
+bool Telemetry::subscribe(String channel, unsigned long period) {
+  // Periods below TELEMETRY_MIN_PERIOD are raised to it, a period of 0 unsubscribes the channel. The first value is sent right away.
+  int i = this->findChannel(channel);
+
+  if (i < 0) {
+    return false;
+  }
+  if (period == 0) {
+    return this->unsubscribe(channel);
+  }
+  if (this->periods[i] == 0) {
+    this->subscriptions++;
+  }
+  this->periods[i] = max(period, TELEMETRY_MIN_PERIOD);
+  this->lastPushTimes[i] = millis() - this->periods[i];
+  return true;
+}
+
+bool Telemetry::unsubscribe(String channel) {
+  int i = this->findChannel(channel);
+
+  if (i < 0) {
+    return false;
+  }
+  if (this->periods[i] != 0) {
+    this->subscriptions--;
+  }
+  this->periods[i] = 0;
+  return true;
+}
+
+void Telemetry::unsubscribeAll() {
+  for (byte i = 0; i < TELEMETRY_CHANNELS; i++) {
+    this->periods[i] = 0;
+  }
+  this->subscriptions = 0;
+}
+
+bool Telemetry::isDue(byte channel) {
+  return (this->periods[channel] != 0) && ((unsigned long)(millis() - this->lastPushTimes[channel]) >= this->periods[channel]);
+}
+
+void Telemetry::markSent(byte channel) {
+  // Keeps the average period if the value was sent a little late, but restarts the schedule after longer delays (e.g. while a command was running)
+  // so the values that were held back do not pile up
+  if ((unsigned long)(millis() - this->lastPushTimes[channel]) < 2 * this->periods[channel]) {
+    this->lastPushTimes[channel] += this->periods[channel];
+  } else {
+    this->lastPushTimes[channel] = millis();
+  }
+}
+
+bool Telemetry::watch(String channel, byte mode, float threshold, float hysteresis) {
+  // Arms (or re-arms) the watch of a telemetry channel, or of an event type of the event trace (mode, threshold and hysteresis are ignored).
+  // WATCH_OFF disarms it.
+  int i = this->findTraceType(channel);
+  TelemetryWatch *channelWatch;
+
+  if (mode == WATCH_OFF || mode > WATCH_CHANGE) {
+    return (mode == WATCH_OFF) && this->unwatch(channel);
+  }
+  if (i >= 0) {
+    if (!this->traceWatches[i]) {
+      this->watches++;
+    }
+    this->traceWatches[i] = true;
+    this->nextTraceEvent = eventTrace.addedCount;  // only events that happen from now on
+    return true;
+  }
+  i = this->findChannel(channel);
+  if (i < 0) {
+    return false;
+  }
+  channelWatch = &this->channelWatches[i];
+  if (channelWatch->mode == WATCH_OFF) {
+    this->watches++;
+  }
+  channelWatch->mode = mode;
+  channelWatch->isInitialized = false;
+  channelWatch->threshold = threshold;
+  channelWatch->hysteresis = abs(hysteresis);
+  return true;
+}
+
+bool Telemetry::unwatch(String channel) {
+  int i = this->findTraceType(channel);
+
+  if (i >= 0) {
+    if (this->traceWatches[i]) {
+      this->watches--;
+    }
+    this->traceWatches[i] = false;
+    return true;
+  }
+  i = this->findChannel(channel);
+  if (i < 0) {
+    return false;
+  }
+  if (this->channelWatches[i].mode != WATCH_OFF) {
+    this->watches--;
+  }
+  this->channelWatches[i].mode = WATCH_OFF;
+  return true;
+}
+
+void Telemetry::unwatchAll() {
+  for (byte i = 0; i < TELEMETRY_CHANNELS; i++) {
+    this->channelWatches[i].mode = WATCH_OFF;
+  }
+  for (byte i = 0; i < WATCH_TRACE_TYPES; i++) {
+    this->traceWatches[i] = false;
+  }
+  this->watches = 0;
+}
+
+bool Telemetry::isWatched(byte channel) {
+  return this->channelWatches[channel].mode != WATCH_OFF;
+}
+
+byte Telemetry::checkWatch(byte channel, float value) {
+  // Returns the condition that was met by the new value (WATCH_RISING, WATCH_FALLING or WATCH_CHANGE), or WATCH_OFF if there is no event
+  TelemetryWatch *channelWatch = &this->channelWatches[channel];
+
+  if (!channelWatch->isInitialized) {
+    channelWatch->isInitialized = true;
+    channelWatch->isAbove = (value >= channelWatch->threshold);
+    channelWatch->lastValue = value;
+    return WATCH_OFF;
+  }
+  if (channelWatch->mode == WATCH_CHANGE) {
+    if (abs(value - channelWatch->lastValue) >= max(channelWatch->hysteresis, 0.001f)) {
+      channelWatch->lastValue = value;
+      return WATCH_CHANGE;
+    }
+    return WATCH_OFF;
+  }
+  if (!channelWatch->isAbove && value >= channelWatch->threshold + channelWatch->hysteresis) {
+    channelWatch->isAbove = true;
+    return (channelWatch->mode & WATCH_RISING) ? WATCH_RISING : WATCH_OFF;
+  }
+  if (channelWatch->isAbove && value <= channelWatch->threshold - channelWatch->hysteresis) {
+    channelWatch->isAbove = false;
+    return (channelWatch->mode & WATCH_FALLING) ? WATCH_FALLING : WATCH_OFF;
+  }
+  return WATCH_OFF;
+}
+
+bool Telemetry::getTraceEvent(TraceEvent *event) {
+  // Next event of a watched type that was added to the event trace since the last call. Events that were overwritten before they were checked are skipped.
+  byte i;
+
+  if (eventTrace.addedCount - this->nextTraceEvent > TRACE_EVENTS) {
+    this->nextTraceEvent = eventTrace.addedCount - TRACE_EVENTS;
+  }
+  while (this->nextTraceEvent != eventTrace.addedCount) {
+    if (!eventTrace.get(this->nextTraceEvent++, event)) {
+      continue;  // cleared with "trace clear"
+    }
+    for (i = 0; i < WATCH_TRACE_TYPES; i++) {
+      if (this->traceWatches[i] && event->type == WATCH_TRACE_EVENTS[i]) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+String Telemetry::getWatches() {
+  // Armed watches, one per line: <channel>;<mode>;<threshold>;<hysteresis>, or only the name for the event types of the event trace
+  String watchList = "";
+
+  for (byte i = 0; i < TELEMETRY_CHANNELS; i++) {
+    if (this->channelWatches[i].mode != WATCH_OFF) {
+      watchList += String((const __FlashStringHelper *)TELEMETRY_CHANNEL_NAMES[i]) + ";" + String(this->channelWatches[i].mode) + ";" + String(this->channelWatches[i].threshold) + ";" + String(this->channelWatches[i].hysteresis) + "\n";
+    }
+  }
+  for (byte i = 0; i < WATCH_TRACE_TYPES; i++) {
+    if (this->traceWatches[i]) {
+      watchList += String((const __FlashStringHelper *)WATCH_TRACE_NAMES[i]) + "\n";
+    }
+  }
+  return watchList;
+}
+
+String Telemetry::getChannelName(byte channel) {
+  return String((const __FlashStringHelper *)TELEMETRY_CHANNEL_NAMES[channel]);
+}
+
+byte Telemetry::getDecimals(byte channel) {
+  return TELEMETRY_CHANNEL_DECIMALS[channel];
+}
+
+unsigned long Telemetry::getPeriod(byte channel) {
+  return this->periods[channel];
+}
+
+int Telemetry::findChannel(String channel) {
+  for (byte i = 0; i < TELEMETRY_CHANNELS; i++) {
+    if (strcmp_P(channel.c_str(), TELEMETRY_CHANNEL_NAMES[i]) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int Telemetry::findTraceType(String name) {
+  for (byte i = 0; i < WATCH_TRACE_TYPES; i++) {
+    if (strcmp_P(name.c_str(), WATCH_TRACE_NAMES[i]) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
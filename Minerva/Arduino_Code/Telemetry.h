@@ -0,0 +1,80 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#ifndef Telemetry_h
+#define Telemetry_h
+#include <Arduino.h>
+#include "EventTrace.h"
+
+const byte TELEMETRY_CHANNELS = 13;
+const unsigned long TELEMETRY_MIN_PERIOD = 20;  // in ms, duration of the idle phase of the main loop (values are only pushed while it is idle)
+
+// Channels that can be subscribed, see TELEMETRY_CHANNEL_NAMES for their names in the commands
+const byte TELEMETRY_HALL1 = 0;  // deviation of the Hall sensor signal of valve 1 from its idle signal
+const byte TELEMETRY_HALL2 = 1;
+const byte TELEMETRY_VALVE1 = 2;  // current position of valve 1
+const byte TELEMETRY_VALVE2 = 3;
+const byte TELEMETRY_PRESSURE = 4;  // filtered pressure of the capper
+const byte TELEMETRY_MOTOR_CURRENT = 5;  // latest current of the capper wrist motor in mA
+const byte TELEMETRY_SERVO_CURRENT = 6;  // latest current of the capper servo in mA
+const byte TELEMETRY_CLAMP1 = 7;  // motor current of the hotplate clamp 1 in mA
+const byte TELEMETRY_CLAMP2 = 8;
+const byte TELEMETRY_CLAMP3 = 9;
+const byte TELEMETRY_SWITCHES = 10;  // triggered limit switches (bit 0: clamp 1 down, 1: clamp 1 up, ..., 6: clamp 4)
+const byte TELEMETRY_TEMPERATURE1 = 11;  // latest reading of the DHT22 sensor 1 in centigrades
+const byte TELEMETRY_HUMIDITY1 = 12;  // latest reading of the DHT22 sensor 1 in percent
+
+// Conditions of the watches on the telemetry channels
+const byte WATCH_OFF = 0;
+const byte WATCH_RISING = 1;  // value rises above the threshold plus the hysteresis
+const byte WATCH_FALLING = 2;  // value falls below the threshold minus the hysteresis
+const byte WATCH_CROSSING = 3;  // both of the above
+const byte WATCH_CHANGE = 4;  // value differs from the value of the last event by at least the hysteresis (e.g. a limit switch toggles)
+const byte WATCH_TRACE_TYPES = 3;  // watches on the event trace: motion (TRACE_MOTION_STOP), limits (TRACE_LIMIT_SWITCH), errors (TRACE_ERROR)
+
+struct TelemetryWatch {
+  byte mode;
+  bool isInitialized;  // false until the first value after arming was checked (arming never sends an event)
+  bool isAbove;  // state of the last threshold crossing
+  float threshold;
+  float hysteresis;
+  float lastValue;  // value of the last event, for WATCH_CHANGE
+};
+
+// Subscriptions of the periodic telemetry push: each channel is sent with its own period (0: not subscribed) until it is unsubscribed.
+// Watches send an event only when a condition of a channel changes, or when a watched event type is added to the event trace.
+class Telemetry {
+public:
+  Telemetry(void);
+  bool subscribe(String channel, unsigned long period);
+  bool unsubscribe(String channel);
+  void unsubscribeAll(void);
+  bool isDue(byte channel);
+  void markSent(byte channel);
+  bool watch(String channel, byte mode, float threshold=0, float hysteresis=0);
+  bool unwatch(String channel);
+  void unwatchAll(void);
+  bool isWatched(byte channel);
+  byte checkWatch(byte channel, float value);
+  bool getTraceEvent(TraceEvent *event);
+  String getChannelName(byte channel);
+  byte getDecimals(byte channel);
+  unsigned long getPeriod(byte channel);
+  String getWatches(void);
+  byte subscriptions;  // number of subscribed channels
+  byte watches;  // number of watched channels and event types
+private:
+  int findChannel(String channel);
+  int findTraceType(String name);
+  unsigned long periods[TELEMETRY_CHANNELS];  // in ms
+  unsigned long lastPushTimes[TELEMETRY_CHANNELS];  // in ms
+  TelemetryWatch channelWatches[TELEMETRY_CHANNELS];
+  bool traceWatches[WATCH_TRACE_TYPES];
+  unsigned long nextTraceEvent;  // sequence number of the next event of the event trace that is checked
+};
+#endif
@@ -0,0 +1,343 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# @author:      "Bastian Ruehle"
+# @copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+# @version:     "1.0.0"
+# @maintainer:  "Bastian Ruehle"
+# @email        "bastian.ruehle@bam.de"
+
+"""
+Replays the Arduino commands of a real workflow against the host build of the firmware (minerva_firmware_host with the plant models) and
+reports the makespan, the busy and idle time of every device, and the time commands spent waiting for the controller while it was still
+executing a previous command (the firmware executes one command at a time).
+
+The commands are taken either from a Minerva log file (the log messages of the drivers are mapped back to the commands that produced them)
+or from a serial capture with one command per line in the form '<time in s> <command>'. Every command is released at the time it appears in
+the log and is sent as soon as the controller has finished all previous commands. The drivers log most messages after the reply, so the
+release times are late by the duration of the original command; this is the same for every firmware version that is compared.
+
+Usage:
+    python replay_log.py Logs/log.txt [--capture] [--controller COM25] [--host build/minerva_firmware_host] [--max-gap 60] [--output result.json]
+"""
+
+from __future__ import annotations
+
+import argparse
+import datetime
+import json
+import os.path
+import re
+import subprocess
+import sys
+from typing import Dict, List, Optional, Tuple
+
+LOG_LINE = re.compile(r'^(\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2},\d{3})<\d+>:(\S+):[A-Z]+ - (.*)$')
+CONTROLLER = re.compile(r'ArduinoController@([^@:]+)$')
+
+# Log messages of the drivers (current and previous versions) and the commands that produced them, by driver class
+LOG_MESSAGES: Dict[str, List[Tuple[re.Pattern, str]]] = {
+    'HotplateClampDCMotor': [
+        (re.compile(r'^Clamp(\d+) moved up\.'), 'clamp{0} up'),
+        (re.compile(r'^Clamp(\d+) moved down\.'), 'clamp{0} down'),
+        (re.compile(r'^Clamp(\d+) opened\.'), 'clamp{0} open'),
+        (re.compile(r'^Clamp(\d+) closed\.'), 'clamp{0} close'),
+        (re.compile(r'^Clamp(\d+) servo set to (\d+) degrees\.'), 'clamp{0} close {1}'),
+        (re.compile(r'^Clamp(\d+) moved down and closed\.'), 'clamp{0} lower_and_close'),
+        (re.compile(r'^Clamp(\d+) opened and moved up\.'), 'clamp{0} open_and_raise'),
+    ],
+    'HotplateClampStepperMotor': [
+        (re.compile(r'^Clamp(\d+) returned to home position'), 'clamp{0} home'),
+        (re.compile(r'^Clamp(\d+) is currently at'), 'clamp{0} pos'),
+        (re.compile(r'^Clamp(\d+) position set to ([\d.]+) mm'), 'clamp{0} pos {1}'),
+        (re.compile(r'^Clamp(\d+) moved to ([\d.]+) mm'), 'clamp{0} goto {1}'),
+        (re.compile(r'^Clamp(\d+) opened\.'), 'clamp{0} open'),
+        (re.compile(r'^Clamp(\d+) closed\.'), 'clamp{0} close'),
+        (re.compile(r'^Clamp(\d+) servo set to (\d+) degrees\.'), 'clamp{0} close {1}'),
+        (re.compile(r'^Clamp(\d+) moved down and closed\.'), 'clamp{0} lower_and_close'),
+        (re.compile(r'^Clamp(\d+) opened and moved up\.'), 'clamp{0} open_and_raise'),
+    ],
+    'HotplateFan': [
+        (re.compile(r'^Fan(\d+) turned on\.'), 'fan{0} on'),
+        (re.compile(r'^Fan(\d+) turned off\.'), 'fan{0} off'),
+        (re.compile(r'^Fan(\d+) started cool-down\.'), 'fan{0} cool 255;60000'),
+    ],
+    'DHT22Sensor': [
+        (re.compile(r'^Temperature: '), 'dht22sensor1 measure'),
+    ],
+    'Electromagnet': [
+        (re.compile(r'^Magnet (\d+) turned on\.'), 'magnet{0} on'),
+        (re.compile(r'^Magnet (\d+) turned off\.'), 'magnet{0} off'),
+        (re.compile(r'^Magnet (\d+) released\.'), 'magnet{0} rel'),
+        (re.compile(r'^Polarity of magnet (\d+) reversed\.'), 'magnet{0} rev'),
+        (re.compile(r'^Magnet (\d+) stirring at ([\d.]+) Hz\.'), 'magnet{0} stir {1};255;0'),
+        (re.compile(r'^Emergency stop cleared\.'), 'ces'),
+    ],
+    'SwitchingValveArduino': [
+        (re.compile(r'^Moved valve (\d+) to position (\d+)'), 'valve{0} pos {1}'),
+        (re.compile(r'^Valve (\d+) is currently in position'), 'valve{0} pos'),
+        (re.compile(r'^Valve (\d+) on .* initialized\.'), 'valve{0} ini'),
+        (re.compile(r'^Hall Sensor Parameters for valve (\d+)'), 'valve{0} par'),
+    ],
+    'CapperDecapper': [
+        (re.compile(r'^Pressure Signal: '), 'capper pressure'),
+        (re.compile(r'^DC Motor Current \[mA\]: '), 'capper motor_current'),
+        (re.compile(r'^Servo Motor Current \[mA\]: '), 'capper servo_current'),
+        (re.compile(r'^Started sensor stream'), 'capper stream'),
+        (re.compile(r'^Stopped sensor stream'), 'capper stream_stop'),
+        (re.compile(r'^Read \d+ cycles from the flight recorder'), 'capper recorder'),
+        (re.compile(r'^Cleared flight recorder'), 'capper recorder_clear'),
+        (re.compile(r'^Wrist turning clockwise'), 'capper turn_cw'),
+        (re.compile(r'^Wrist turning counterclockwise'), 'capper turn_ccw'),
+        (re.compile(r'^Stopped turning wrist'), 'capper turn_stop'),
+        (re.compile(r'^Clamp position set to (\d+) mm'), 'capper clamp_set_position {0}'),
+        (re.compile(r'^Clamp position is '), 'capper clamp_get_position'),
+        (re.compile(r'^Clamp opened\.'), 'capper clamp_open'),
+        (re.compile(r'^Clamp closed'), 'capper clamp_close'),
+        (re.compile(r'^Stored container profile (\d+)'), 'capper profile {0}'),
+        (re.compile(r'^Cap free: '), 'capper grip_unscrew'),
+        (re.compile(r'^Cap seated: '), 'capper tighten_release'),
+    ],
+}
+
+
+class ReplayCommand:
+    """
+    A command of the replayed workflow
+
+    Parameters
+    ----------
+    release : float
+        Time (in s since the first command) at which the workflow issued the command.
+    command : str
+        The command as sent to the Arduino.
+    """
+
+    def __init__(self, release: float, command: str):
+        self.release = release
+        self.command = command
+        self.device = command.split(' ')[0].lower()
+        self.start = 0.0
+        self.duration = 0.0
+        self.wait = 0.0  # time (in s) the command waited for the controller to finish the previous commands
+        self.reply: List[str] = []
+
+
+def read_log_file(path: str, controller: Optional[str] = None) -> List[ReplayCommand]:
+    """
+    Extracts the Arduino commands from a Minerva log file.
+
+    Parameters
+    ----------
+    path : str
+        Path of the log file.
+    controller : Optional[str], default=None
+        Port of the Arduino controller whose commands are replayed. If None, the controller with the most commands is used.
+
+    Returns
+    -------
+    List[ReplayCommand]
+        The commands in the order of the log file.
+    """
+    commands: Dict[str, List[Tuple[datetime.datetime, str]]] = {}
+    with open(path, 'r', encoding='utf-8', errors='replace') as f:
+        for line in f:
+            m = LOG_LINE.match(line.rstrip('\n'))
+            if m is None:
+                continue
+            timestamp, instance_name, message = m.groups()
+            port = CONTROLLER.search(instance_name)
+            if port is None:
+                continue
+            for pattern, command in LOG_MESSAGES.get(instance_name.split('@')[0], []):
+                c = pattern.match(message)
+                if c is not None:
+                    commands.setdefault(port.group(1), []).append((datetime.datetime.strptime(timestamp, '%Y-%m-%d %H:%M:%S,%f'), command.format(*c.groups())))
+                    break
+
+    if len(commands) == 0:
+        return []
+    if controller is None:
+        controller = max(commands.keys(), key=lambda k: len(commands[k]))
+        if len(commands) > 1:
+            print(f'Log file contains commands for {len(commands)} controllers, replaying {controller} (use --controller to select another one).', file=sys.stderr)
+    if controller not in commands.keys():
+        return []
+    t0 = commands[controller][0][0]
+    return [ReplayCommand((t - t0).total_seconds(), c) for t, c in commands[controller]]
+
+
+def read_capture_file(path: str) -> List[ReplayCommand]:
+    """
+    Reads the commands from a serial capture with lines of the form '<time in s> <command>' (lines starting with # are ignored).
+
+    Parameters
+    ----------
+    path : str
+        Path of the capture file.
+
+    Returns
+    -------
+    List[ReplayCommand]
+        The commands in the order of the capture file.
+    """
+    res: List[ReplayCommand] = []
+    with open(path, 'r', encoding='utf-8', errors='replace') as f:
+        for line in f:
+            line = line.strip()
+            if len(line) == 0 or line.startswith('#') or ' ' not in line:
+                continue
+            t, command = line.split(' ', 1)
+            res.append(ReplayCommand(float(t), command.strip()))
+    if len(res) > 0:
+        t0 = res[0].release
+        for c in res:
+            c.release -= t0
+    return res
+
+
+def replay(commands: List[ReplayCommand], host: str, max_gap: float, init_lines: List[str], settle_time: float = 3.0, seed: int = 1) -> float:
+    """
+    Replays the commands against the host build of the firmware and fills in their start times, durations and replies.
+
+    Parameters
+    ----------
+    commands : List[ReplayCommand]
+        The commands to replay.
+    host : str
+        Path of the minerva_firmware_host executable.
+    max_gap : float
+        Idle gaps between commands that are longer than this (in s) are shortened to it, which only shortens the idle time of the replay.
+    init_lines : List[str]
+        Lines (e.g., '#plant' directives) that are sent to the host before the first command.
+    settle_time : float, default=3.0
+        Time in s after the start of the firmware before the first command is sent (the first DHT22 reading is taken after 2.1 s).
+    seed : int, default=1
+        Seed of the sensor noise of the plant models.
+
+    Returns
+    -------
+    float
+        The total idle time in s that was removed from the replay by shortening long gaps.
+    """
+    script = list(init_lines)
+    removed = 0.0
+    offsets: List[float] = []  # idle time removed before each command
+    for i, c in enumerate(commands):
+        if i > 0:
+            removed += max(0.0, c.release - commands[i - 1].release - max_gap)  # only shortens gaps during which the controller was idle in the original run
+        offsets.append(removed)
+        script.append(f'#at {int(round((c.release - removed + settle_time) * 1000))}')
+        script.append(c.command)
+
+    p = subprocess.run([host, '--plant', '--timing', '--seed', str(seed)], input='\n'.join(script) + '\n', capture_output=True, text=True, errors='replace')
+    if p.returncode != 0:
+        raise RuntimeError(f'{host} exited with code {p.returncode}: {p.stderr}')
+
+    i = 0
+    reply: List[str] = []
+    for line in p.stdout.splitlines():
+        if line.startswith('#time ') and i < len(commands):
+            duration, start = line.split(' ')[1:3]
+            commands[i].duration = float(duration) / 1000
+            commands[i].start = float(start) / 1000 - settle_time + offsets[i]
+            commands[i].reply = reply
+            reply = []
+            i += 1
+        else:
+            reply.append(line)
+
+    busy_until = 0.0
+    for c in commands:
+        c.wait = max(0.0, busy_until - c.release)
+        busy_until = max(busy_until, c.start + c.duration)
+    return removed
+
+
+def summarize(commands: List[ReplayCommand], removed: float) -> dict:
+    """
+    Computes the makespan, the busy and idle time per device and the waiting times of the replayed commands.
+
+    Parameters
+    ----------
+    commands : List[ReplayCommand]
+        The replayed commands.
+    removed : float
+        The idle time removed from the replay by shortening long gaps (added back to the makespan).
+
+    Returns
+    -------
+    dict
+        The results (all times in s).
+    """
+    makespan = max(c.start + c.duration for c in commands) - min(c.release for c in commands)
+    busy = sum(c.duration for c in commands)
+    devices: Dict[str, dict] = {}
+    for c in commands:
+        d = devices.setdefault(c.device, {'commands': 0, 'busy': 0.0, 'waiting': 0.0, 'max_wait': 0.0, 'errors': 0})
+        d['commands'] += 1
+        d['busy'] += c.duration
+        d['waiting'] += c.wait
+        d['max_wait'] = max(d['max_wait'], c.wait)
+        if any(('ERROR' in r) or ('>UNK' in r) or ('Unknown Command' in r) for r in c.reply):
+            d['errors'] += 1
+    for d in devices.values():
+        d['idle'] = makespan - d['busy']
+    waits = sorted(c.wait for c in commands)
+    return {
+        'commands': len(commands),
+        'makespan': makespan,
+        'original_span': commands[-1].release - commands[0].release,
+        'removed_idle_time': removed,
+        'controller_busy': busy,
+        'controller_idle': makespan - busy,
+        'waiting': sum(waits),
+        'waiting_commands': sum(1 for w in waits if w > 0),
+        'wait_p50': waits[(len(waits) + 1) // 2 - 1],
+        'wait_p99': waits[-(-99 * len(waits) // 100) - 1],
+        'wait_max': waits[-1],
+        'devices': devices,
+    }
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description='Replays the Arduino commands of a Minerva log file or serial capture against the host build of the firmware.')
+    parser.add_argument('file', help='Minerva log file (or serial capture with --capture)')
+    parser.add_argument('--capture', action='store_true', help="the file is a serial capture with lines of the form '<time in s> <command>'")
+    parser.add_argument('--controller', default=None, help='port of the Arduino controller in the log file (default: the one with the most commands)')
+    parser.add_argument('--host', default=os.path.join(os.path.dirname(os.path.abspath(__file__)), 'build', 'minerva_firmware_host'), help='path of minerva_firmware_host')
+    parser.add_argument('--max-gap', type=float, default=60.0, help='shorten idle gaps between commands to this many seconds (default: 60)')
+    parser.add_argument('--init', default=None, help="file with lines sent to the host before the first command (e.g., '#plant capper push 500')")
+    parser.add_argument('--seed', type=int, default=1, help='seed of the sensor noise of the plant models')
+    parser.add_argument('--output', default=None, help='write the results (and every replayed command) to this JSON file')
+    args = parser.parse_args()
+
+    commands = read_capture_file(args.file) if args.capture else read_log_file(args.file, args.controller)
+    if len(commands) == 0:
+        print('No Arduino commands found.', file=sys.stderr)
+        return 1
+    init_lines: List[str] = []
+    if args.init is not None:
+        with open(args.init, 'r') as f:
+            init_lines = [line.rstrip('\n') for line in f if line.strip() != '']
+
+    removed = replay(commands, args.host, args.max_gap, init_lines, seed=args.seed)
+    result = summarize(commands, removed)
+
+    print(f"Commands:                 {result['commands']}")
+    print(f"Makespan:                 {result['makespan']:.3f} s (original: {result['original_span']:.3f} s, {result['removed_idle_time']:.3f} s of idle time skipped)")
+    print(f"Controller busy/idle:     {result['controller_busy']:.3f} s / {result['controller_idle']:.3f} s")
+    print(f"Waiting for controller:   {result['waiting']:.3f} s in {result['waiting_commands']} commands (p50 {result['wait_p50'] * 1000:.1f} ms, p99 {result['wait_p99'] * 1000:.1f} ms, max {result['wait_max'] * 1000:.1f} ms)")
+    print(f"\n{'Device':<16} {'Commands':>8} {'Busy [s]':>10} {'Idle [s]':>10} {'Waiting [s]':>12} {'Max wait [ms]':>14} {'Errors':>7}")
+    for name, d in sorted(result['devices'].items()):
+        print(f"{name:<16} {d['commands']:>8} {d['busy']:>10.3f} {d['idle']:>10.3f} {d['waiting']:>12.3f} {d['max_wait'] * 1000:>14.1f} {d['errors']:>7}")
+
+    if args.output is not None:
+        result['replay'] = [{'command': c.command, 'release': c.release, 'start': c.start, 'duration': c.duration, 'wait': c.wait, 'reply': c.reply} for c in commands]
+        with open(args.output, 'w') as f:
+            json.dump(result, f, indent=2)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,67 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Host replacement for AccelStepper (DRIVER interface only), using the same speed profile algorithm as the original library.
+// Step and direction pulses are written through digitalWrite so plant models can count them.
+
+#ifndef AccelStepper_h
+#define AccelStepper_h
+#include <Arduino.h>
+
+class AccelStepper {
+public:
+  typedef enum {
+    FUNCTION = 0, DRIVER = 1, FULL2WIRE = 2, FULL3WIRE = 3, FULL4WIRE = 4, HALF3WIRE = 6, HALF4WIRE = 8
+  } MotorInterfaceType;
+
+  AccelStepper(uint8_t interface=AccelStepper::DRIVER, uint8_t pin1=2, uint8_t pin2=3, uint8_t pin3=4, uint8_t pin4=5, bool enable=true);
+  void moveTo(long absolute);
+  void move(long relative);
+  bool run(void);
+  bool runSpeed(void);
+  void setMaxSpeed(float speed);
+  float maxSpeed(void) { return this->_maxSpeed; }
+  void setAcceleration(float acceleration);
+  float acceleration(void) { return this->_acceleration; }
+  void setSpeed(float speed);
+  float speed(void) { return this->_speed; }
+  long distanceToGo(void) { return this->_targetPos - this->_currentPos; }
+  long targetPosition(void) { return this->_targetPos; }
+  long currentPosition(void) { return this->_currentPos; }
+  void setCurrentPosition(long position);
+  void runToPosition(void);
+  bool runSpeedToPosition(void);
+  void runToNewPosition(long position);
+  void stop(void);
+  void setMinPulseWidth(unsigned int minWidth) { this->_minPulseWidth = minWidth; }
+  void setEnablePin(uint8_t enablePin=0xff) { this->_enablePin = enablePin; }
+  void disableOutputs(void) {}
+  void enableOutputs(void);
+  bool isRunning(void) { return !(this->_speed == 0.0 && this->_targetPos == this->_currentPos); }
+private:
+  enum { DIRECTION_CCW = 0, DIRECTION_CW = 1 };
+  void computeNewSpeed(void);
+  void step(long step);
+  uint8_t _interface;
+  uint8_t _pin[4];
+  uint8_t _enablePin = 0xff;
+  long _currentPos = 0;
+  long _targetPos = 0;
+  float _speed = 0.0;
+  float _maxSpeed = 1.0;
+  float _acceleration = 0.0;
+  unsigned long _stepInterval = 0;
+  unsigned long _lastStepTime = 0;
+  unsigned int _minPulseWidth = 1;
+  long _n = 0;
+  float _c0 = 0.0;
+  float _cn = 0.0;
+  float _cmin = 1.0;
+  bool _direction = DIRECTION_CCW;
+};
+#endif
@@ -0,0 +1,37 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Host replacement for the parts of AceSorting used by the firmware
+
+#ifndef ACE_SORTING_ACE_SORTING_H
+#define ACE_SORTING_ACE_SORTING_H
+#include <stdint.h>
+#include <stddef.h>
+
+namespace ace_sorting {
+template <typename T>
+void shellSortKnuth(T data[], uint16_t n) {
+  uint16_t gap = 1;
+  while (gap < n / 3) {
+    gap = gap * 3 + 1;
+  }
+  while (gap > 0) {
+    for (uint16_t i = gap; i < n; i++) {
+      T temp = data[i];
+      uint16_t j = i;
+      while (j >= gap && data[j - gap] > temp) {
+        data[j] = data[j - gap];
+        j -= gap;
+      }
+      data[j] = temp;
+    }
+    gap = (gap - 1) / 3;
+  }
+}
+}
+#endif
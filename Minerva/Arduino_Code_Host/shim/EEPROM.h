@@ -0,0 +1,30 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Host replacement for the EEPROM library (4 kB like the ATmega2560, erased to 0xFF)
+
+#ifndef EEPROM_h
+#define EEPROM_h
+#include <stdint.h>
+#include <string.h>
+
+class EEPROMClass {
+public:
+  EEPROMClass(void) { memset(this->data, 0xFF, sizeof(this->data)); }
+  uint8_t read(int idx) { return this->data[idx]; }
+  void write(int idx, uint8_t val) { this->data[idx] = val; }
+  void update(int idx, uint8_t val) { this->data[idx] = val; }
+  uint16_t length(void) { return sizeof(this->data); }
+  uint8_t &operator[](int idx) { return this->data[idx]; }
+  template<typename T> T &get(int idx, T &t) { memcpy(&t, &this->data[idx], sizeof(T)); return t; }
+  template<typename T> const T &put(int idx, const T &t) { memcpy(&this->data[idx], &t, sizeof(T)); return t; }
+  uint8_t data[4096];
+};
+
+extern EEPROMClass EEPROM;
+#endif
@@ -0,0 +1,59 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Host replacement for HardwareSerial. Bytes are exchanged with HostSim, and transmission is paced at the configured baud rate in virtual time.
+
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+#include <stdint.h>
+#include <stddef.h>
+#include "WString.h"
+
+#define SERIAL_RX_BUFFER_SIZE 64
+#define SERIAL_TX_BUFFER_SIZE 64
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+class HardwareSerial {
+public:
+  void begin(unsigned long baud);
+  void end(void) {}
+  int available(void);
+  int availableForWrite(void);
+  int peek(void);
+  int read(void);
+  void flush(void);
+  void setTimeout(unsigned long timeout) { this->timeout = timeout; }
+  String readStringUntil(char terminator);
+  size_t readBytes(char *buffer, size_t length);
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return this->write((const uint8_t *)str, strlen(str)); }
+  size_t print(const String &s) { return this->write((const uint8_t *)s.c_str(), s.length()); }
+  size_t print(const char *s) { return this->write(s); }
+  size_t print(const __FlashStringHelper *s) { return this->write(reinterpret_cast<const char *>(s)); }
+  size_t print(char c) { return this->write((uint8_t)c); }
+  size_t print(unsigned char value, int base=DEC) { return this->print(String(value, base)); }
+  size_t print(int value, int base=DEC) { return this->print(String(value, base)); }
+  size_t print(unsigned int value, int base=DEC) { return this->print(String(value, base)); }
+  size_t print(long value, int base=DEC) { return this->print(String(value, base)); }
+  size_t print(unsigned long value, int base=DEC) { return this->print(String(value, base)); }
+  size_t print(double value, int digits=2) { return this->print(String(value, digits)); }
+  size_t println(void) { return this->write("\r\n"); }
+  template<class T> size_t println(T value) { size_t n = this->print(value); return n + this->println(); }
+  template<class T> size_t println(T value, int format) { size_t n = this->print(value, format); return n + this->println(); }
+  operator bool() { return true; }
+  unsigned long baudRate;
+private:
+  static size_t strlen(const char *s) { size_t n = 0; while (s[n]) n++; return n; }
+  unsigned long timeout = 1000;
+};
+
+extern HardwareSerial Serial;
+#endif
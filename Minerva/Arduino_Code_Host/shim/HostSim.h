@@ -0,0 +1,97 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Control interface of the host build: virtual clock, pin and bus state, serial port, and attachment points for plant models.
+// Nothing in here is visible to the firmware; it is used by the host executables to drive and observe it.
+
+#ifndef HostSim_h
+#define HostSim_h
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace hostsim {
+
+// Approximate execution cost of core functions on a 16 MHz ATmega2560 (in microseconds of virtual time)
+struct CostModel {
+  uint32_t digitalWrite = 5;
+  uint32_t digitalRead = 4;
+  uint32_t analogRead = 112;
+  uint32_t analogWrite = 6;
+  uint32_t clock = 1;          // millis(), micros()
+  uint32_t servoWrite = 12;
+  uint32_t i2cByte = 90;       // 100 kHz I2C clock, 9 clock cycles per byte
+  uint32_t stepperRun = 20;    // one call of AccelStepper::run() or runSpeed()
+};
+extern CostModel costs;
+
+// Plant models are attached to the shim and see every output change, can override every input, and are advanced with the virtual clock
+class Model {
+public:
+  virtual ~Model(void) {}
+  virtual void onDigitalWrite(uint8_t /*pin*/, uint8_t /*value*/, uint64_t /*nowUs*/) {}
+  virtual void onAnalogWrite(uint8_t /*pin*/, int /*value*/, uint64_t /*nowUs*/) {}
+  virtual void onServoWrite(uint8_t /*pin*/, int /*angle*/, uint64_t /*nowUs*/) {}
+  virtual bool readDigital(uint8_t /*pin*/, uint64_t /*nowUs*/, int &/*value*/) { return false; }
+  virtual bool readAnalog(uint8_t /*pin*/, uint64_t /*nowUs*/, int &/*value*/) { return false; }
+  virtual void update(uint64_t /*nowUs*/) {}
+};
+
+// Simulated I2C slave (e.g., an INA219), addressed by its 7 bit address
+class I2CDevice {
+public:
+  virtual ~I2CDevice(void) {}
+  virtual uint8_t address(void) const = 0;
+  virtual void receive(const uint8_t *data, size_t length, uint64_t nowUs) = 0;
+  virtual size_t transmit(uint8_t *data, size_t length, uint64_t nowUs) = 0;
+};
+
+// Virtual clock
+uint64_t now(void);
+void advance(uint64_t us);
+void reset(void);
+
+// Pins
+void setDigitalInput(uint8_t pin, int value);
+void setAnalogInput(uint8_t pin, int value);
+int getPinOutput(uint8_t pin);
+int getPinMode(uint8_t pin);
+int getAnalogOutput(uint8_t pin);
+int getServoAngle(uint8_t pin);
+void notifyServoWrite(uint8_t pin, int angle);
+
+// Models and devices
+void addModel(Model *model);
+void clearModels(void);
+void addI2CDevice(I2CDevice *device);
+I2CDevice *findI2CDevice(uint8_t address);
+void clearI2CDevices(void);
+
+// Serial port (the firmware's Serial object). Injected bytes arrive one character time apart, starting now (or at startUs, which may lie in the
+// past when called between two iterations of loop()), but not before the bytes injected earlier.
+void serialInject(const std::string &data);
+void serialInjectAt(const std::string &data, uint64_t startUs);
+unsigned long serialByteTime(void);
+size_t serialPendingInput(void);
+std::string serialTakeOutput(void);
+void setSerialOutputCallback(std::function<void(const uint8_t *data, size_t length, uint64_t nowUs)> callback);
+
+// DHT22 readings (default: 22.0 C, 40.0 %); return false to simulate a checksum error
+void setDHT22Provider(std::function<bool(uint8_t pin, uint64_t nowUs, float &temperature, float &humidity)> provider);
+
+// Hooks for instrumentation (called around every loop() iteration by runLoopOnce())
+void runSetup(void);
+void runLoopOnce(void);
+uint64_t loopIterations(void);
+
+// Thrown by the watchdog shim when the firmware requests a soft reset
+struct SoftReset {};
+}
+#endif
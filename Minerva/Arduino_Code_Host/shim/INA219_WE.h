@@ -0,0 +1,77 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Host replacement for the INA219_WE library, talking to the simulated INA219 register map over the Wire shim like the original
+
+#ifndef INA219_WE_H_
+#define INA219_WE_H_
+#include <Arduino.h>
+#include <Wire.h>
+
+typedef enum INA219_ADC_MODE {
+  BIT_MODE_9 = 0b00000000, BIT_MODE_10 = 0b00000001, BIT_MODE_11 = 0b00000010, BIT_MODE_12 = 0b00000011,
+  SAMPLE_MODE_2 = 0b00001001, SAMPLE_MODE_4 = 0b00001010, SAMPLE_MODE_8 = 0b00001011, SAMPLE_MODE_16 = 0b00001100,
+  SAMPLE_MODE_32 = 0b00001101, SAMPLE_MODE_64 = 0b00001110, SAMPLE_MODE_128 = 0b00001111
+} INA219_adcMode;
+
+typedef enum INA219_MEASURE_MODE {
+  POWER_DOWN = 0b00000000, TRIGGERED = 0b00000011, ADC_OFF = 0b00000100, CONTINUOUS = 0b00000111
+} INA219_measureMode;
+
+typedef enum INA219_PGAIN {
+  PG_40 = 0x0000, PG_80 = 0x0800, PG_160 = 0x1000, PG_320 = 0x1800
+} INA219_PGain;
+
+typedef enum INA219_BUS_RANGE {
+  BRNG_16 = 0x0000, BRNG_32 = 0x2000
+} INA219_busRange;
+
+class INA219_WE {
+public:
+  static constexpr uint8_t INA219_CONF_REG = 0x00;
+  static constexpr uint8_t INA219_SHUNT_REG = 0x01;
+  static constexpr uint8_t INA219_BUS_REG = 0x02;
+  static constexpr uint8_t INA219_PWR_REG = 0x03;
+  static constexpr uint8_t INA219_CURRENT_REG = 0x04;
+  static constexpr uint8_t INA219_CAL_REG = 0x05;
+  static constexpr uint16_t INA219_RST = 0x8000;
+
+  INA219_WE(int addr=0x40) : i2cAddress(addr) {}
+  INA219_WE(TwoWire * /*w*/, int addr=0x40) : i2cAddress(addr) {}
+  bool init(void);
+  bool reset_INA219(void);
+  void setCorrectionFactor(float corr) { this->calValCorrected = (uint16_t)(this->calVal * corr); this->writeRegister(INA219_CAL_REG, this->calValCorrected); }
+  void setShuntVoltOffset_mV(float offs) { this->shuntVoltageOffset = offs; }
+  void setADCMode(INA219_ADC_MODE mode);
+  void setMeasureMode(INA219_MEASURE_MODE mode);
+  void setPGain(INA219_PGAIN gain);
+  void setBusRange(INA219_BUS_RANGE range);
+  float getShuntVoltage_mV(void);
+  float getBusVoltage_V(void);
+  float getCurrent_mA(void);
+  float getBusPower(void);
+  bool getOverflow(void);
+  bool getConversionReady(void);
+  void startSingleMeasurement(void);
+  bool startSingleMeasurement(unsigned long timeout_us);
+  void powerDown(void);
+  void powerUp(void);
+  uint8_t writeRegister(uint8_t reg, uint16_t val);
+  uint16_t readRegister(uint8_t reg);
+private:
+  int i2cAddress;
+  uint16_t calVal = 8192;
+  uint16_t calValCorrected = 8192;
+  uint16_t confRegCopy = 0;
+  float currentDivider_mA = 20.0;
+  float pwrMultiplier_mW = 1.0;
+  float shuntVoltageOffset = 0.0;
+  bool overflow = false;
+  INA219_MEASURE_MODE measureMode = CONTINUOUS;
+};
+#endif
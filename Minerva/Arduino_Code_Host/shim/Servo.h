@@ -0,0 +1,33 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Host replacement for the Servo library. Angles are forwarded to the attached plant models.
+
+#ifndef Servo_h
+#define Servo_h
+#include <Arduino.h>
+
+#define MIN_PULSE_WIDTH 544
+#define MAX_PULSE_WIDTH 2400
+#define INVALID_SERVO 255
+
+class Servo {
+public:
+  uint8_t attach(int pin);
+  uint8_t attach(int pin, int /*min*/, int /*max*/) { return this->attach(pin); }
+  void detach(void) { this->pin = INVALID_SERVO; }
+  void write(int value);
+  void writeMicroseconds(int value) { this->write(map(value, MIN_PULSE_WIDTH, MAX_PULSE_WIDTH, 0, 180)); }
+  int read(void) { return this->angle; }
+  int readMicroseconds(void) { return map(this->angle, 0, 180, MIN_PULSE_WIDTH, MAX_PULSE_WIDTH); }
+  bool attached(void) { return this->pin != INVALID_SERVO; }
+private:
+  uint8_t pin = INVALID_SERVO;
+  int angle = 90;
+};
+#endif
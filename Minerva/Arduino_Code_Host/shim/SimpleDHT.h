@@ -0,0 +1,35 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Host replacement for SimpleDHT (DHT22 only). A read costs the same virtual time as the bit-banged original and fails when the sensor is polled faster than every 2 s.
+
+#ifndef __SIMPLE_DHT_H
+#define __SIMPLE_DHT_H
+#include <Arduino.h>
+
+#define SimpleDHTErrSuccess 0
+#define SimpleDHTErrStartLow 16
+#define SimpleDHTErrStartHigh 17
+#define SimpleDHTErrDataLow 18
+#define SimpleDHTErrDataRead 19
+#define SimpleDHTErrDataEOF 20
+#define SimpleDHTErrDataChecksum 21
+#define SimpleDHTErrZeroSamples 22
+#define SimpleDHTErrNoPin 23
+#define SimpleDHTErrPinMode 24
+
+class SimpleDHT22 {
+public:
+  SimpleDHT22(void) : pin(-1) {}
+  SimpleDHT22(int pin) : pin(pin) {}
+  int read(byte *ptemperature, byte *phumidity, byte pdata[40]);
+  int read2(float *ptemperature, float *phumidity, byte pdata[40]);
+private:
+  int pin;
+};
+#endif
@@ -0,0 +1,80 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Host replacement for the Arduino String class (backed by std::string)
+
+#ifndef WString_h
+#define WString_h
+#include <string>
+#include <string.h>
+#include <stdint.h>
+
+class __FlashStringHelper;
+
+class String {
+public:
+  String(void) {}
+  String(const char *s) : str(s ? s : "") {}
+  String(const std::string &s) : str(s) {}
+  String(const __FlashStringHelper *s) : str(reinterpret_cast<const char *>(s)) {}
+  explicit String(char c) : str(1, c) {}
+  explicit String(unsigned char value, unsigned char base=10) { this->str = fromInteger(value, base); }
+  explicit String(int value, unsigned char base=10) { this->str = fromInteger(value, base); }
+  explicit String(unsigned int value, unsigned char base=10) { this->str = fromInteger(value, base); }
+  explicit String(long value, unsigned char base=10) { this->str = fromInteger(value, base); }
+  explicit String(unsigned long value, unsigned char base=10) { this->str = fromInteger(value, base); }
+  explicit String(float value, unsigned char decimalPlaces=2) { this->str = fromFloat(value, decimalPlaces); }
+  explicit String(double value, unsigned char decimalPlaces=2) { this->str = fromFloat(value, decimalPlaces); }
+
+  unsigned int length(void) const { return this->str.length(); }
+  const char *c_str(void) const { return this->str.c_str(); }
+  char charAt(unsigned int index) const { return index < this->str.length() ? this->str[index] : 0; }
+  char operator[](unsigned int index) const { return this->charAt(index); }
+
+  bool equals(const String &s) const { return this->str == s.str; }
+  bool operator==(const String &s) const { return this->str == s.str; }
+  bool operator==(const char *s) const { return this->str == s; }
+  bool operator!=(const String &s) const { return this->str != s.str; }
+  bool operator!=(const char *s) const { return this->str != s; }
+  bool startsWith(const String &prefix) const { return this->str.compare(0, prefix.str.length(), prefix.str) == 0; }
+  bool endsWith(const String &suffix) const { return this->str.length() >= suffix.str.length() && this->str.compare(this->str.length() - suffix.str.length(), suffix.str.length(), suffix.str) == 0; }
+  int indexOf(char c, unsigned int from=0) const { size_t i = this->str.find(c, from); return i == std::string::npos ? -1 : (int)i; }
+  int indexOf(const String &s, unsigned int from=0) const { size_t i = this->str.find(s.str, from); return i == std::string::npos ? -1 : (int)i; }
+
+  String substring(unsigned int from) const { return from >= this->str.length() ? String() : String(this->str.substr(from)); }
+  String substring(unsigned int from, unsigned int to) const;
+  void replace(const String &find, const String &replacement);
+  void toLowerCase(void);
+  void toUpperCase(void);
+  void trim(void);
+  void toCharArray(char *buf, unsigned int bufsize, unsigned int index=0) const;
+  long toInt(void) const;
+  float toFloat(void) const;
+
+  bool concat(const String &s) { this->str += s.str; return true; }
+  String &operator+=(const String &s) { this->str += s.str; return *this; }
+  String &operator+=(const char *s) { this->str += s; return *this; }
+  String &operator+=(char c) { this->str += c; return *this; }
+
+  friend String operator+(const String &a, const String &b) { return String(a.str + b.str); }
+  friend String operator+(const String &a, const char *b) { return String(a.str + b); }
+  friend String operator+(const char *a, const String &b) { return String(a + b.str); }
+  friend String operator+(const String &a, char b) { return String(a.str + b); }
+  friend String operator+(const String &a, int b) { return a + String(b); }
+  friend String operator+(const String &a, long b) { return a + String(b); }
+  friend String operator+(const String &a, unsigned int b) { return a + String(b); }
+  friend String operator+(const String &a, unsigned long b) { return a + String(b); }
+  friend String operator+(const String &a, float b) { return a + String(b); }
+  friend String operator+(const String &a, double b) { return a + String(b); }
+
+private:
+  static std::string fromInteger(long long value, unsigned char base);
+  static std::string fromFloat(double value, unsigned char decimalPlaces);
+  std::string str;
+};
+#endif
@@ -0,0 +1,47 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Host replacement for the Wire library. Transactions are routed to the simulated I2C devices registered in HostSim and cost bus time.
+
+#ifndef TwoWire_h
+#define TwoWire_h
+#include <Arduino.h>
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+public:
+  void begin(void) {}
+  void end(void) {}
+  void setClock(uint32_t clock) { this->clock = clock; }
+  void setWireTimeout(uint32_t timeout=25000, bool /*resetWithTimeout*/=false) { this->timeout = timeout; }
+  bool getWireTimeoutFlag(void) { return this->timeoutFlag; }
+  void clearWireTimeoutFlag(void) { this->timeoutFlag = false; }
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool sendStop=true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop=true);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t quantity);
+  int available(void) { return this->rxLength - this->rxIndex; }
+  int read(void) { return this->rxIndex < this->rxLength ? this->rxBuffer[this->rxIndex++] : -1; }
+  int peek(void) { return this->rxIndex < this->rxLength ? this->rxBuffer[this->rxIndex] : -1; }
+  uint32_t clock = 100000;
+  uint32_t timeout = 25000;
+private:
+  uint32_t byteTime(void) const;
+  bool timeoutFlag = false;
+  uint8_t txAddress = 0;
+  uint8_t txBuffer[BUFFER_LENGTH];
+  uint8_t txLength = 0;
+  uint8_t rxBuffer[BUFFER_LENGTH];
+  uint8_t rxLength = 0;
+  uint8_t rxIndex = 0;
+};
+
+extern TwoWire Wire;
+#endif
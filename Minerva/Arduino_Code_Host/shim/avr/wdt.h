@@ -0,0 +1,30 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Host replacement for the watchdog. Enabling the watchdog is only used for soft resets, which restart setup() in the host build.
+
+#ifndef _AVR_WDT_H_
+#define _AVR_WDT_H_
+#include <stdint.h>
+
+#define WDTO_15MS 0
+#define WDTO_30MS 1
+#define WDTO_60MS 2
+#define WDTO_120MS 3
+#define WDTO_250MS 4
+#define WDTO_500MS 5
+#define WDTO_1S 6
+#define WDTO_2S 7
+#define WDTO_4S 8
+#define WDTO_8S 9
+
+extern uint8_t MCUSR;
+void wdt_enable(uint8_t timeout);
+inline void wdt_disable(void) {}
+inline void wdt_reset(void) {}
+#endif
@@ -0,0 +1,175 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <math.h>
+#include <Arduino.h>
+#include "CapperModel.h"
+
+CapperModel::CapperModel(const std::string &name, uint8_t motorPin1, uint8_t motorPin2, uint8_t servoPin, uint8_t pressureSensorPin, Ina219Device &currentSensorDCMotor, Ina219Device &currentSensorServoMotor, int servoClosedPosDegrees, int servoOpenedPosDegrees, int servoClosedPosMillimeters, int servoOpenedPosMillimeters) : PlantModel(name) {
+  this->motorPin1 = motorPin1;
+  this->motorPin2 = motorPin2;
+  this->servoPin = servoPin;
+  this->pressureSensorPin = pressureSensorPin;
+  this->servoClosedPosDegrees = servoClosedPosDegrees;
+  this->servoClosedPosMillimeters = servoClosedPosMillimeters;
+  this->servoDegreesPerMillimeter = (double)(servoOpenedPosDegrees - servoClosedPosDegrees) / (servoOpenedPosMillimeters - servoClosedPosMillimeters);
+  this->servoAngle = servoOpenedPosDegrees;
+  this->servoCommand = servoOpenedPosDegrees;
+  this->pressure = this->pressureBaseline;
+  currentSensorDCMotor.current_mA = [this](uint64_t nowUs) { return (float)this->wristCurrent(nowUs); };
+  currentSensorServoMotor.current_mA = [this](uint64_t nowUs) { return (float)this->servoCurrent(nowUs); };
+
+  this->addParameter("push", &this->push);
+  this->addParameter("diameter", &this->diameter);
+  this->addParameter("thread", &this->thread);
+  this->addParameter("seat", &this->seat);
+  this->addParameter("voltage", &this->voltage);
+  this->addParameter("resistance", &this->resistance);
+  this->addParameter("motor_constant", &this->motorConstant);
+  this->addParameter("inertia", &this->inertia);
+  this->addParameter("wrist_friction", &this->wristFriction);
+  this->addParameter("thread_friction", &this->threadFriction);
+  this->addParameter("seat_stiffness", &this->seatStiffness);
+  this->addParameter("breakaway_torque", &this->breakawayTorque);
+  this->addParameter("breakaway_angle", &this->breakawayAngle);
+  this->addParameter("servo_speed", &this->servoSpeed);
+  this->addParameter("servo_idle_current", &this->servoIdleCurrent);
+  this->addParameter("servo_moving_current", &this->servoMovingCurrent);
+  this->addParameter("servo_force_current", &this->servoForceCurrent);
+  this->addParameter("servo_stall_current", &this->servoStallCurrent);
+  this->addParameter("pressure_baseline", &this->pressureBaseline);
+  this->addParameter("release_fraction", &this->releaseFraction);
+  this->addParameter("pressure_time", &this->pressureTime);
+  this->addParameter("wrist_current_noise", &this->wristCurrentNoise);
+  this->addParameter("servo_current_noise", &this->servoCurrentNoise);
+  this->addParameter("pressure_noise", &this->pressureNoise);
+}
+
+double CapperModel::contactAngle(void) const {
+  // Servo angle at which the clamp touches the cap
+  if (this->diameter <= 0) {
+    return -1000.0;
+  }
+  return this->servoClosedPosDegrees + (this->diameter - this->servoClosedPosMillimeters) * this->servoDegreesPerMillimeter;
+}
+
+bool CapperModel::isGripped(void) const {
+  return (this->servoCommand < this->contactAngle() - 0.5) && (this->servoAngle <= this->contactAngle() + 0.1);
+}
+
+void CapperModel::update(uint64_t nowUs) {
+  this->integrate(nowUs);
+}
+
+void CapperModel::integrate(uint64_t nowUs) {
+  const uint64_t stepUs = 10;
+
+  while (this->lastUpdateUs < nowUs) {
+    uint64_t step = (nowUs - this->lastUpdateUs < stepUs) ? nowUs - this->lastUpdateUs : stepUs;
+    double dt = step / 1e6;
+    double d1 = this->dutyOf(this->motorPin1);
+    double d2 = this->dutyOf(this->motorPin2);
+    bool gripped = this->isGripped();
+    bool threaded = gripped && (this->thread > 0 || (this->wristSpeed > 0 && this->push > 0));
+
+    // Motor current: both inputs HIGH short the winding (brake), both LOW let the wrist coast, otherwise the averaged PWM voltage drives it
+    if (d1 >= 1.0 && d2 >= 1.0) {
+      this->motorCurrent = -this->motorConstant * this->wristSpeed / this->resistance;
+      this->supplyCurrent = 0;
+    } else if (d1 == 0 && d2 == 0) {
+      this->motorCurrent = 0;
+      this->supplyCurrent = 0;
+    } else {
+      double u = this->voltage * (d2 - d1);
+      this->motorCurrent = (u - this->motorConstant * this->wristSpeed) / this->resistance;
+      this->supplyCurrent = (this->motorCurrent * u > 0) ? fabs(this->motorCurrent) * fmax(d1, d2) : 0;
+    }
+
+    // Load: friction of the wrist and of the thread, the seated cap resists further tightening, a seated cap needs the breakaway torque to
+    // come loose. All of them only resist a motion (the thread holds the cap when the motor stops).
+    double drive = this->motorConstant * this->motorCurrent;
+    double resistPositive = this->wristFriction + (threaded ? this->threadFriction : 0);
+    double resistNegative = resistPositive;
+    if (gripped && this->thread > this->seat) {
+      resistPositive += this->seatStiffness * (this->thread - this->seat);
+    }
+    if (gripped && this->thread > this->seat - this->breakawayAngle) {
+      resistNegative += this->breakawayTorque * fmin(1.0, (this->thread - (this->seat - this->breakawayAngle)) / this->breakawayAngle);
+    }
+    double speed = this->wristSpeed;
+    if (speed > 0) {
+      speed += (drive - resistPositive) / this->inertia * dt;
+      speed = fmax(speed, 0.0);
+    } else if (speed < 0) {
+      speed += (drive + resistNegative) / this->inertia * dt;
+      speed = fmin(speed, 0.0);
+    } else if (drive > resistPositive) {
+      speed = (drive - resistPositive) / this->inertia * dt;
+    } else if (drive < -resistNegative) {
+      speed = (drive + resistNegative) / this->inertia * dt;
+    }
+    this->wristSpeed = speed;
+    this->wristAngle += speed * dt;
+
+    // The gripped cap follows the wrist along the thread
+    if (threaded) {
+      this->thread = fmax(0.0, this->thread + speed * dt);
+      if (this->thread == 0 && speed < 0 && this->push > 0) {
+        this->isReleased = true;
+        this->releasedPush = this->push;
+      }
+    }
+    if (this->thread > 0 || this->push != this->releasedPush) {
+      this->isReleased = false;  // a new push of the robot brings the container back against the cap
+    }
+
+    // Servo and pressure sensor
+    double servoTarget = fmax(this->servoCommand, this->contactAngle());
+    double servoStep = this->servoSpeed * dt;
+    this->servoAngle += fmax(-servoStep, fmin(servoStep, servoTarget - this->servoAngle));
+    double pressureTarget = this->pressureBaseline + this->push * (this->isReleased ? this->releaseFraction : 1.0);
+    this->pressure += (pressureTarget - this->pressure) * fmin(1.0, dt * 1000.0 / this->pressureTime);
+
+    this->lastUpdateUs += step;
+  }
+}
+
+void CapperModel::onServoWrite(uint8_t pin, int angle, uint64_t nowUs) {
+  if (pin == this->servoPin) {
+    this->integrate(nowUs);
+    this->servoCommand = angle;
+  }
+}
+
+double CapperModel::wristCurrent(uint64_t nowUs) {
+  this->integrate(nowUs);
+  return this->supplyCurrent * 1000.0 + this->gaussian(this->wristCurrentNoise);
+}
+
+double CapperModel::servoCurrent(uint64_t nowUs) {
+  double target = fmax(this->servoCommand, this->contactAngle());
+  double current = this->servoIdleCurrent;
+
+  this->integrate(nowUs);
+  if (fabs(this->servoAngle - target) > 0.1) {
+    current += this->servoMovingCurrent;
+  }
+  if (this->servoCommand < this->contactAngle()) {
+    current += fmin(this->servoStallCurrent, this->servoForceCurrent * (this->contactAngle() - this->servoCommand));
+  }
+  return current + this->gaussian(this->servoCurrentNoise);
+}
+
+bool CapperModel::readAnalog(uint8_t pin, uint64_t nowUs, int &value) {
+  if (pin != this->pressureSensorPin) {
+    return false;
+  }
+  this->integrate(nowUs);
+  value = (int)lround(this->pressure + this->gaussian(this->pressureNoise));
+  return true;
+}
@@ -0,0 +1,78 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Capper/decapper: wrist DC motor (H-bridge inputs 1 and 2, PWM) turning the cap held by the servo clamp, the thread between cap and
+// container, the pressure sensor below the container, and the currents measured by the two INA219 sensors.
+// The wrist is simulated as a DC motor (i = (U - k w)/R, J dw/dt = k i - load) with the friction of the thread, the torque that builds up
+// once the cap is seated, and the breakaway torque when a seated cap is loosened. The pressure follows the push of the robot and drops when
+// the cap comes out of the thread.
+
+#ifndef CapperModel_h
+#define CapperModel_h
+#include "PlantModel.h"
+#include "Ina219Device.h"
+
+class CapperModel : public PlantModel {
+public:
+  CapperModel(const std::string &name, uint8_t motorPin1, uint8_t motorPin2, uint8_t servoPin, uint8_t pressureSensorPin, Ina219Device &currentSensorDCMotor, Ina219Device &currentSensorServoMotor, int servoClosedPosDegrees, int servoOpenedPosDegrees, int servoClosedPosMillimeters, int servoOpenedPosMillimeters);
+  void update(uint64_t nowUs) override;
+  void onServoWrite(uint8_t pin, int angle, uint64_t nowUs) override;
+  bool readAnalog(uint8_t pin, uint64_t nowUs, int &value) override;
+  double wristCurrent(uint64_t nowUs);
+  double servoCurrent(uint64_t nowUs);
+  bool isGripped(void) const;
+  // Setup of the scenario
+  double push = 0;  // force of the robot pressing the container against the clamp, in ADC counts of the pressure sensor
+  double diameter = 36;  // diameter of the cap in the clamp in mm (0: no cap)
+  double thread = 720;  // how far the cap is screwed onto the container, in rad of the motor shaft (0: loose)
+  double seat = 720;  // thread position at which the cap is seated
+  // Wrist motor
+  double voltage = 12;  // in V
+  double resistance = 20;  // in Ohm
+  double motorConstant = 0.02;  // in V s/rad (N m/A)
+  double inertia = 8e-7;  // in kg m^2
+  double wristFriction = 0.0007;  // in N m
+  double threadFriction = 0.0024;  // in N m
+  double seatStiffness = 0.000116;  // in N m/rad beyond the seat
+  double breakawayTorque = 0.006;  // in N m, to loosen a seated cap
+  double breakawayAngle = 20;  // in rad, the breakaway torque fades over this angle
+  // Servo clamp and pressure sensor
+  double servoSpeed = 600;  // in degrees/s
+  double servoIdleCurrent = 30;  // in mA
+  double servoMovingCurrent = 120;  // in mA
+  double servoForceCurrent = 90;  // in mA per degree that the servo is commanded beyond the contact
+  double servoStallCurrent = 900;  // in mA
+  double pressureBaseline = 40;  // in ADC counts
+  double releaseFraction = 0.15;  // fraction of the push that remains on the sensor once the cap is out of the thread
+  double pressureTime = 5;  // time constant of the pressure sensor in ms
+  double wristCurrentNoise = 4;  // standard deviations in mA and in ADC counts
+  double servoCurrentNoise = 5;
+  double pressureNoise = 2;
+  // State
+  double wristSpeed = 0;  // in rad/s, positive: clockwise (tightening)
+  double wristAngle = 0;  // in rad
+  double motorCurrent = 0;  // in A
+  double servoAngle;  // in degrees
+  double pressure;  // in ADC counts
+private:
+  void integrate(uint64_t nowUs);
+  double contactAngle(void) const;
+  uint8_t motorPin1;
+  uint8_t motorPin2;
+  uint8_t servoPin;
+  uint8_t pressureSensorPin;
+  double servoCommand;
+  double servoDegreesPerMillimeter;
+  double servoClosedPosDegrees;
+  double servoClosedPosMillimeters;
+  bool isReleased = false;  // the cap came out of the thread while the robot was pushing
+  double releasedPush = 0;
+  double supplyCurrent = 0;  // in A
+  uint64_t lastUpdateUs = 0;
+};
+#endif
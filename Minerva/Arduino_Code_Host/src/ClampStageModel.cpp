@@ -0,0 +1,85 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <math.h>
+#include <Arduino.h>
+#include "ClampStageModel.h"
+
+ClampStageModel::ClampStageModel(const std::string &name, uint8_t motorPin1, uint8_t motorPin2, uint8_t currentSensorPin, uint8_t switchPinUp, uint8_t switchPinDown) : PlantModel(name) {
+  this->motorPin1 = motorPin1;
+  this->motorPin2 = motorPin2;
+  this->currentSensorPin = currentSensorPin;
+  this->switchPinUp = switchPinUp;
+  this->switchPinDown = switchPinDown;
+  this->addParameter("position", &this->position);
+  this->addParameter("travel", &this->travel);
+  this->addParameter("speed", &this->speed);
+  this->addParameter("spin_up_time", &this->spinUpTime);
+  this->addParameter("switch_distance", &this->switchDistance);
+  this->addParameter("running_current", &this->runningCurrent);
+  this->addParameter("inrush_current", &this->inrushCurrent);
+  this->addParameter("stall_current", &this->stallCurrent);
+  this->addParameter("current_noise", &this->currentNoise);
+}
+
+double ClampStageModel::direction(void) const {
+  // Input 1 HIGH moves the stage up, input 2 HIGH moves it down, both (or none) stop the motor
+  return this->dutyOf(this->motorPin1) - this->dutyOf(this->motorPin2);
+}
+
+void ClampStageModel::update(uint64_t nowUs) {
+  double dt = (nowUs - this->lastUpdateUs) / 1e6;
+  double dir = this->direction();
+
+  this->lastUpdateUs = nowUs;
+  if (dir != 0 && dir != this->lastDirection) {
+    this->startTimeUs = nowUs;
+  }
+  this->lastDirection = dir;
+  // First order response of the motor speed, the end stops block the stage
+  this->velocity += (dir * this->speed - this->velocity) * fmin(1.0, dt * 1000.0 / this->spinUpTime);
+  this->position += this->velocity * dt;
+  if (this->position <= 0 || this->position >= this->travel) {
+    this->position = fmax(0.0, fmin(this->travel, this->position));
+    this->velocity = 0;
+  }
+}
+
+double ClampStageModel::motorCurrent(void) const {
+  double dir = this->direction();
+  double t = (hostsim::now() - this->startTimeUs) / 1000.0;
+
+  if (dir == 0) {
+    return 0;
+  }
+  if ((dir > 0 && this->position >= this->travel) || (dir < 0 && this->position <= 0)) {
+    return this->stallCurrent * fabs(dir);
+  }
+  return fabs(dir) * (this->runningCurrent + (this->inrushCurrent - this->runningCurrent) * exp(-t / this->spinUpTime));
+}
+
+bool ClampStageModel::readDigital(uint8_t pin, uint64_t /*nowUs*/, int &value) {
+  if (pin == this->switchPinUp) {
+    value = (this->position >= this->travel - this->switchDistance) ? LOW : HIGH;
+    return true;
+  } else if (pin == this->switchPinDown) {
+    value = (this->position <= this->switchDistance) ? LOW : HIGH;
+    return true;
+  }
+  return false;
+}
+
+bool ClampStageModel::readAnalog(uint8_t pin, uint64_t /*nowUs*/, int &value) {
+  // ACS712-05B: 2.5 V at 0 A, 185 mV/A (the firmware converts with (2.5 V - U)/0.185 V/A)
+  if (pin != this->currentSensorPin) {
+    return false;
+  }
+  double current_A = (this->motorCurrent() + this->gaussian(this->currentNoise)) / 1000.0;
+  value = (int)lround((2.5 - current_A * 0.185) / 5.0 * 1024.0);
+  return true;
+}
@@ -0,0 +1,44 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Stage of a hotplate clamp moved by a DC motor (H-bridge inputs 1 and 2): travel time, end stops, limit switches (LOW when pressed) and the
+// output of the ACS712 current sensor, which rises with the inrush current and when the motor stalls at an end stop
+
+#ifndef ClampStageModel_h
+#define ClampStageModel_h
+#include "PlantModel.h"
+
+class ClampStageModel : public PlantModel {
+public:
+  ClampStageModel(const std::string &name, uint8_t motorPin1, uint8_t motorPin2, uint8_t currentSensorPin, uint8_t switchPinUp, uint8_t switchPinDown);
+  void update(uint64_t nowUs) override;
+  bool readDigital(uint8_t pin, uint64_t nowUs, int &value) override;
+  bool readAnalog(uint8_t pin, uint64_t nowUs, int &value) override;
+  double motorCurrent(void) const;
+  double position = 58;  // in mm above the bottom end stop (parked at the top)
+  double travel = 60;  // in mm between the end stops
+  double speed = 10;  // in mm/s
+  double spinUpTime = 40;  // time constant of the motor in ms
+  double switchDistance = 1.5;  // in mm, the limit switches are pressed this far before the end stops
+  double runningCurrent = 250;  // in mA
+  double inrushCurrent = 900;  // in mA, peak when the motor starts
+  double stallCurrent = 1400;  // in mA
+  double currentNoise = 25;  // standard deviation in mA
+private:
+  double direction(void) const;
+  uint8_t motorPin1;
+  uint8_t motorPin2;
+  uint8_t currentSensorPin;
+  uint8_t switchPinUp;
+  uint8_t switchPinDown;
+  double velocity = 0;  // in mm/s
+  double lastDirection = 0;
+  uint64_t startTimeUs = 0;
+  uint64_t lastUpdateUs = 0;
+};
+#endif
@@ -0,0 +1,361 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Virtual clock, pin state, serial port and the Arduino core functions of the host build
+
+#include <deque>
+#include <algorithm>
+#include <Arduino.h>
+#include "HostSim.h"
+
+namespace hostsim {
+
+CostModel costs;
+
+namespace {
+uint64_t clockUs = 0;
+bool advancing = false;
+
+int pinModes[NUM_DIGITAL_PINS];
+int pinOutputs[NUM_DIGITAL_PINS];
+int analogOutputs[NUM_DIGITAL_PINS];
+int servoAngles[NUM_DIGITAL_PINS];
+int digitalInputs[NUM_DIGITAL_PINS];
+int analogInputs[NUM_DIGITAL_PINS];
+
+std::vector<Model *> models;
+std::vector<I2CDevice *> i2cDevices;
+
+// Serial port: bytes arrive one character time apart and are dropped if the firmware's 64 byte RX buffer is full (like on the Arduino)
+struct PendingByte {
+  uint64_t arrivalUs;
+  uint8_t data;
+};
+std::deque<PendingByte> rxPending;
+std::deque<uint8_t> rxBuffer;
+uint64_t rxLastArrivalUs = 0;
+uint64_t txBusyUntilUs = 0;
+unsigned long baudRate = 9600;
+std::string txCapture;
+std::function<void(const uint8_t *, size_t, uint64_t)> txCallback;
+
+uint64_t loopCount = 0;
+
+uint32_t byteTimeUs(void) {
+  return (uint32_t)(10000000UL / baudRate);  // start bit, 8 data bits, stop bit
+}
+
+void receivePendingBytes(void) {
+  while (!rxPending.empty() && rxPending.front().arrivalUs <= clockUs) {
+    if (rxBuffer.size() < SERIAL_RX_BUFFER_SIZE - 1) {
+      rxBuffer.push_back(rxPending.front().data);
+    }
+    rxPending.pop_front();
+  }
+}
+}
+
+uint64_t now(void) {
+  return clockUs;
+}
+
+void advance(uint64_t us) {
+  clockUs += us;
+  if (advancing) {
+    return;  // models calling back into the shim must not recurse
+  }
+  advancing = true;
+  for (size_t i = 0; i < models.size(); i++) {
+    models[i]->update(clockUs);
+  }
+  advancing = false;
+  receivePendingBytes();
+}
+
+void reset(void) {
+  clockUs = 0;
+  for (int i = 0; i < NUM_DIGITAL_PINS; i++) {
+    pinModes[i] = INPUT;
+    pinOutputs[i] = LOW;
+    analogOutputs[i] = 0;
+    servoAngles[i] = -1;
+    digitalInputs[i] = LOW;
+    analogInputs[i] = 0;
+  }
+  rxPending.clear();
+  rxBuffer.clear();
+  rxLastArrivalUs = 0;
+  txBusyUntilUs = 0;
+  txCapture.clear();
+  loopCount = 0;
+}
+
+void setDigitalInput(uint8_t pin, int value) {
+  digitalInputs[pin] = value;
+}
+
+void setAnalogInput(uint8_t pin, int value) {
+  analogInputs[pin] = value;
+}
+
+int getPinOutput(uint8_t pin) {
+  return pinOutputs[pin];
+}
+
+int getPinMode(uint8_t pin) {
+  return pinModes[pin];
+}
+
+int getAnalogOutput(uint8_t pin) {
+  return analogOutputs[pin];
+}
+
+int getServoAngle(uint8_t pin) {
+  return servoAngles[pin];
+}
+
+void notifyServoWrite(uint8_t pin, int angle) {
+  servoAngles[pin] = angle;
+  for (size_t i = 0; i < models.size(); i++) {
+    models[i]->onServoWrite(pin, angle, clockUs);
+  }
+  advance(costs.servoWrite);
+}
+
+void addModel(Model *model) {
+  models.push_back(model);
+}
+
+void clearModels(void) {
+  models.clear();
+}
+
+void addI2CDevice(I2CDevice *device) {
+  i2cDevices.push_back(device);
+}
+
+I2CDevice *findI2CDevice(uint8_t address) {
+  for (size_t i = 0; i < i2cDevices.size(); i++) {
+    if (i2cDevices[i]->address() == address) {
+      return i2cDevices[i];
+    }
+  }
+  return NULL;
+}
+
+void clearI2CDevices(void) {
+  i2cDevices.clear();
+}
+
+void serialInject(const std::string &data) {
+  serialInjectAt(data, clockUs);
+}
+
+void serialInjectAt(const std::string &data, uint64_t startUs) {
+  uint64_t t = std::max(startUs, rxLastArrivalUs);
+  for (size_t i = 0; i < data.size(); i++) {
+    t += byteTimeUs();
+    rxPending.push_back({t, (uint8_t)data[i]});
+  }
+  rxLastArrivalUs = t;
+}
+
+unsigned long serialByteTime(void) {
+  return byteTimeUs();
+}
+
+size_t serialPendingInput(void) {
+  receivePendingBytes();
+  return rxPending.size() + rxBuffer.size();
+}
+
+std::string serialTakeOutput(void) {
+  std::string res;
+  res.swap(txCapture);
+  return res;
+}
+
+void setSerialOutputCallback(std::function<void(const uint8_t *, size_t, uint64_t)> callback) {
+  txCallback = callback;
+}
+
+void runSetup(void) {
+  for (;;) {
+    try {
+      setup();
+      return;
+    } catch (SoftReset &) {
+      continue;
+    }
+  }
+}
+
+void runLoopOnce(void) {
+  try {
+    loop();
+  } catch (SoftReset &) {
+    rxBuffer.clear();
+    runSetup();
+  }
+  loopCount++;
+}
+
+uint64_t loopIterations(void) {
+  return loopCount;
+}
+
+// Called by the Serial shim
+void serialSetBaud(unsigned long baud) {
+  baudRate = baud;
+}
+
+std::deque<uint8_t> &serialRxBuffer(void) {
+  receivePendingBytes();
+  return rxBuffer;
+}
+
+void serialTransmit(uint8_t c) {
+  // Block while the 64 byte TX buffer is full, then queue the byte behind the ones still being sent
+  uint64_t bufferSpanUs = (uint64_t)SERIAL_TX_BUFFER_SIZE * byteTimeUs();
+  if (txBusyUntilUs > clockUs + bufferSpanUs) {
+    advance(txBusyUntilUs - bufferSpanUs - clockUs);
+  }
+  txBusyUntilUs = std::max(txBusyUntilUs, clockUs) + byteTimeUs();
+  txCapture.push_back((char)c);
+  if (txCallback) {
+    txCallback(&c, 1, txBusyUntilUs);
+  }
+}
+
+uint64_t serialTxBusyUntil(void) {
+  return txBusyUntilUs;
+}
+
+int readDigitalInput(uint8_t pin) {
+  int value = digitalInputs[pin];
+  if (pinModes[pin] == OUTPUT) {
+    value = pinOutputs[pin];
+  }
+  for (size_t i = 0; i < models.size(); i++) {
+    if (models[i]->readDigital(pin, clockUs, value)) {
+      break;
+    }
+  }
+  return value;
+}
+
+int readAnalogInput(uint8_t pin) {
+  int value = analogInputs[pin];
+  for (size_t i = 0; i < models.size(); i++) {
+    if (models[i]->readAnalog(pin, clockUs, value)) {
+      break;
+    }
+  }
+  return constrain(value, 0, 1023);
+}
+
+void writeDigitalOutput(uint8_t pin, uint8_t value) {
+  pinOutputs[pin] = value ? HIGH : LOW;
+  analogOutputs[pin] = value ? 255 : 0;  // like on the Arduino, digitalWrite() ends the PWM on the pin
+  for (size_t i = 0; i < models.size(); i++) {
+    models[i]->onDigitalWrite(pin, pinOutputs[pin], clockUs);
+  }
+}
+
+void writeAnalogOutput(uint8_t pin, int value) {
+  analogOutputs[pin] = value;
+  pinOutputs[pin] = (value >= 128) ? HIGH : LOW;
+  for (size_t i = 0; i < models.size(); i++) {
+    models[i]->onAnalogWrite(pin, value, clockUs);
+  }
+}
+
+void setPinMode(uint8_t pin, uint8_t mode) {
+  pinModes[pin] = mode;
+  if (mode == INPUT_PULLUP) {
+    digitalInputs[pin] = HIGH;
+  }
+}
+}
+
+/**********************************
+ * Arduino core                   *
+ **********************************/
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < NUM_DIGITAL_PINS) {
+    hostsim::setPinMode(pin, mode);
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < NUM_DIGITAL_PINS) {
+    hostsim::writeDigitalOutput(pin, value);
+  }
+  hostsim::advance(hostsim::costs.digitalWrite);
+}
+
+int digitalRead(uint8_t pin) {
+  hostsim::advance(hostsim::costs.digitalRead);
+  return (pin < NUM_DIGITAL_PINS) ? hostsim::readDigitalInput(pin) : LOW;
+}
+
+int analogRead(uint8_t pin) {
+  if (pin < 54) {
+    pin += 54;  // allow channel numbers as well as pin numbers
+  }
+  hostsim::advance(hostsim::costs.analogRead);
+  return (pin < NUM_DIGITAL_PINS) ? hostsim::readAnalogInput(pin) : 0;
+}
+
+void analogWrite(uint8_t pin, int value) {
+  if (pin < NUM_DIGITAL_PINS) {
+    hostsim::writeAnalogOutput(pin, constrain(value, 0, 255));
+  }
+  hostsim::advance(hostsim::costs.analogWrite);
+}
+
+unsigned long millis(void) {
+  hostsim::advance(hostsim::costs.clock);
+  return (unsigned long)(hostsim::now() / 1000);
+}
+
+unsigned long micros(void) {
+  hostsim::advance(hostsim::costs.clock);
+  return (unsigned long)hostsim::now();
+}
+
+void delay(unsigned long ms) {
+  uint64_t end = hostsim::now() + (uint64_t)ms * 1000;
+  while (hostsim::now() < end) {
+    yield();
+    if (hostsim::now() < end) {
+      hostsim::advance(std::min<uint64_t>(100, end - hostsim::now()));
+    }
+  }
+}
+
+void delayMicroseconds(unsigned int us) {
+  hostsim::advance(us);
+}
+
+__attribute__((weak)) void yield(void) {
+}
+
+void noInterrupts(void) {
+}
+
+void interrupts(void) {
+}
+
+long random(long howbig) {
+  return howbig > 0 ? rand() % howbig : 0;
+}
+
+long random(long howsmall, long howbig) {
+  return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
@@ -0,0 +1,130 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <math.h>
+#include "Ina219Device.h"
+
+Ina219Device::Ina219Device(uint8_t address, float shuntResistanceOhm) {
+  this->i2cAddress = address;
+  this->shuntResistance = shuntResistanceOhm;
+}
+
+uint32_t Ina219Device::conversionTimeUs(void) const {
+  // Conversion times from the data sheet for the shunt ADC setting (bits 3-6); shunt and bus are converted one after the other
+  static const uint32_t times[16] = {84, 148, 276, 532, 84, 148, 276, 532, 532, 1060, 2130, 4260, 8510, 17020, 34050, 68100};
+  uint8_t mode = this->config & 0x07;
+  uint32_t t = times[(this->config >> 3) & 0x0F];
+  return (mode == 0x03 || mode == 0x07) ? 2 * t : t;
+}
+
+void Ina219Device::convert(uint64_t nowUs) {
+  static const float pgaRange_mV[4] = {40.0, 80.0, 160.0, 320.0};
+  float i = this->current_mA ? this->current_mA(nowUs) : 0.0;
+  float v = this->busVoltage_V ? this->busVoltage_V(nowUs) : 12.0;
+  float shunt_mV = i * this->shuntResistance;
+  float range = pgaRange_mV[(this->config >> 11) & 0x03];
+
+  this->overflow = fabs(shunt_mV) > range;
+  shunt_mV = fmax(-range, fmin(range, shunt_mV));
+  this->shunt = (int16_t)lround(shunt_mV / 0.01);
+  this->bus = (uint16_t)(((uint16_t)lround(fmax(0.0, v) / 0.004)) << 3);
+  if (this->calibration != 0) {
+    // Current LSB follows from the calibration register: Current_LSB = 0.04096 / (Cal * R_shunt)
+    long currentRegister = lround((double)this->shunt * this->calibration / 4096.0);
+    this->current = (int16_t)fmax(-32768, fmin(32767, currentRegister));
+    this->power = (uint16_t)(labs((long)this->current * (long)(this->bus >> 3)) / 5000);
+  }
+  this->conversionReady = true;
+}
+
+void Ina219Device::updateConversions(uint64_t nowUs) {
+  uint8_t mode = this->config & 0x07;
+  if (this->conversionPending && nowUs >= this->conversionDoneUs) {
+    this->convert(this->conversionDoneUs);
+    this->conversionPending = false;
+    if (mode >= 0x05) {
+      // continuous mode: start the next conversion right away
+      uint32_t t = this->conversionTimeUs();
+      uint64_t done = this->conversionDoneUs + t;
+      while (done + t <= nowUs) {
+        done += t;
+      }
+      if (done <= nowUs) {
+        this->convert(done);
+        done += t;
+      }
+      this->conversionDoneUs = done;
+      this->conversionPending = true;
+    }
+  }
+}
+
+void Ina219Device::receive(const uint8_t *data, size_t length, uint64_t nowUs) {
+  this->updateConversions(nowUs);
+  if (length == 0) {
+    return;
+  }
+  this->registerPointer = data[0];
+  if (length < 3) {
+    return;
+  }
+  uint16_t value = ((uint16_t)data[1] << 8) | data[2];
+  if (this->registerPointer == 0x00) {
+    if (value & 0x8000) {
+      this->config = 0x399F;
+      this->calibration = 0;
+      this->conversionPending = false;
+      return;
+    }
+    this->config = value;
+    this->conversionReady = false;
+    uint8_t mode = value & 0x07;
+    if (mode != 0 && mode != 0x04) {
+      // writing the configuration register (re)starts a conversion in triggered and continuous modes
+      this->conversionPending = true;
+      this->conversionDoneUs = nowUs + this->conversionTimeUs();
+    } else {
+      this->conversionPending = false;
+    }
+  } else if (this->registerPointer == 0x05) {
+    this->calibration = value & 0xFFFE;
+  }
+}
+
+size_t Ina219Device::transmit(uint8_t *data, size_t length, uint64_t nowUs) {
+  uint16_t value = 0;
+  this->updateConversions(nowUs);
+  switch (this->registerPointer) {
+    case 0x00:
+      value = this->config;
+      break;
+    case 0x01:
+      value = (uint16_t)this->shunt;
+      break;
+    case 0x02:
+      value = this->bus | (this->conversionReady ? 0x02 : 0x00) | (this->overflow ? 0x01 : 0x00);
+      break;
+    case 0x03:
+      value = this->power;
+      this->conversionReady = false;  // reading the power register clears CNVR
+      break;
+    case 0x04:
+      value = (uint16_t)this->current;
+      break;
+    case 0x05:
+      value = this->calibration;
+      break;
+  }
+  if (length > 0) {
+    data[0] = value >> 8;
+  }
+  if (length > 1) {
+    data[1] = value & 0xFF;
+  }
+  return length < 2 ? length : 2;
+}
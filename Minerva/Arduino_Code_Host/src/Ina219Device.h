@@ -0,0 +1,42 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Register level model of an INA219 current sensor on the simulated I2C bus, including conversion times and the CNVR/OVF flags
+
+#ifndef Ina219Device_h
+#define Ina219Device_h
+#include <functional>
+#include "HostSim.h"
+
+class Ina219Device : public hostsim::I2CDevice {
+public:
+  Ina219Device(uint8_t address, float shuntResistanceOhm=0.1);
+  uint8_t address(void) const override { return this->i2cAddress; }
+  void receive(const uint8_t *data, size_t length, uint64_t nowUs) override;
+  size_t transmit(uint8_t *data, size_t length, uint64_t nowUs) override;
+  std::function<float(uint64_t nowUs)> current_mA;  // true current through the shunt
+  std::function<float(uint64_t nowUs)> busVoltage_V;
+  uint32_t conversionTimeUs(void) const;
+private:
+  void convert(uint64_t nowUs);
+  void updateConversions(uint64_t nowUs);
+  uint8_t i2cAddress;
+  float shuntResistance;
+  uint8_t registerPointer = 0;
+  uint16_t config = 0x399F;
+  uint16_t calibration = 0;
+  int16_t shunt = 0;
+  uint16_t bus = 0;
+  uint16_t power = 0;
+  int16_t current = 0;
+  bool conversionReady = false;
+  bool overflow = false;
+  bool conversionPending = false;
+  uint64_t conversionDoneUs = 0;
+};
+#endif
@@ -0,0 +1,41 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Common base of the physical device models: named parameters (changed from the command line or by test programs) and reproducible sensor noise
+
+#ifndef PlantModel_h
+#define PlantModel_h
+#include <map>
+#include <random>
+#include <string>
+#include "HostSim.h"
+
+class PlantModel : public hostsim::Model {
+public:
+  explicit PlantModel(const std::string &name) : name(name) { this->addParameter("noise", &this->noise); }
+  bool setParameter(const std::string &parameter, double value) {
+    std::map<std::string, double *>::iterator it = this->parameters.find(parameter);
+    if (it == this->parameters.end()) {
+      return false;
+    }
+    *(it->second) = value;
+    return true;
+  }
+  const std::map<std::string, double *> &getParameters(void) const { return this->parameters; }
+  void seed(uint32_t value) { this->random.seed(value); }
+  const std::string name;
+  double noise = 1.0;  // scales the sensor noise of the model (0: noise-free)
+protected:
+  void addParameter(const std::string &parameter, double *value) { this->parameters[parameter] = value; }
+  double gaussian(double sigma) { return (sigma > 0.0 && this->noise > 0.0) ? std::normal_distribution<double>(0.0, sigma * this->noise)(this->random) : 0.0; }
+  double dutyOf(uint8_t pin) const { return hostsim::getAnalogOutput(pin) / 255.0; }  // PWM duty (or 0/1 for digital outputs) of an output pin
+  std::mt19937 random;
+private:
+  std::map<std::string, double *> parameters;
+};
+#endif
@@ -0,0 +1,616 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Serial, Servo, Wire, INA219_WE, AccelStepper, SimpleDHT, EEPROM and watchdog replacements of the host build
+
+#include <deque>
+#include <functional>
+#include <Arduino.h>
+#include <Servo.h>
+#include <Wire.h>
+#include <INA219_WE.h>
+#include <AccelStepper.h>
+#include <SimpleDHT.h>
+#include <EEPROM.h>
+#include <avr/wdt.h>
+#include "HostSim.h"
+
+namespace hostsim {
+void serialSetBaud(unsigned long baud);
+std::deque<uint8_t> &serialRxBuffer(void);
+void serialTransmit(uint8_t c);
+uint64_t serialTxBusyUntil(void);
+
+std::function<bool(uint8_t pin, uint64_t nowUs, float &temperature, float &humidity)> dht22Provider;
+
+void setDHT22Provider(std::function<bool(uint8_t pin, uint64_t nowUs, float &temperature, float &humidity)> provider) {
+  dht22Provider = provider;
+}
+}
+
+HardwareSerial Serial;
+TwoWire Wire;
+EEPROMClass EEPROM;
+uint8_t MCUSR = 0;
+
+/**********************************
+ * HardwareSerial                 *
+ **********************************/
+void HardwareSerial::begin(unsigned long baud) {
+  this->baudRate = baud;
+  hostsim::serialSetBaud(baud);
+}
+
+int HardwareSerial::available(void) {
+  hostsim::advance(hostsim::costs.clock);
+  return (int)hostsim::serialRxBuffer().size();
+}
+
+int HardwareSerial::availableForWrite(void) {
+  uint64_t busy = hostsim::serialTxBusyUntil();
+  uint64_t now = hostsim::now();
+  long queued = (busy > now) ? (long)((busy - now) / hostsim::serialByteTime()) : 0;
+  return (queued >= SERIAL_TX_BUFFER_SIZE - 1) ? 0 : (int)(SERIAL_TX_BUFFER_SIZE - 1 - queued);
+}
+
+int HardwareSerial::peek(void) {
+  std::deque<uint8_t> &rx = hostsim::serialRxBuffer();
+  return rx.empty() ? -1 : rx.front();
+}
+
+int HardwareSerial::read(void) {
+  std::deque<uint8_t> &rx = hostsim::serialRxBuffer();
+  if (rx.empty()) {
+    return -1;
+  }
+  uint8_t c = rx.front();
+  rx.pop_front();
+  return c;
+}
+
+void HardwareSerial::flush(void) {
+  uint64_t busy = hostsim::serialTxBusyUntil();
+  if (busy > hostsim::now()) {
+    hostsim::advance(busy - hostsim::now());
+  }
+}
+
+String HardwareSerial::readStringUntil(char terminator) {
+  String res;
+  for (;;) {
+    unsigned long startTime = millis();
+    int c = -1;
+    do {
+      c = this->read();
+      if (c >= 0) {
+        break;
+      }
+      hostsim::advance(50);
+    } while (millis() - startTime < this->timeout);
+    if (c < 0 || c == terminator) {
+      return res;
+    }
+    res += (char)c;
+  }
+}
+
+size_t HardwareSerial::readBytes(char *buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    unsigned long startTime = millis();
+    int c = -1;
+    do {
+      c = this->read();
+      if (c >= 0) {
+        break;
+      }
+      hostsim::advance(50);
+    } while (millis() - startTime < this->timeout);
+    if (c < 0) {
+      break;
+    }
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  hostsim::serialTransmit(c);
+  hostsim::advance(2);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    this->write(buffer[i]);
+  }
+  return size;
+}
+
+/**********************************
+ * Servo                          *
+ **********************************/
+uint8_t Servo::attach(int pin) {
+  this->pin = (uint8_t)pin;
+  hostsim::notifyServoWrite(this->pin, this->angle);
+  return 0;
+}
+
+void Servo::write(int value) {
+  if (value >= MIN_PULSE_WIDTH) {
+    this->writeMicroseconds(value);
+    return;
+  }
+  this->angle = constrain(value, 0, 180);
+  if (this->pin != INVALID_SERVO) {
+    hostsim::notifyServoWrite(this->pin, this->angle);
+  }
+}
+
+/**********************************
+ * Wire                           *
+ **********************************/
+uint32_t TwoWire::byteTime(void) const {
+  return (uint32_t)(9000000UL / this->clock);
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  this->txAddress = address;
+  this->txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (this->txLength >= BUFFER_LENGTH) {
+    return 0;
+  }
+  this->txBuffer[this->txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity) {
+  for (size_t i = 0; i < quantity; i++) {
+    if (!this->write(data[i])) {
+      return i;
+    }
+  }
+  return quantity;
+}
+
+uint8_t TwoWire::endTransmission(bool /*sendStop*/) {
+  hostsim::I2CDevice *device = hostsim::findI2CDevice(this->txAddress);
+  if (device == NULL) {
+    hostsim::advance(this->byteTime());
+    return 2;  // address NACK
+  }
+  hostsim::advance((uint64_t)(this->txLength + 1) * this->byteTime());
+  device->receive(this->txBuffer, this->txLength, hostsim::now());
+  this->txLength = 0;
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool /*sendStop*/) {
+  hostsim::I2CDevice *device = hostsim::findI2CDevice(address);
+  this->rxIndex = 0;
+  this->rxLength = 0;
+  if (device == NULL) {
+    hostsim::advance(this->byteTime());
+    return 0;
+  }
+  if (quantity > BUFFER_LENGTH) {
+    quantity = BUFFER_LENGTH;
+  }
+  hostsim::advance((uint64_t)(quantity + 1) * this->byteTime());
+  this->rxLength = (uint8_t)device->transmit(this->rxBuffer, quantity, hostsim::now());
+  return this->rxLength;
+}
+
+/**********************************
+ * INA219_WE                      *
+ **********************************/
+bool INA219_WE::init(void) {
+  if (!this->reset_INA219()) {
+    return false;
+  }
+  this->setADCMode(BIT_MODE_12);
+  this->setMeasureMode(CONTINUOUS);
+  this->setPGain(PG_320);
+  this->setBusRange(BRNG_32);
+  this->shuntVoltageOffset = 0.0;
+  return true;
+}
+
+bool INA219_WE::reset_INA219(void) {
+  return this->writeRegister(INA219_CONF_REG, INA219_RST) == 0;
+}
+
+void INA219_WE::setADCMode(INA219_ADC_MODE mode) {
+  this->confRegCopy = this->readRegister(INA219_CONF_REG);
+  this->confRegCopy &= ~(0x0780);
+  this->confRegCopy &= ~(0x0078);
+  this->confRegCopy |= (uint16_t)mode << 3;
+  this->confRegCopy |= (uint16_t)mode << 7;
+  this->writeRegister(INA219_CONF_REG, this->confRegCopy);
+}
+
+void INA219_WE::setMeasureMode(INA219_MEASURE_MODE mode) {
+  this->measureMode = mode;
+  this->confRegCopy = this->readRegister(INA219_CONF_REG);
+  this->confRegCopy &= ~(0x0007);
+  this->confRegCopy |= mode;
+  this->writeRegister(INA219_CONF_REG, this->confRegCopy);
+}
+
+void INA219_WE::setPGain(INA219_PGAIN gain) {
+  this->confRegCopy = this->readRegister(INA219_CONF_REG);
+  this->confRegCopy &= ~(0x1800);
+  this->confRegCopy |= gain;
+  this->writeRegister(INA219_CONF_REG, this->confRegCopy);
+  switch (gain) {
+    case PG_40:
+      this->calVal = 20480;
+      this->currentDivider_mA = 50.0;
+      this->pwrMultiplier_mW = 0.4;
+      break;
+    case PG_80:
+      this->calVal = 10240;
+      this->currentDivider_mA = 25.0;
+      this->pwrMultiplier_mW = 0.8;
+      break;
+    case PG_160:
+      this->calVal = 8192;
+      this->currentDivider_mA = 20.0;
+      this->pwrMultiplier_mW = 1.0;
+      break;
+    case PG_320:
+      this->calVal = 4096;
+      this->currentDivider_mA = 10.0;
+      this->pwrMultiplier_mW = 2.0;
+      break;
+  }
+  this->calValCorrected = this->calVal;
+  this->writeRegister(INA219_CAL_REG, this->calValCorrected);
+}
+
+void INA219_WE::setBusRange(INA219_BUS_RANGE range) {
+  this->confRegCopy = this->readRegister(INA219_CONF_REG);
+  this->confRegCopy &= ~(0x2000);
+  this->confRegCopy |= range;
+  this->writeRegister(INA219_CONF_REG, this->confRegCopy);
+}
+
+float INA219_WE::getShuntVoltage_mV(void) {
+  int16_t val = (int16_t)this->readRegister(INA219_SHUNT_REG);
+  return (val * 0.01) - this->shuntVoltageOffset;
+}
+
+float INA219_WE::getBusVoltage_V(void) {
+  uint16_t val = this->readRegister(INA219_BUS_REG);
+  this->overflow = (val & 1);
+  return ((val >> 3) * 4) * 0.001;
+}
+
+float INA219_WE::getCurrent_mA(void) {
+  int16_t val = (int16_t)this->readRegister(INA219_CURRENT_REG);
+  return (val / this->currentDivider_mA);
+}
+
+float INA219_WE::getBusPower(void) {
+  uint16_t val = this->readRegister(INA219_PWR_REG);
+  return (val * this->pwrMultiplier_mW);
+}
+
+bool INA219_WE::getOverflow(void) {
+  uint16_t val = this->readRegister(INA219_BUS_REG);
+  this->overflow = (val & 1);
+  return this->overflow;
+}
+
+bool INA219_WE::getConversionReady(void) {
+  uint16_t val = this->readRegister(INA219_BUS_REG);
+  return (val >> 1) & 1;
+}
+
+void INA219_WE::startSingleMeasurement(void) {
+  this->startSingleMeasurement(2000000UL);
+}
+
+bool INA219_WE::startSingleMeasurement(unsigned long timeout_us) {
+  uint16_t val = this->readRegister(INA219_BUS_REG);  // clears CNVR (Conversion Ready) Flag
+  val = this->readRegister(INA219_CONF_REG);
+  this->writeRegister(INA219_CONF_REG, val);
+  unsigned long startTime = micros();
+  uint16_t convReady = 0;
+  while (!convReady && (micros() - startTime < timeout_us)) {
+    convReady = ((this->readRegister(INA219_BUS_REG)) & 0x0002);  // checks if sampling is completed
+  }
+  return convReady != 0;
+}
+
+void INA219_WE::powerDown(void) {
+  this->confRegCopy = this->readRegister(INA219_CONF_REG);
+  this->setMeasureMode(POWER_DOWN);
+}
+
+void INA219_WE::powerUp(void) {
+  this->writeRegister(INA219_CONF_REG, this->confRegCopy);
+  delayMicroseconds(40);
+}
+
+uint8_t INA219_WE::writeRegister(uint8_t reg, uint16_t val) {
+  Wire.beginTransmission(this->i2cAddress);
+  uint8_t lVal = val & 255;
+  uint8_t hVal = val >> 8;
+  Wire.write(reg);
+  Wire.write(hVal);
+  Wire.write(lVal);
+  return Wire.endTransmission();
+}
+
+uint16_t INA219_WE::readRegister(uint8_t reg) {
+  uint8_t MSByte = 0, LSByte = 0;
+  uint16_t regValue = 0;
+  Wire.beginTransmission(this->i2cAddress);
+  Wire.write(reg);
+  Wire.endTransmission(false);
+  Wire.requestFrom((uint8_t)this->i2cAddress, (uint8_t)2);
+  if (Wire.available()) {
+    MSByte = Wire.read();
+    LSByte = Wire.read();
+  }
+  regValue = (MSByte << 8) + LSByte;
+  return regValue;
+}
+
+/**********************************
+ * AccelStepper                   *
+ **********************************/
+AccelStepper::AccelStepper(uint8_t interface, uint8_t pin1, uint8_t pin2, uint8_t pin3, uint8_t pin4, bool enable) {
+  this->_interface = interface;
+  this->_pin[0] = pin1;
+  this->_pin[1] = pin2;
+  this->_pin[2] = pin3;
+  this->_pin[3] = pin4;
+  if (enable) {
+    this->enableOutputs();
+  }
+  this->setAcceleration(1);
+  this->setMaxSpeed(1);
+}
+
+void AccelStepper::enableOutputs(void) {
+  pinMode(this->_pin[0], OUTPUT);
+  pinMode(this->_pin[1], OUTPUT);
+}
+
+void AccelStepper::moveTo(long absolute) {
+  if (this->_targetPos != absolute) {
+    this->_targetPos = absolute;
+    this->computeNewSpeed();
+  }
+}
+
+void AccelStepper::move(long relative) {
+  this->moveTo(this->_currentPos + relative);
+}
+
+bool AccelStepper::runSpeed(void) {
+  hostsim::advance(hostsim::costs.stepperRun);
+  if (!this->_stepInterval) {
+    return false;
+  }
+  unsigned long time = micros();
+  if (time - this->_lastStepTime >= this->_stepInterval) {
+    if (this->_direction == DIRECTION_CW) {
+      this->_currentPos += 1;
+    } else {
+      this->_currentPos -= 1;
+    }
+    this->step(this->_currentPos);
+    this->_lastStepTime = time;
+    return true;
+  }
+  return false;
+}
+
+void AccelStepper::setCurrentPosition(long position) {
+  this->_targetPos = this->_currentPos = position;
+  this->_n = 0;
+  this->_stepInterval = 0;
+  this->_speed = 0.0;
+}
+
+void AccelStepper::computeNewSpeed(void) {
+  long distanceTo = this->distanceToGo();
+  long stepsToStop = (long)((this->_speed * this->_speed) / (2.0 * this->_acceleration));
+
+  if (distanceTo == 0 && stepsToStop <= 1) {
+    this->_stepInterval = 0;
+    this->_speed = 0.0;
+    this->_n = 0;
+    return;
+  }
+
+  if (distanceTo > 0) {
+    if (this->_n > 0) {
+      if ((stepsToStop >= distanceTo) || this->_direction == DIRECTION_CCW) {
+        this->_n = -stepsToStop;
+      }
+    } else if (this->_n < 0) {
+      if ((stepsToStop < distanceTo) && this->_direction == DIRECTION_CW) {
+        this->_n = -this->_n;
+      }
+    }
+  } else if (distanceTo < 0) {
+    if (this->_n > 0) {
+      if ((stepsToStop >= -distanceTo) || this->_direction == DIRECTION_CW) {
+        this->_n = -stepsToStop;
+      }
+    } else if (this->_n < 0) {
+      if ((stepsToStop < -distanceTo) && this->_direction == DIRECTION_CCW) {
+        this->_n = -this->_n;
+      }
+    }
+  }
+
+  if (this->_n == 0) {
+    this->_cn = this->_c0;
+    this->_direction = (distanceTo > 0) ? DIRECTION_CW : DIRECTION_CCW;
+  } else {
+    this->_cn = this->_cn - ((2.0 * this->_cn) / ((4.0 * this->_n) + 1));
+    this->_cn = max(this->_cn, this->_cmin);
+  }
+  this->_n++;
+  this->_stepInterval = this->_cn;
+  this->_speed = 1000000.0 / this->_cn;
+  if (this->_direction == DIRECTION_CCW) {
+    this->_speed = -this->_speed;
+  }
+}
+
+bool AccelStepper::run(void) {
+  if (this->runSpeed()) {
+    this->computeNewSpeed();
+  }
+  return this->_speed != 0.0 || this->distanceToGo() != 0;
+}
+
+void AccelStepper::setMaxSpeed(float speed) {
+  if (speed < 0.0) {
+    speed = -speed;
+  }
+  if (this->_maxSpeed != speed) {
+    this->_maxSpeed = speed;
+    this->_cmin = 1000000.0 / speed;
+    if (this->_n > 0) {
+      this->_n = (long)((this->_speed * this->_speed) / (2.0 * this->_acceleration));
+      this->computeNewSpeed();
+    }
+  }
+}
+
+void AccelStepper::setAcceleration(float acceleration) {
+  if (acceleration == 0.0) {
+    return;
+  }
+  if (acceleration < 0.0) {
+    acceleration = -acceleration;
+  }
+  if (this->_acceleration != acceleration) {
+    this->_n = this->_n * (this->_acceleration / acceleration);
+    this->_c0 = 0.676 * sqrt(2.0 / acceleration) * 1000000.0;
+    this->_acceleration = acceleration;
+    this->computeNewSpeed();
+  }
+}
+
+void AccelStepper::setSpeed(float speed) {
+  if (speed == this->_speed) {
+    return;
+  }
+  speed = constrain(speed, -this->_maxSpeed, this->_maxSpeed);
+  if (speed == 0.0) {
+    this->_stepInterval = 0;
+  } else {
+    this->_stepInterval = fabs(1000000.0 / speed);
+    this->_direction = (speed > 0.0) ? DIRECTION_CW : DIRECTION_CCW;
+  }
+  this->_speed = speed;
+}
+
+void AccelStepper::runToPosition(void) {
+  while (this->run()) {
+    yield();
+  }
+}
+
+bool AccelStepper::runSpeedToPosition(void) {
+  if (this->_targetPos == this->_currentPos) {
+    return false;
+  }
+  if (this->_targetPos > this->_currentPos) {
+    this->_direction = DIRECTION_CW;
+  } else {
+    this->_direction = DIRECTION_CCW;
+  }
+  return this->runSpeed();
+}
+
+void AccelStepper::runToNewPosition(long position) {
+  this->moveTo(position);
+  this->runToPosition();
+}
+
+void AccelStepper::stop(void) {
+  if (this->_speed != 0.0) {
+    long stepsToStop = (long)((this->_speed * this->_speed) / (2.0 * this->_acceleration)) + 1;
+    if (this->_speed > 0) {
+      this->move(stepsToStop);
+    } else {
+      this->move(-stepsToStop);
+    }
+  }
+}
+
+void AccelStepper::step(long /*step*/) {
+  // DRIVER interface: pin[0] is STEP, pin[1] is DIR
+  digitalWrite(this->_pin[1], this->_direction ? HIGH : LOW);
+  digitalWrite(this->_pin[0], HIGH);
+  delayMicroseconds(this->_minPulseWidth);
+  digitalWrite(this->_pin[0], LOW);
+}
+
+/**********************************
+ * SimpleDHT                      *
+ **********************************/
+int SimpleDHT22::read(byte *ptemperature, byte *phumidity, byte pdata[40]) {
+  float t = 0;
+  float h = 0;
+  int err = this->read2(&t, &h, pdata);
+  if (ptemperature) {
+    *ptemperature = (byte)t;
+  }
+  if (phumidity) {
+    *phumidity = (byte)h;
+  }
+  return err;
+}
+
+int SimpleDHT22::read2(float *ptemperature, float *phumidity, byte /*pdata*/[40]) {
+  static uint64_t lastReadUs[NUM_DIGITAL_PINS];
+  static bool hasBeenRead[NUM_DIGITAL_PINS];
+  float t = 22.0;
+  float h = 40.0;
+
+  if (this->pin < 0 || this->pin >= NUM_DIGITAL_PINS) {
+    return SimpleDHTErrNoPin;
+  }
+  // Start signal (1 ms low, 30 us high) followed by the 80 us response and 40 data bits, busy-waited like in the original
+  hostsim::advance(1000 + 30 + 160 + 40 * 100);
+  if (hasBeenRead[this->pin] && hostsim::now() - lastReadUs[this->pin] < 2000000ULL) {
+    return SimpleDHTErrStartLow;  // the sensor does not answer while it is still busy with the previous measurement
+  }
+  hasBeenRead[this->pin] = true;
+  lastReadUs[this->pin] = hostsim::now();
+  if (hostsim::dht22Provider && !hostsim::dht22Provider((uint8_t)this->pin, hostsim::now(), t, h)) {
+    return SimpleDHTErrDataChecksum;
+  }
+  if (ptemperature) {
+    *ptemperature = t;
+  }
+  if (phumidity) {
+    *phumidity = h;
+  }
+  return SimpleDHTErrSuccess;
+}
+
+/**********************************
+ * Watchdog                       *
+ **********************************/
+void wdt_enable(uint8_t /*timeout*/) {
+  throw hostsim::SoftReset();
+}
@@ -0,0 +1,12 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Compiles the unmodified dispatcher sketch as a C++ translation unit (the Arduino IDE does the same after adding the Arduino.h include)
+
+#include <Arduino.h>
+#include "Arduino_Code.ino"
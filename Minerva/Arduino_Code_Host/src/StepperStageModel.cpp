@@ -0,0 +1,45 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <math.h>
+#include <Arduino.h>
+#include "StepperStageModel.h"
+
+StepperStageModel::StepperStageModel(const std::string &name, uint8_t stepPin, uint8_t dirPin, uint8_t sleepPin, uint8_t switchPin, double stepsPerMillimeter) : PlantModel(name) {
+  this->stepPin = stepPin;
+  this->dirPin = dirPin;
+  this->sleepPin = sleepPin;
+  this->switchPin = switchPin;
+  this->stepsPerMillimeter = stepsPerMillimeter;
+  this->addParameter("position", &this->position);
+  this->addParameter("travel", &this->travel);
+  this->addParameter("steps_per_mm", &this->stepsPerMillimeter);
+  this->addParameter("switch_distance", &this->switchDistance);
+  this->addParameter("missed_steps", &this->missedSteps);
+}
+
+void StepperStageModel::onDigitalWrite(uint8_t pin, uint8_t value, uint64_t /*nowUs*/) {
+  // The driver steps on the rising edge of STEP while it is awake (SLEEP HIGH), the end stops block the stage
+  if (pin != this->stepPin || value != HIGH || hostsim::getPinOutput(this->sleepPin) != HIGH) {
+    return;
+  }
+  this->steps++;
+  if (this->missedSteps > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(this->random) < this->missedSteps) {
+    return;
+  }
+  this->position += ((hostsim::getPinOutput(this->dirPin) == HIGH) ? -1.0 : 1.0) / this->stepsPerMillimeter;
+  this->position = fmax(0.0, fmin(this->travel, this->position));
+}
+
+bool StepperStageModel::readDigital(uint8_t pin, uint64_t /*nowUs*/, int &value) {
+  if (pin != this->switchPin) {
+    return false;
+  }
+  value = (this->position <= this->switchDistance) ? LOW : HIGH;
+  return true;
+}
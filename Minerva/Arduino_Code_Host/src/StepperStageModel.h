@@ -0,0 +1,33 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Stage of a hotplate clamp moved by a stepper motor driver (STEP/DIR/SLEEP) on a lead screw: end stops and the limit switch at the
+// home position (LOW when pressed)
+
+#ifndef StepperStageModel_h
+#define StepperStageModel_h
+#include "PlantModel.h"
+
+class StepperStageModel : public PlantModel {
+public:
+  StepperStageModel(const std::string &name, uint8_t stepPin, uint8_t dirPin, uint8_t sleepPin, uint8_t switchPin, double stepsPerMillimeter);
+  void onDigitalWrite(uint8_t pin, uint8_t value, uint64_t nowUs) override;
+  bool readDigital(uint8_t pin, uint64_t nowUs, int &value) override;
+  double position = 100;  // in mm above the bottom end stop, decreases with DIR HIGH (parked at the top)
+  double travel = 110;  // in mm between the end stops
+  double stepsPerMillimeter;
+  double switchDistance = 0.5;  // in mm, the limit switch is pressed this far before the bottom end stop
+  double missedSteps = 0;  // fraction of steps that are lost (e.g. stalling at high speeds)
+  double steps = 0;  // step pulses received while the driver was enabled
+private:
+  uint8_t stepPin;
+  uint8_t dirPin;
+  uint8_t sleepPin;
+  uint8_t switchPin;
+};
+#endif
@@ -0,0 +1,63 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <math.h>
+#include <Arduino.h>
+#include "ValveModel.h"
+
+ValveModel::ValveModel(const std::string &name, uint8_t stepPin, uint8_t dirPin, uint8_t sleepPin, bool enableIsHigh, uint8_t hallSensorPin, int stepsPerRevolution, int ports) : PlantModel(name) {
+  this->stepPin = stepPin;
+  this->dirPin = dirPin;
+  this->sleepPin = sleepPin;
+  this->enableIsHigh = enableIsHigh;
+  this->hallSensorPin = hallSensorPin;
+  this->stepsPerRevolution = stepsPerRevolution;
+  this->ports = ports;
+  this->addParameter("reversed_magnet", &this->reversedMagnet);
+  this->addParameter("offset", &this->offset);
+  this->addParameter("idle_signal", &this->idleSignal);
+  this->addParameter("amplitude", &this->amplitude);
+  this->addParameter("width", &this->width);
+  this->addParameter("signal_noise", &this->signalNoise);
+  this->addParameter("missed_steps", &this->missedSteps);
+}
+
+void ValveModel::onDigitalWrite(uint8_t pin, uint8_t value, uint64_t /*nowUs*/) {
+  // The driver steps on the rising edge of STEP while it is enabled
+  if (pin != this->stepPin || value != HIGH || hostsim::getPinOutput(this->sleepPin) != (this->enableIsHigh ? HIGH : LOW)) {
+    return;
+  }
+  this->steps++;
+  if (this->missedSteps > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(this->random) < this->missedSteps) {
+    return;
+  }
+  this->position += (hostsim::getPinOutput(this->dirPin) == HIGH) ? 1 : -1;
+}
+
+double ValveModel::hallSignal(long position) const {
+  // Sum of the fields of all magnets; the peaks are Gaussians in the angular distance between magnet and sensor
+  double spacing = this->stepsPerRevolution / this->ports;
+  double signal = this->idleSignal;
+  for (int i = 0; i < (int)this->ports; i++) {
+    double d = fmod(this->offset + i * spacing + position, this->stepsPerRevolution);
+    if (d < 0) {
+      d += this->stepsPerRevolution;
+    }
+    d = fmin(d, this->stepsPerRevolution - d) / (this->width * spacing);
+    signal += ((i == (int)this->reversedMagnet) ? -1.0 : 1.0) * this->amplitude * exp(-d * d);
+  }
+  return signal;
+}
+
+bool ValveModel::readAnalog(uint8_t pin, uint64_t /*nowUs*/, int &value) {
+  if (pin != this->hallSensorPin) {
+    return false;
+  }
+  value = (int)lround(this->hallSignal(this->position) + this->gaussian(this->signalNoise));
+  return true;
+}
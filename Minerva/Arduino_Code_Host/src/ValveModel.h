@@ -0,0 +1,40 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Rotor of a switching valve driven by a stepper motor driver (STEP/DIR/SLEEP): one magnet per port, one of them with reversed polarity,
+// passing a Hall sensor whose analog output depends on the step angle
+
+#ifndef ValveModel_h
+#define ValveModel_h
+#include "PlantModel.h"
+
+class ValveModel : public PlantModel {
+public:
+  ValveModel(const std::string &name, uint8_t stepPin, uint8_t dirPin, uint8_t sleepPin, bool enableIsHigh, uint8_t hallSensorPin, int stepsPerRevolution, int ports);
+  void onDigitalWrite(uint8_t pin, uint8_t value, uint64_t nowUs) override;
+  bool readAnalog(uint8_t pin, uint64_t nowUs, int &value) override;
+  double hallSignal(long position) const;
+  long position = 0;  // rotor position in (micro)steps, increases with DIR HIGH
+  double stepsPerRevolution;
+  double ports;
+  double reversedMagnet = 3;  // index of the magnet with reversed polarity, counted from the sensor in the direction of increasing positions
+  double offset = 0;  // position of magnet 0 in steps
+  double idleSignal = 512;  // Hall sensor output without magnet
+  double amplitude = 260;  // signal of a magnet right in front of the sensor
+  double width = 0.2;  // 1/e half width of a peak as a fraction of the magnet spacing (gotoPosition() needs peaks wider than its coarse steps)
+  double signalNoise = 2.0;  // standard deviation in ADC counts
+  double missedSteps = 0;  // fraction of steps that are lost (e.g. stalling at high speeds)
+  double steps = 0;  // step pulses received while the driver was enabled
+private:
+  uint8_t stepPin;
+  uint8_t dirPin;
+  uint8_t sleepPin;
+  bool enableIsHigh;
+  uint8_t hallSensorPin;
+};
+#endif
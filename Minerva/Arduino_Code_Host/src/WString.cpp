@@ -0,0 +1,114 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <stdio.h>
+#include <cmath>
+#include <ctype.h>
+#include <stdlib.h>
+#include "WString.h"
+
+std::string String::fromInteger(long long value, unsigned char base) {
+  const char digits[] = "0123456789ABCDEF";
+  std::string res;
+  bool negative = (value < 0 && base == 10);
+  unsigned long long v = negative ? (unsigned long long)(-value) : (unsigned long long)value;
+  if (base < 2 || base > 16) {
+    base = 10;
+  }
+  if (!negative && value < 0) {
+    v = (unsigned long)value;  // two's complement representation like on the Arduino
+  }
+  do {
+    res.insert(res.begin(), digits[v % base]);
+    v /= base;
+  } while (v > 0);
+  if (negative) {
+    res.insert(res.begin(), '-');
+  }
+  return res;
+}
+
+std::string String::fromFloat(double value, unsigned char decimalPlaces) {
+  char buf[64];
+  if (std::isnan(value)) {
+    return "nan";
+  }
+  if (std::isinf(value)) {
+    return "inf";
+  }
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  return buf;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) {
+    unsigned int tmp = from;
+    from = to;
+    to = tmp;
+  }
+  if (from >= this->str.length()) {
+    return String();
+  }
+  if (to > this->str.length()) {
+    to = this->str.length();
+  }
+  return String(this->str.substr(from, to - from));
+}
+
+void String::replace(const String &find, const String &replacement) {
+  if (find.str.empty()) {
+    return;
+  }
+  size_t pos = 0;
+  while ((pos = this->str.find(find.str, pos)) != std::string::npos) {
+    this->str.replace(pos, find.str.length(), replacement.str);
+    pos += replacement.str.length();
+  }
+}
+
+void String::toLowerCase(void) {
+  for (size_t i = 0; i < this->str.length(); i++) {
+    this->str[i] = (char)tolower((unsigned char)this->str[i]);
+  }
+}
+
+void String::toUpperCase(void) {
+  for (size_t i = 0; i < this->str.length(); i++) {
+    this->str[i] = (char)toupper((unsigned char)this->str[i]);
+  }
+}
+
+void String::trim(void) {
+  size_t begin = this->str.find_first_not_of(" \t\r\n");
+  size_t end = this->str.find_last_not_of(" \t\r\n");
+  this->str = (begin == std::string::npos) ? "" : this->str.substr(begin, end - begin + 1);
+}
+
+void String::toCharArray(char *buf, unsigned int bufsize, unsigned int index) const {
+  if (bufsize == 0 || buf == NULL) {
+    return;
+  }
+  if (index >= this->str.length()) {
+    buf[0] = 0;
+    return;
+  }
+  unsigned int n = bufsize - 1;
+  if (n > this->str.length() - index) {
+    n = this->str.length() - index;
+  }
+  memcpy(buf, this->str.c_str() + index, n);
+  buf[n] = 0;
+}
+
+long String::toInt(void) const {
+  return atol(this->str.c_str());
+}
+
+float String::toFloat(void) const {
+  return (float)atof(this->str.c_str());
+}
@@ -0,0 +1,49 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+#include <stdio.h>
+#include <Arduino.h>
+#include "Workcell.h"
+
+Workcell::Workcell(void) :
+  currentSensorDCMotor(0x40),
+  currentSensorServoMotor(0x41),
+  valve1("valve1", 43, 44, 42, true, A2, 200 * 2, 6),
+  valve2("valve2", 49, 50, 51, false, A7, 200 * 4, 10),
+  clamp1("clamp1", 22, 23, A4, 31, 30),
+  clamp2("clamp2", 24, 25, A5, 33, 32),
+  clamp3("clamp3", 26, 27, A6, 35, 34),
+  clamp4("clamp4", 48, 47, 40, 41, 200 * 4 / 4.0),
+  capper("capper", 45, 46, 3, A1, currentSensorDCMotor, currentSensorServoMotor, 30, 150, 4, 59) {
+  hostsim::addI2CDevice(&this->currentSensorDCMotor);
+  hostsim::addI2CDevice(&this->currentSensorServoMotor);
+  this->plant = {&this->valve1, &this->valve2, &this->clamp1, &this->clamp2, &this->clamp3, &this->clamp4, &this->capper};
+}
+
+void Workcell::attachPlant(unsigned long randomSeed) {
+  for (size_t i = 0; i < this->plant.size(); i++) {
+    this->plant[i]->seed(randomSeed + i);
+    hostsim::addModel(this->plant[i]);
+  }
+}
+
+bool Workcell::setPlantParameter(const std::string &line) {
+  char device[32];
+  char parameter[32];
+  double value;
+
+  if (sscanf(line.c_str(), "#plant %31s %31s %lf", device, parameter, &value) != 3) {
+    return false;
+  }
+  for (size_t i = 0; i < this->plant.size(); i++) {
+    if (this->plant[i]->name == device) {
+      return this->plant[i]->setParameter(parameter, value);
+    }
+  }
+  return false;
+}
@@ -0,0 +1,40 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// The devices connected to the Arduino, with the pins and parameters of Arduino_Code.ino (shared by the host executables)
+
+#ifndef Workcell_h
+#define Workcell_h
+#include <string>
+#include <vector>
+#include "Ina219Device.h"
+#include "ValveModel.h"
+#include "ClampStageModel.h"
+#include "StepperStageModel.h"
+#include "CapperModel.h"
+
+class Workcell {
+public:
+  Workcell(void);
+  Workcell(const Workcell &) = delete;
+  Workcell &operator=(const Workcell &) = delete;
+  void attachPlant(unsigned long randomSeed);
+  bool setPlantParameter(const std::string &line);  // line of the form '#plant <device> <parameter> <value>'
+  // The capper's current sensors must answer on the bus, otherwise the firmware reports a sensor error at startup
+  Ina219Device currentSensorDCMotor;
+  Ina219Device currentSensorServoMotor;
+  ValveModel valve1;
+  ValveModel valve2;
+  ClampStageModel clamp1;
+  ClampStageModel clamp2;
+  ClampStageModel clamp3;
+  StepperStageModel clamp4;
+  CapperModel capper;
+  std::vector<PlantModel *> plant;
+};
+#endif
@@ -0,0 +1,419 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Benchmark of the firmware on the host build (virtual time, all devices connected to the plant models):
+//  - Latency of every command of displayHelp(), from the line feed of the command arriving at the Arduino until the end of the first reply line
+//    (ACK) and until the last byte of the reply (completion). Commands are sent at a random point of the idle phase of loop().
+//  - Period of loop() while idle, with background tasks (electromagnet waveform, fan cool-down, sensor stream) and under command load.
+//  - Sustained command rate of a client that sends the next command as soon as the reply has arrived.
+// The results are printed as a table and written as JSON with --output (percentiles p50/p90/p99 of all times in ms).
+//
+//   minerva_benchmark [--output results.json] [--repeat <n>] [--duration <s>] [--seed <n>] [--filter <text>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include "HostSim.h"
+#include "Workcell.h"
+
+struct Statistics {
+  size_t count = 0;
+  double mean = 0;
+  double min = 0;
+  double p50 = 0;
+  double p90 = 0;
+  double p99 = 0;
+  double max = 0;
+};
+
+struct CommandResult {
+  double ackMs;
+  double completionMs;
+  std::string reply;
+};
+
+// A command of displayHelp(), with the (untimed) commands that bring the devices into the state it expects and back. Lines starting with
+// '#plant' change a parameter of the plant models, '#wait <ms>' lets the firmware run idle.
+struct CommandBenchmark {
+  const char *command;
+  std::vector<std::string> before;
+  std::vector<std::string> after;
+};
+
+struct CommandReport {
+  std::string command;
+  size_t errors;
+  std::string reply;
+  Statistics ack;
+  Statistics completion;
+};
+
+struct LoopReport {
+  std::string scenario;
+  Statistics period;
+};
+
+struct ThroughputReport {
+  std::string commands;
+  double commandsPerSecond;
+  Statistics completion;
+  Statistics period;
+};
+
+static const CommandBenchmark COMMAND_BENCHMARKS[] = {
+  {"help", {}, {}},
+  {"esr", {}, {"ces"}},
+  {"ces", {}, {}},
+  {"valve1 pos", {}, {}},
+  {"valve1 pos 3", {"valve1 pos 0"}, {}},
+  {"valve1 pos 1", {"valve1 pos 0"}, {}},
+  {"valve1 ini", {}, {}},
+  {"valve1 par", {}, {}},
+  {"valve2 pos 5", {"valve2 pos 0"}, {}},
+  {"magnet1 on", {}, {"magnet1 off"}},
+  {"magnet1 on 128;500", {}, {"magnet1 off"}},
+  {"magnet1 off", {"magnet1 on"}, {}},
+  {"magnet1 rev", {}, {"magnet1 off"}},
+  {"magnet1 rel", {}, {"#wait 1000"}},
+  {"magnet1 stir 5;255;0", {}, {"magnet1 off"}},
+  {"magnet1 status", {"magnet1 stir 5;255;0"}, {"magnet1 off"}},
+  {"clamp1 up", {"clamp1 down"}, {}},
+  {"clamp1 down", {"clamp1 up"}, {}},
+  {"clamp1 up 400", {"clamp1 down"}, {}},
+  {"clamp1 stop", {}, {}},
+  {"clamp1 motor_current", {}, {}},
+  {"clamp1 open", {"clamp1 close"}, {}},
+  {"clamp1 close", {"clamp1 open"}, {"clamp1 open"}},
+  {"clamp1 lower_and_close", {"clamp1 up", "clamp1 open"}, {"clamp1 open_and_raise"}},
+  {"clamp1 open_and_raise", {"clamp1 up", "clamp1 lower_and_close"}, {}},
+  {"clamp4 home", {}, {}},
+  {"clamp4 goto 20", {"clamp4 home"}, {"clamp4 goto 0"}},
+  {"clamp4 pos", {}, {}},
+  {"clamp4 pos 0", {}, {}},
+  {"fan1 on", {}, {"fan1 off"}},
+  {"fan3 on 128", {}, {"fan3 off"}},
+  {"fan1 off", {"fan1 on"}, {}},
+  {"fan1 cool 255;1000", {}, {"fan1 off"}},
+  {"fan1 status", {"fan1 cool 255;1000"}, {"fan1 off"}},
+  {"capper clamp_get_position", {}, {}},
+  {"capper clamp_set_position 20", {}, {"capper clamp_open"}},
+  {"capper pressure", {}, {}},
+  {"capper motor_current", {}, {}},
+  {"capper motor_current all", {}, {}},
+  {"capper servo_current", {}, {}},
+  {"capper servo_current all", {}, {}},
+  {"capper log 100", {}, {}},
+  {"capper stream 15;10000;4;0", {}, {"capper stream_stop"}},
+  {"capper stream_stop", {"capper stream 15;10000;4;0"}, {}},
+  {"capper recorder", {}, {}},
+  {"capper recorder_clear", {}, {}},
+  {"capper open_profile 0", {"#plant capper thread 720", "#plant capper push 500"}, {"#plant capper push 0", "capper clamp_open"}},
+  {"capper close_profile 0", {"#plant capper thread 720", "#plant capper push 500", "capper open_profile 0", "#plant capper push 1000"}, {"#plant capper push 0", "capper clamp_open"}},
+  {"capper profile 0", {}, {}},
+  {"capper profile_clear 7", {}, {}},
+  {"capper tighten", {"#plant capper thread 360", "capper clamp_close"}, {"capper clamp_open"}},
+  {"capper tighten_release", {"#plant capper thread 360", "capper clamp_close"}, {"capper clamp_open"}},
+  {"capper torque_profile", {}, {}},
+  {"capper grip_unscrew", {"#plant capper thread 720"}, {"capper clamp_open"}},
+  {"capper unscrew", {"#plant capper thread 720", "capper clamp_close"}, {"capper clamp_open"}},
+  {"capper unscrew_profile", {}, {}},
+  {"capper turn_cw", {}, {"capper turn_stop"}},
+  {"capper turn_ccw", {}, {"capper turn_stop"}},
+  {"capper turn_stop", {"capper turn_cw"}, {}},
+  {"capper wrist_profile", {}, {}},
+  {"capper clamp_open", {"capper clamp_close"}, {}},
+  {"capper clamp_close", {}, {"capper clamp_open"}},
+  {"capper grip_profile", {}, {}},
+  {"dht22sensor1 measure", {}, {}},
+};
+
+// Short queries that a workcell controller polls, for the sustained command rate
+static const char *THROUGHPUT_COMMANDS[] = {"valve1 pos", "magnet1 status", "fan1 status", "capper pressure", "dht22sensor1 measure"};
+
+static const uint64_t MAX_COMMAND_DELAY_US = 25000;  // commands are sent at a random time within one idle phase of loop() (20 ms) and a bit
+
+static uint64_t lastTransmitUs = 0;
+static uint64_t firstLineEndUs = 0;
+static std::vector<double> *loopPeriods = NULL;
+
+static Statistics summarize(std::vector<double> values) {
+  // Percentiles with the nearest-rank method
+  Statistics res;
+  if (values.empty()) {
+    return res;
+  }
+  std::sort(values.begin(), values.end());
+  res.count = values.size();
+  for (size_t i = 0; i < values.size(); i++) {
+    res.mean += values[i] / values.size();
+  }
+  res.min = values.front();
+  res.max = values.back();
+  res.p50 = values[(size_t)ceil(0.50 * values.size()) - 1];
+  res.p90 = values[(size_t)ceil(0.90 * values.size()) - 1];
+  res.p99 = values[(size_t)ceil(0.99 * values.size()) - 1];
+  return res;
+}
+
+static void runLoop(void) {
+  uint64_t startUs = hostsim::now();
+  hostsim::runLoopOnce();
+  if (loopPeriods != NULL) {
+    loopPeriods->push_back((hostsim::now() - startUs) / 1000.0);
+  }
+}
+
+static void runFor(uint64_t us) {
+  uint64_t end = hostsim::now() + us;
+  while (hostsim::now() < end) {
+    runLoop();
+  }
+}
+
+static CommandResult runCommand(const std::string &line, uint64_t startUs) {
+  // Sends the command (its first byte leaving the host at startUs) and runs loop() until the firmware has read and executed it
+  CommandResult res;
+  uint64_t lineFeedUs = startUs + (line.length() + 1) * hostsim::serialByteTime();
+
+  hostsim::serialTakeOutput();  // discard the output of the background tasks (e.g., the records of the sensor stream)
+  lastTransmitUs = 0;
+  firstLineEndUs = 0;
+  hostsim::serialInjectAt(line + "\n", startUs);
+  while (hostsim::serialPendingInput() > 0) {
+    runLoop();
+  }
+  res.reply = hostsim::serialTakeOutput();
+  res.completionMs = (lastTransmitUs > lineFeedUs) ? (lastTransmitUs - lineFeedUs) / 1000.0 : 0.0;
+  res.ackMs = (firstLineEndUs > lineFeedUs) ? (firstLineEndUs - lineFeedUs) / 1000.0 : res.completionMs;
+  return res;
+}
+
+static bool runSetupLine(Workcell &workcell, const std::string &line) {
+  if (line.compare(0, 5, "#wait") == 0) {
+    runFor((uint64_t)atol(line.c_str() + 5) * 1000);
+    return true;
+  } else if (line.compare(0, 6, "#plant") == 0) {
+    return workcell.setPlantParameter(line);
+  }
+  runCommand(line, hostsim::now());
+  return true;
+}
+
+static bool isErrorReply(const std::string &reply) {
+  return (reply.find("ERROR") != std::string::npos) || (reply.find(">UNK") != std::string::npos) || (reply.find("Unknown Command") != std::string::npos);
+}
+
+static std::string firstLine(const std::string &reply) {
+  std::string res = reply.substr(0, reply.find('\n'));
+  res.erase(std::remove(res.begin(), res.end(), '\r'), res.end());
+  return res;
+}
+
+static LoopReport measureLoop(const std::string &scenario, uint64_t durationUs) {
+  LoopReport res;
+  std::vector<double> periods;
+  res.scenario = scenario;
+  loopPeriods = &periods;
+  runFor(durationUs);
+  loopPeriods = NULL;
+  res.period = summarize(periods);
+  return res;
+}
+
+static ThroughputReport measureThroughput(const std::vector<std::string> &commands, uint64_t durationUs) {
+  // Closed loop: the next command leaves the host when the last byte of the previous reply has arrived
+  ThroughputReport res;
+  std::vector<double> completion;
+  std::vector<double> periods;
+  uint64_t startUs = hostsim::now();
+  uint64_t nextStartUs = startUs;
+
+  for (size_t i = 0; i < commands.size(); i++) {
+    res.commands += (i > 0 ? ", " : "") + commands[i];
+  }
+  loopPeriods = &periods;
+  while (nextStartUs < startUs + durationUs) {
+    CommandResult result = runCommand(commands[completion.size() % commands.size()], nextStartUs);
+    completion.push_back(result.completionMs);
+    nextStartUs = std::max(lastTransmitUs, nextStartUs);
+  }
+  loopPeriods = NULL;
+  res.commandsPerSecond = completion.size() / ((nextStartUs - startUs) / 1e6);
+  res.completion = summarize(completion);
+  res.period = summarize(periods);
+  return res;
+}
+
+static std::string jsonString(const std::string &s) {
+  std::string res = "\"";
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '"' || s[i] == '\\') {
+      res += '\\';
+      res += s[i];
+    } else if ((unsigned char)s[i] < 0x20 || (unsigned char)s[i] >= 0x7F) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)s[i]);
+      res += buf;
+    } else {
+      res += s[i];
+    }
+  }
+  return res + "\"";
+}
+
+static void writeStatistics(FILE *f, const char *name, const Statistics &s) {
+  fprintf(f, "\"%s\": {\"count\": %zu, \"mean\": %.3f, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}", name, s.count, s.mean, s.min, s.p50, s.p90, s.p99, s.max);
+}
+
+static bool writeJson(const char *path, unsigned long baudRate, int repeat, unsigned long randomSeed, const std::vector<CommandReport> &commands, const std::vector<LoopReport> &loops, const std::vector<ThroughputReport> &throughputs) {
+  FILE *f = fopen(path, "w");
+  if (f == NULL) {
+    perror(path);
+    return false;
+  }
+  fprintf(f, "{\n  \"unit\": \"ms\",\n  \"baud\": %lu,\n  \"repeat\": %d,\n  \"seed\": %lu,\n  \"commands\": [\n", baudRate, repeat, randomSeed);
+  for (size_t i = 0; i < commands.size(); i++) {
+    fprintf(f, "    {\"command\": %s, \"errors\": %zu, \"reply\": %s, ", jsonString(commands[i].command).c_str(), commands[i].errors, jsonString(commands[i].reply).c_str());
+    writeStatistics(f, "ack", commands[i].ack);
+    fprintf(f, ", ");
+    writeStatistics(f, "completion", commands[i].completion);
+    fprintf(f, "}%s\n", (i + 1 < commands.size()) ? "," : "");
+  }
+  fprintf(f, "  ],\n  \"loop\": [\n");
+  for (size_t i = 0; i < loops.size(); i++) {
+    fprintf(f, "    {\"scenario\": %s, ", jsonString(loops[i].scenario).c_str());
+    writeStatistics(f, "period", loops[i].period);
+    fprintf(f, "}%s\n", (i + 1 < loops.size()) ? "," : "");
+  }
+  fprintf(f, "  ],\n  \"throughput\": [\n");
+  for (size_t i = 0; i < throughputs.size(); i++) {
+    fprintf(f, "    {\"commands\": %s, \"commands_per_second\": %.3f, ", jsonString(throughputs[i].commands).c_str(), throughputs[i].commandsPerSecond);
+    writeStatistics(f, "completion", throughputs[i].completion);
+    fprintf(f, ", ");
+    writeStatistics(f, "period", throughputs[i].period);
+    fprintf(f, "}%s\n", (i + 1 < throughputs.size()) ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const char *outputPath = NULL;
+  const char *filter = NULL;
+  int repeat = 10;
+  double durationSeconds = 10;
+  unsigned long randomSeed = 1;
+  std::vector<CommandReport> commandReports;
+  std::vector<LoopReport> loopReports;
+  std::vector<ThroughputReport> throughputReports;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      outputPath = argv[++i];
+    } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      repeat = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+      durationSeconds = std::max(0.1, atof(argv[++i]));
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      randomSeed = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else {
+      fprintf(stderr, "Usage: %s [--output <file.json>] [--repeat <n>] [--duration <s>] [--seed <n>] [--filter <text>]\n", argv[0]);
+      return 1;
+    }
+  }
+  uint64_t durationUs = (uint64_t)(durationSeconds * 1e6);
+  std::mt19937 random(randomSeed);
+  std::uniform_int_distribution<uint64_t> commandDelay(0, MAX_COMMAND_DELAY_US);
+
+  Workcell workcell;
+  workcell.attachPlant(randomSeed);
+  hostsim::setSerialOutputCallback([](const uint8_t *data, size_t length, uint64_t nowUs) {
+    lastTransmitUs = nowUs;
+    if (firstLineEndUs == 0 && memchr(data, '\n', length) != NULL) {
+      firstLineEndUs = nowUs;
+    }
+  });
+  hostsim::reset();
+  hostsim::runSetup();
+  runFor(1000000);  // let the background tasks settle (first DHT22 reading, sensor averages)
+
+  // Command latency
+  printf("%-32s %5s %5s %10s %10s %10s %10s %10s\n", "Command", "n", "err", "ACK p50", "ACK p99", "Done p50", "Done p99", "Done max");
+  for (size_t i = 0; i < sizeof(COMMAND_BENCHMARKS) / sizeof(COMMAND_BENCHMARKS[0]); i++) {
+    const CommandBenchmark &benchmark = COMMAND_BENCHMARKS[i];
+    CommandReport report;
+    std::vector<double> ack;
+    std::vector<double> completion;
+    if (filter != NULL && strstr(benchmark.command, filter) == NULL) {
+      continue;
+    }
+    report.command = benchmark.command;
+    report.errors = 0;
+    for (int j = 0; j < repeat; j++) {
+      for (size_t k = 0; k < benchmark.before.size(); k++) {
+        runSetupLine(workcell, benchmark.before[k]);
+      }
+      CommandResult result = runCommand(benchmark.command, hostsim::now() + commandDelay(random));
+      ack.push_back(result.ackMs);
+      completion.push_back(result.completionMs);
+      if (isErrorReply(result.reply)) {
+        report.errors++;
+      }
+      if (j == 0) {
+        report.reply = firstLine(result.reply);
+      }
+      for (size_t k = 0; k < benchmark.after.size(); k++) {
+        runSetupLine(workcell, benchmark.after[k]);
+      }
+    }
+    report.ack = summarize(ack);
+    report.completion = summarize(completion);
+    commandReports.push_back(report);
+    printf("%-32s %5zu %5zu %10.3f %10.3f %10.3f %10.3f %10.3f\n", report.command.c_str(), report.completion.count, report.errors, report.ack.p50, report.ack.p99, report.completion.p50, report.completion.p99, report.completion.max);
+    fflush(stdout);
+  }
+
+  // Period of loop()
+  loopReports.push_back(measureLoop("idle", durationUs));
+  runSetupLine(workcell, "magnet1 stir 5;255;0");
+  runSetupLine(workcell, "fan3 cool 128;0;10");  // never reaches the target temperature
+  loopReports.push_back(measureLoop("magnet stir, fan cool-down", durationUs));
+  runSetupLine(workcell, "magnet1 off");
+  runSetupLine(workcell, "fan3 off");
+  runSetupLine(workcell, "capper stream 15;10000;4;0");
+  loopReports.push_back(measureLoop("capper stream (4 channels, 40 ms)", durationUs));
+  runSetupLine(workcell, "capper stream_stop");
+
+  // Sustained command rate
+  for (size_t i = 0; i < sizeof(THROUGHPUT_COMMANDS) / sizeof(THROUGHPUT_COMMANDS[0]); i++) {
+    throughputReports.push_back(measureThroughput(std::vector<std::string>(1, THROUGHPUT_COMMANDS[i]), durationUs));
+  }
+  throughputReports.push_back(measureThroughput(std::vector<std::string>(THROUGHPUT_COMMANDS, THROUGHPUT_COMMANDS + sizeof(THROUGHPUT_COMMANDS) / sizeof(THROUGHPUT_COMMANDS[0])), durationUs));
+  loopReports.push_back(LoopReport{"closed-loop commands (all queries)", throughputReports.back().period});
+
+  printf("\n%-40s %10s %10s %10s %10s\n", "Loop period", "p50", "p90", "p99", "max");
+  for (size_t i = 0; i < loopReports.size(); i++) {
+    printf("%-40s %10.3f %10.3f %10.3f %10.3f\n", loopReports[i].scenario.c_str(), loopReports[i].period.p50, loopReports[i].period.p90, loopReports[i].period.p99, loopReports[i].period.max);
+  }
+  printf("\n%-40s %10s %10s %10s\n", "Sustained rate", "cmd/s", "Done p50", "Done p99");
+  for (size_t i = 0; i < throughputReports.size(); i++) {
+    printf("%-40s %10.2f %10.3f %10.3f\n", throughputReports[i].commands.substr(0, 40).c_str(), throughputReports[i].commandsPerSecond, throughputReports[i].completion.p50, throughputReports[i].completion.p99);
+  }
+  if (outputPath != NULL && !writeJson(outputPath, Serial.baudRate, repeat, randomSeed, commandReports, loopReports, throughputReports)) {
+    return 1;
+  }
+  return 0;
+}
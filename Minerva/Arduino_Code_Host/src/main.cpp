@@ -0,0 +1,112 @@
+/*
+@author:      "Bastian Ruehle"
+@copyright:   "Copyright 2025, Bastian Ruehle, Federal Institute for Materials Research and Testing (BAM)"
+@version:     "1.0.0"
+@maintainer:  "Bastian Ruehle"
+@email        "bastian.ruehle@bam.de"
+*/
+
+// Runs the firmware on the host: every line read from stdin is sent to the firmware's serial port, and everything it sends back is printed to stdout.
+// Lines starting with '#wait <ms>' let the firmware run idle for the given (virtual) time, '#at <ms>' lets it run idle until the virtual clock
+// reaches the given time (ms since the start).
+// With --plant, the valves, the DC motor hotplate clamps and the capper are connected to physical models of the devices; their parameters can be
+// changed with lines of the form '#plant <device> <parameter> <value>' (e.g. '#plant capper push 400', '#plant valve1 noise 0').
+// With --timing, the end-to-end time of every command (from sending the command until the last byte of the reply) and the virtual time at
+// which the command was sent are printed as '#time <ms> <start ms>'.
+
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <string>
+#include <Arduino.h>
+#include "HostSim.h"
+#include "Workcell.h"
+
+static bool printTimestamps = false;
+static bool atLineStart = true;
+static uint64_t lastTransmitUs = 0;
+
+static void printOutput(void) {
+  std::string out = hostsim::serialTakeOutput();
+  for (size_t i = 0; i < out.size(); i++) {
+    if (atLineStart && printTimestamps) {
+      printf("[%10.3f ms] ", hostsim::now() / 1000.0);
+    }
+    if (out[i] != '\r') {
+      putchar(out[i]);
+    }
+    atLineStart = (out[i] == '\n');
+  }
+  fflush(stdout);
+}
+
+static void runFor(uint64_t us) {
+  uint64_t end = hostsim::now() + us;
+  while (hostsim::now() < end) {
+    hostsim::runLoopOnce();
+    printOutput();
+  }
+}
+
+int main(int argc, char **argv) {
+  bool usePlant = false;
+  bool printTiming = false;
+  unsigned long randomSeed = 1;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--timestamps") == 0) {
+      printTimestamps = true;
+    } else if (strcmp(argv[i], "--plant") == 0) {
+      usePlant = true;
+    } else if (strcmp(argv[i], "--timing") == 0) {
+      printTiming = true;
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      randomSeed = strtoul(argv[++i], NULL, 10);
+    } else {
+      fprintf(stderr, "Usage: %s [--timestamps] [--plant] [--timing] [--seed <n>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  Workcell workcell;
+  if (usePlant) {
+    workcell.attachPlant(randomSeed);
+  }
+  hostsim::setSerialOutputCallback([](const uint8_t * /*data*/, size_t /*length*/, uint64_t nowUs) { lastTransmitUs = nowUs; });
+
+  hostsim::reset();
+  hostsim::runSetup();
+  printOutput();
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (line.compare(0, 5, "#wait") == 0) {
+      runFor((uint64_t)atol(line.c_str() + 5) * 1000);
+      continue;
+    } else if (line.compare(0, 3, "#at") == 0) {
+      uint64_t targetUs = (uint64_t)atoll(line.c_str() + 3) * 1000;
+      if (targetUs > hostsim::now()) {
+        runFor(targetUs - hostsim::now());
+      }
+      continue;
+    } else if (line.compare(0, 6, "#plant") == 0) {
+      if (!usePlant || !workcell.setPlantParameter(line)) {
+        fprintf(stderr, "Invalid plant parameter: %s\n", line.c_str());
+      }
+      continue;
+    }
+    uint64_t commandStartUs = hostsim::now();
+    hostsim::serialInject(line + "\n");
+    while (hostsim::serialPendingInput() > 0) {
+      hostsim::runLoopOnce();
+      printOutput();
+    }
+    hostsim::runLoopOnce();  // finish the iteration that consumed the last byte
+    printOutput();
+    if (printTiming) {
+      printf("#time %.3f %.3f\n", (lastTransmitUs > commandStartUs) ? (lastTransmitUs - commandStartUs) / 1000.0 : 0.0, commandStartUs / 1000.0);
+      fflush(stdout);
+    }
+  }
+  return 0;
+}
@@ -9,14 +9,18 @@
 
 from __future__ import annotations
 
+import functools
+import json
+import operator
 import queue
 import threading
 
+import numpy as np
 import serial
 import logging
 import os.path
 
-from typing import Union, Dict
+from typing import Union, Dict, List, Optional, Tuple
 
 from Minerva.API.HelperClassDefinitions import ControllerHardware, PathNames
 
@@ -62,6 +66,15 @@ class ArduinoController(ControllerHardware):
     """
 
     EMERGENCY_STOP_REQUEST = False
+    STREAM_SYNC = 0xA5
+    STREAM_CHANNELS = [('pressure', 0.25), ('dc_current_ma', 0.1), ('servo_current_ma', 0.1), ('bus_voltage_v', 0.001)]  # name and scale factor of the channels in the order of the bits in the channel mask
+    TRACE_DTYPE = np.dtype([('time', '<u4'), ('type', 'u1'), ('source', 'u1'), ('value', '<i2')])  # see EventTrace::dump
+    TRACE_EVENT_TYPES = {1: 'command_received', 2: 'command_done', 3: 'motion_start', 4: 'motion_stop', 5: 'contact', 6: 'threshold_up', 7: 'threshold_down', 8: 'release', 9: 'limit_switch', 10: 'hall_peak', 11: 'phase', 12: 'error'}
+    TRACE_SOURCE_TYPES = ['general', 'valve', 'magnet', 'clamp', 'fan', 'dht22sensor', 'capper']  # device type in the upper 4 bits of the source
+    TELEMETRY_CHANNELS = ['hall1', 'hall2', 'valve1', 'valve2', 'pressure', 'motor_current', 'servo_current', 'clamp1', 'clamp2', 'clamp3', 'switches', 'temperature1', 'humidity1']  # see the subscribe command of the firmware
+    WATCH_RISING, WATCH_FALLING, WATCH_CROSSING, WATCH_CHANGE = 1, 2, 3, 4  # conditions of the watches, see the watch command of the firmware
+    WATCH_TRACE_TYPES = {4: 'motion', 9: 'limits', 12: 'errors'}  # event types of the event trace that can be watched
+    TRACE_PHASES = {'valve': {1: 'slow_approach', 2: 'fine_adjustment'}, 'clamp': {1: 'fast_approach', 2: 'back_off', 3: 'slow_approach'}, 'capper': {1: 'wait_pressure', 2: 'clamp_close', 3: 'unscrew', 4: 'tighten', 5: 'clamp_open'}}
 
     def __init__(self, com_port: Union[str, int], baud_rate: int = 9600, parity: str = serial.PARITY_NONE, byte_size: int = 8, stop_bit: int = 1):
         """
@@ -115,7 +128,12 @@ class ArduinoController(ControllerHardware):
         self.ser.timeout = None
 
         self.read_queue_dict: Dict[str, queue.Queue] = {}
+        self.stream_queue_dict: Dict[str, queue.Queue] = {}
+        self.telemetry_queue_dict: Dict[str, queue.Queue] = {}
+        self.telemetry: Dict[str, Tuple[int, float]] = {}
+        self.event_queue_dict: Dict[str, queue.Queue] = {}
         self.write_queue: queue.Queue = queue.Queue()
+        self._stream: Optional[dict] = None
 
         self.reading_thread = threading.Thread(target=self._read_from_comport, daemon=True)
         self.writing_thread = threading.Thread(target=self._write_to_comport, daemon=True)
@@ -159,23 +177,662 @@ class ArduinoController(ControllerHardware):
             self.read_queue_dict[prefix] = queue.Queue()
         return self.read_queue_dict[prefix]
 
+    def get_stream_queue(self, prefix: str) -> queue.Queue:
+        """
+        Creates a queue.Queue object for the specified prefix and returns it. Any binary sensor stream sent by the Arduino controller for this prefix will be decoded and stored in the queue once the stream has ended.
+
+        Parameters
+        ----------
+        prefix
+            The prefix that identifies the hardware that sends the stream (e.g., CAPPER)
+
+        Returns
+        -------
+        queue.Queue
+            A queue holding dictionaries with the decoded streams as numpy arrays (see _decode_stream).
+        """
+
+        if prefix not in self.stream_queue_dict.keys():
+            self.stream_queue_dict[prefix] = queue.Queue()
+        return self.stream_queue_dict[prefix]
+
+    def get_telemetry_queue(self, channel: str) -> queue.Queue:
+        """
+        Creates a queue.Queue object for the specified telemetry channel and returns it. Any values of this channel pushed by the Arduino controller will be stored in the queue.
+
+        Parameters
+        ----------
+        channel
+            The telemetry channel (see TELEMETRY_CHANNELS)
+
+        Returns
+        -------
+        queue.Queue
+            A queue holding tuples with the time of the controller in ms and the value of the channel.
+        """
+
+        channel = channel.lower()
+        if channel not in self.telemetry_queue_dict.keys():
+            self.telemetry_queue_dict[channel] = queue.Queue()
+        return self.telemetry_queue_dict[channel]
+
+    def get_event_queue(self, channel: str) -> queue.Queue:
+        """
+        Creates a queue.Queue object for the specified watch and returns it. Any events of this watch sent by the Arduino controller will be stored in the queue.
+
+        Parameters
+        ----------
+        channel
+            The telemetry channel (see TELEMETRY_CHANNELS) or the watched event type of the event trace (see WATCH_TRACE_TYPES)
+
+        Returns
+        -------
+        queue.Queue
+            A queue holding dictionaries with the events (see _handle_event_message).
+        """
+
+        channel = channel.lower()
+        if channel not in self.event_queue_dict.keys():
+            self.event_queue_dict[channel] = queue.Queue()
+        return self.event_queue_dict[channel]
+
     def _read_from_comport(self) -> None:
         """
         Method for continuously reading from the serial port and putting the messages in the corresponding queue. Run in its own daemon thread.
+        While a binary sensor stream is active, records (starting with the sync byte) are collected and text lines are handled as usual. Binary blocks announced with DUMP <bytes> are put in the queue as bytes.
         """
 
         while not ArduinoController.EMERGENCY_STOP_REQUEST:
-            r = self.ser.read_until(self.eol).decode().rstrip(self.eol.decode())
+            if self._stream is not None:
+                b = self._read_stream_bytes(1)
+                if b[0] == ArduinoController.STREAM_SYNC:
+                    record = b + self._read_stream_bytes(self._stream['record_size'] - 1)
+                    if functools.reduce(operator.xor, record[1:], 0) == 0:
+                        self._stream['data'] += record
+                    else:  # Corrupted or misaligned record, search for the next sync byte or text line in the remaining bytes
+                        self._stream['pending'] = record[1:] + self._stream['pending']
+                    continue
+                prefix = b
+                while (prefix[-1:].isupper() or prefix[-1:].isdigit()) and len(prefix) < 20:
+                    prefix += self._read_stream_bytes(1)
+                if not (prefix[:1].isupper() and prefix.endswith(b'>')):  # Text lines start with an upper case prefix, anything else is the rest of a corrupted record
+                    self._stream['pending'] = prefix[1:] + self._stream['pending']
+                    continue
+                r = (prefix + self._read_stream_line()).decode(errors='replace').rstrip(self.eol.decode())
+            else:
+                r = self.ser.read_until(self.eol).decode().rstrip(self.eol.decode())
             if '>' in r:
                 target = r[:r.find('>')]
                 msg = r.replace(f'{target}>', '')
-                if '\n' in msg:
+                if msg.startswith('STREAM '):
+                    self._handle_stream_message(target, msg)
+                elif target == 'TELEMETRY' and msg.startswith('DATA '):
+                    self._handle_telemetry_message(msg)
+                elif target == 'EVENT' and (msg.startswith('WATCH ') or msg.startswith('TRACE ')):
+                    self._handle_event_message(msg)
+                elif msg.startswith('DUMP '):  # Binary block of the given length, put in the queue as bytes
+                    n = int(msg.split(' ')[-1])
+                    self.read_queue_dict[target].put(self._read_stream_bytes(n) if self._stream is not None else self.ser.read(n))
+                elif '\n' in msg:
                     self.read_queue_dict[target].put(msg.split('\n'))
                 else:
                     self.read_queue_dict[target].put(msg)
             else:
                 logger.info(r, extra=self._logger_dict)
 
+    def _read_stream_bytes(self, n: int) -> bytes:
+        """
+        Reads n bytes while a binary sensor stream is active, bytes that were put back while resynchronizing are returned first.
+
+        Parameters
+        ----------
+        n: int
+            The number of bytes to read.
+
+        Returns
+        -------
+        bytes
+            The bytes that were read.
+        """
+
+        data = self._stream['pending'][:n]
+        self._stream['pending'] = self._stream['pending'][n:]
+        if len(data) < n:
+            data += self.ser.read(n - len(data))
+        return data
+
+    def _read_stream_line(self) -> bytes:
+        """
+        Reads the rest of a text line while a binary sensor stream is active, bytes that were put back while resynchronizing are returned first.
+
+        Returns
+        -------
+        bytes
+            The bytes up to and including the end of line.
+        """
+
+        pending = self._stream['pending']
+        if self.eol in pending:
+            i = pending.index(self.eol) + len(self.eol)
+            self._stream['pending'] = pending[i:]
+            return pending[:i]
+        self._stream['pending'] = b''
+        return pending + self.ser.read_until(self.eol)
+
+    def _handle_stream_message(self, target: str, msg: str) -> None:
+        """
+        Starts collecting the records of a binary sensor stream (STREAM <channels>;<period>;<decimation>) or decodes the collected records and puts them in the stream queue of the target (STREAM END <records>;<dropped>;<missed>).
+
+        Parameters
+        ----------
+        target: str
+            The prefix of the hardware that sends the stream.
+        msg: str
+            The message without the prefix.
+        """
+
+        params = [int(i) for i in msg.split(' ')[-1].split(';')]
+        if not msg.startswith('STREAM END'):
+            channels = [i for i in range(0, len(ArduinoController.STREAM_CHANNELS)) if params[0] & (1 << i)]
+            self._stream = {'target': target, 'channels': channels, 'period_us': params[1], 'decimation': params[2], 'record_size': 7 + 2 * len(channels), 'data': bytearray(), 'pending': b''}
+        elif self._stream is not None:
+            stream = self._decode_stream(self._stream)
+            stream['dropped'] = max(stream['dropped'], params[1])  # the sequence numbers also account for corrupted records, but wrap after 256 records
+            stream['missed'] = params[2]
+            self._stream = None
+            self.get_stream_queue(target).put(stream)
+
+    @staticmethod
+    def _decode_stream(stream: dict) -> dict:
+        """
+        Converts the collected binary records of a sensor stream to numpy arrays.
+
+        Parameters
+        ----------
+        stream: dict
+            The stream information and the raw records as collected by _read_from_comport.
+
+        Returns
+        -------
+        dict
+            time_us (timestamps in microseconds, unwrapped) and one array per streamed channel (pressure, dc_current_ma, servo_current_ma, bus_voltage_v), as well as period_us, decimation, the number of dropped records (incl. corrupted ones) and the number of missed samples.
+        """
+
+        dtype = np.dtype([('sync', 'u1'), ('sequence', 'u1'), ('time', '<u4')] + [(ArduinoController.STREAM_CHANNELS[i][0], '<i2') for i in stream['channels']] + [('checksum', 'u1')])
+        n = len(stream['data']) // dtype.itemsize
+        raw = np.frombuffer(bytes(stream['data'][:n * dtype.itemsize]), dtype=np.uint8).reshape(n, dtype.itemsize)
+        valid = (raw[:, 0] == ArduinoController.STREAM_SYNC) & (np.bitwise_xor.reduce(raw[:, 1:], axis=1) == 0)
+        records = raw[valid].copy().view(dtype).reshape(-1)
+
+        time_us = records['time'].astype(np.int64)
+        if len(time_us) > 1:
+            time_us[1:] = time_us[0] + np.cumsum(np.diff(time_us) % 2**32)  # micros() overflows after about 70 minutes
+
+        result = {'time_us': time_us}
+        for i in stream['channels']:
+            name, scale = ArduinoController.STREAM_CHANNELS[i]
+            result[name] = records[name] * scale
+        result['period_us'] = stream['period_us']
+        result['decimation'] = stream['decimation']
+        result['dropped'] = int(np.sum((np.diff(records['sequence'].astype(np.int16)) - 1) % 256))
+        return result
+
+    def _handle_telemetry_message(self, msg: str) -> None:
+        """
+        Stores the values pushed by the Arduino controller (DATA <time in ms>;<channel>=<value>;...) as the latest values in self.telemetry and puts them in the queues of the channels.
+
+        Parameters
+        ----------
+        msg: str
+            The message without the TELEMETRY> prefix
+        """
+        values = msg[len('DATA '):].split(';')
+        time_ms = int(values[0])
+        for v in values[1:]:
+            channel, _, value = v.partition('=')
+            self.telemetry[channel] = (time_ms, float(value))
+            if channel in self.telemetry_queue_dict.keys():
+                self.telemetry_queue_dict[channel].put(self.telemetry[channel])
+
+    def subscribe_telemetry(self, channel: str, period_ms: int, timeout: float = 10) -> Optional[queue.Queue]:
+        """
+        Subscribes to a telemetry channel: the Arduino controller pushes the value of the channel every period_ms until it is unsubscribed, so it does not need to be polled. Values are only pushed while the controller does not execute a command.
+
+        Parameters
+        ----------
+        channel : str
+            The telemetry channel (see TELEMETRY_CHANNELS)
+        period_ms : int
+            The period in ms (the controller sends at most every 20 ms). 0 unsubscribes the channel.
+        timeout : float, default=10
+            The timeout when waiting for a response in seconds. Default is 10 seconds.
+
+        Returns
+        -------
+        Optional[queue.Queue]
+            The queue that receives tuples with the time of the controller in ms and the value of the channel (see get_telemetry_queue), or None if the subscription failed.
+        """
+        read_queue = self.get_read_queue('TELEMETRY')
+        telemetry_queue = self.get_telemetry_queue(channel)
+        self.write(f'subscribe {channel};{int(period_ms)}\n')
+        try:
+            r = read_queue.get(timeout=timeout)
+        except queue.Empty:
+            logger.error('No response to telemetry subscription request.', extra=self._logger_dict)
+            return None
+        if r != 'OK':
+            logger.error(r, extra=self._logger_dict)
+            return None
+        return telemetry_queue
+
+    def unsubscribe_telemetry(self, channel: Optional[str] = None, timeout: float = 10) -> bool:
+        """
+        Stops the periodic push of a telemetry channel.
+
+        Parameters
+        ----------
+        channel : Optional[str], default=None
+            The telemetry channel (see TELEMETRY_CHANNELS). If None, all channels are unsubscribed. Default is None.
+        timeout : float, default=10
+            The timeout when waiting for a response in seconds. Default is 10 seconds.
+
+        Returns
+        -------
+        bool
+            True if successful, False otherwise
+        """
+        read_queue = self.get_read_queue('TELEMETRY')
+        self.write(f'unsubscribe {channel}\n' if channel is not None else 'unsubscribe\n')
+        try:
+            r = read_queue.get(timeout=timeout)
+        except queue.Empty:
+            logger.error('No response to telemetry unsubscription request.', extra=self._logger_dict)
+            return False
+        if r != 'OK':
+            logger.error(r, extra=self._logger_dict)
+            return False
+        return True
+
+    def get_telemetry(self, channel: str) -> Optional[Tuple[int, float]]:
+        """
+        Returns the latest value of a subscribed telemetry channel without communicating with the Arduino controller.
+
+        Parameters
+        ----------
+        channel : str
+            The telemetry channel (see TELEMETRY_CHANNELS)
+
+        Returns
+        -------
+        Optional[Tuple[int, float]]
+            The time of the controller in ms and the value of the channel, or None if no value was received yet.
+        """
+        return self.telemetry.get(channel.lower(), None)
+
+    def _handle_event_message(self, msg: str) -> None:
+        """
+        Decodes an event sent by the Arduino controller and puts it in the event queue of the watch. Events of the telemetry channels (WATCH <time in ms>;<channel>;<condition>;<value>) are
+        stored as dictionaries with time_ms, channel, condition ('rising', 'falling' or 'change') and value, events of the event trace (TRACE <time in ms>;<type>;<source>;<value>) with time_ms, channel, type, device and value.
+
+        Parameters
+        ----------
+        msg: str
+            The message without the EVENT> prefix
+        """
+        kind, _, values = msg.partition(' ')
+        values = values.split(';')
+        if kind == 'WATCH':
+            event = {'time_ms': int(values[0]), 'channel': values[1], 'condition': values[2], 'value': float(values[3])}
+        else:
+            event_type = int(values[1])
+            event = {'time_ms': int(values[0]), 'channel': ArduinoController.WATCH_TRACE_TYPES.get(event_type, str(event_type)), 'type': ArduinoController.TRACE_EVENT_TYPES.get(event_type, str(event_type)), 'device': ArduinoController._get_trace_device(int(values[2])), 'value': int(values[3])}
+        logger.debug(f'Event: {event}', extra=self._logger_dict)
+        self.get_event_queue(event['channel']).put(event)
+
+    def watch(self, channel: str, mode: int = WATCH_CHANGE, threshold: float = 0.0, hysteresis: float = 0.0, timeout: float = 10) -> Optional[queue.Queue]:
+        """
+        Arms a watch on the Arduino controller, which then sends an event whenever the condition is met (until it is disarmed with unwatch), so the host can wait for it instead of polling.
+        The conditions of the telemetry channels are only checked while the controller does not execute a command. Watched events of the event trace are sent right after the reply of the command in which they happened.
+
+        Parameters
+        ----------
+        channel : str
+            The telemetry channel (see TELEMETRY_CHANNELS) or one of the event types of the event trace 'motion' (a device stopped moving), 'limits' (a limit switch was hit) and 'errors' (see WATCH_TRACE_TYPES)
+        mode : int, default=WATCH_CHANGE
+            The condition (ignored for the event types): WATCH_RISING (value rises above threshold + hysteresis), WATCH_FALLING (value falls below threshold - hysteresis), WATCH_CROSSING (both) or WATCH_CHANGE (value changes by at least the hysteresis, e.g. a limit switch toggles). Default is WATCH_CHANGE.
+        threshold : float, default=0.0
+            The threshold of the channel. Default is 0.
+        hysteresis : float, default=0.0
+            The hysteresis of the threshold (or the minimum change for WATCH_CHANGE). Default is 0.
+        timeout : float, default=10
+            The timeout when waiting for a response in seconds. Default is 10 seconds.
+
+        Returns
+        -------
+        Optional[queue.Queue]
+            The queue that receives the events of the watch (see get_event_queue), or None if the watch could not be armed.
+        """
+        read_queue = self.get_read_queue('EVENT')
+        event_queue = self.get_event_queue(channel)
+        self.write(f'watch {channel};{int(mode)};{threshold};{hysteresis}\n')
+        try:
+            r = read_queue.get(timeout=timeout)
+        except queue.Empty:
+            logger.error('No response to watch request.', extra=self._logger_dict)
+            return None
+        if r != 'OK':
+            logger.error(r, extra=self._logger_dict)
+            return None
+        return event_queue
+
+    def unwatch(self, channel: Optional[str] = None, timeout: float = 10) -> bool:
+        """
+        Disarms a watch on the Arduino controller.
+
+        Parameters
+        ----------
+        channel : Optional[str], default=None
+            The telemetry channel or event type of the watch. If None, all watches are disarmed. Default is None.
+        timeout : float, default=10
+            The timeout when waiting for a response in seconds. Default is 10 seconds.
+
+        Returns
+        -------
+        bool
+            True if successful, False otherwise
+        """
+        read_queue = self.get_read_queue('EVENT')
+        self.write(f'unwatch {channel}\n' if channel is not None else 'unwatch\n')
+        try:
+            r = read_queue.get(timeout=timeout)
+        except queue.Empty:
+            logger.error('No response to unwatch request.', extra=self._logger_dict)
+            return False
+        if r != 'OK':
+            logger.error(r, extra=self._logger_dict)
+            return False
+        return True
+
+    def wait_for_event(self, channel: str, timeout: Optional[float] = None) -> Optional[dict]:
+        """
+        Waits for the next event of an armed watch.
+
+        Parameters
+        ----------
+        channel : str
+            The telemetry channel or event type of the watch
+        timeout : Optional[float], default=None
+            The maximum time to wait in seconds, None waits forever. Default is None.
+
+        Returns
+        -------
+        Optional[dict]
+            The event (see _handle_event_message), or None if no event was received within the timeout.
+        """
+        try:
+            return self.get_event_queue(channel).get(timeout=timeout)
+        except queue.Empty:
+            return None
+
+    def get_runtime_statistics(self, timeout: float = 10) -> Optional[dict]:
+        """
+        Queries the runtime statistics of the Arduino controller (see the stats command of the firmware).
+
+        Parameters
+        ----------
+        timeout : float, default=10
+            The timeout when waiting for a response in seconds. Default is 10 seconds.
+
+        Returns
+        -------
+        Optional[dict]
+            A dictionary with the entries 'time' (uptime, executing, idle, sampling in ms), 'loop' (idle iterations, min, mean, max period and mean jitter in us), 'serial_rx_full', 'memory' (heap, stack, peak stack, min. free in bytes) and 'commands' (per command type: count, min, mean, max in us and the histogram), or None if the controller did not answer.
+        """
+        read_queue = self.get_read_queue('STATS')
+        self.write('stats\n')
+        try:
+            r = read_queue.get(timeout=timeout)
+        except queue.Empty:
+            logger.error('No response to runtime statistics request.', extra=self._logger_dict)
+            return None
+
+        if not isinstance(r, list) or r[-1] != 'OK':
+            logger.error(r, extra=self._logger_dict)
+            return None
+
+        result: dict = {'commands': {}}
+        for line in r[:-1]:
+            key, _, values = line.partition(' ')
+            if key == 'TIME':
+                result['time'] = dict(zip(('uptime', 'executing', 'idle', 'sampling'), (int(v) for v in values.split(';'))))
+            elif key == 'LOOP':
+                result['loop'] = dict(zip(('iterations', 'min', 'mean', 'max', 'jitter'), (int(v) for v in values.split(';'))))
+            elif key == 'SERIAL':
+                result['serial_rx_full'] = int(values)
+            elif key == 'MEMORY':
+                result['memory'] = dict(zip(('heap', 'stack', 'peak_stack', 'min_free'), (int(v) for v in values.split(';'))))
+            elif key == 'CMD':
+                name, _, timing = values.partition(' ')
+                timing = timing.split(';')
+                result['commands'][name] = dict(zip(('count', 'min', 'mean', 'max'), (int(v) for v in timing[:4])))
+                result['commands'][name]['histogram'] = [int(v) for v in timing[4].split(',')]
+        return result
+
+    def reset_runtime_statistics(self, timeout: float = 10) -> bool:
+        """
+        Clears the runtime statistics of the Arduino controller.
+
+        Parameters
+        ----------
+        timeout : float, default=10
+            The timeout when waiting for a response in seconds. Default is 10 seconds.
+
+        Returns
+        -------
+        bool
+            True if successful, False otherwise
+        """
+        read_queue = self.get_read_queue('STATS')
+        self.write('stats reset\n')
+        try:
+            r = read_queue.get(timeout=timeout)
+        except queue.Empty:
+            logger.error('No response to runtime statistics reset request.', extra=self._logger_dict)
+            return False
+        return r == 'OK'
+
+    def run_self_benchmark(self, timeout: float = 10) -> Optional[dict]:
+        """
+        Measures the timing of the Arduino controller with its actual wiring (see the bench command of the firmware). Takes about 1 s, during which the controller does not process other commands.
+
+        Parameters
+        ----------
+        timeout : float, default=10
+            The timeout when waiting for a response in seconds. Default is 10 seconds.
+
+        Returns
+        -------
+        Optional[dict]
+            A dictionary with the measured durations of delayMicroseconds ('delay', measured duration in us for each requested duration), analogRead ('analog', per pin: time_us and the deviation of the first reading after switching channels without and with 100 us settle time),
+            digitalWrite ('digital_write_us'), the maximum step rate ('step_rate'), the INA219 register reads ('i2c') and conversion intervals ('ina219'), Servo.write ('servo_write_us'), the last DHT22 read ('dht22_read_us') and the serial throughput ('serial'), or None if the controller did not answer.
+        """
+        read_queue = self.get_read_queue('BENCH')
+        self.write('bench\n')
+        try:
+            r = read_queue.get(timeout=timeout)
+        except queue.Empty:
+            logger.error('No response to self-benchmark request.', extra=self._logger_dict)
+            return None
+
+        if not isinstance(r, list) or r[-1] != 'OK':
+            logger.error(r, extra=self._logger_dict)
+            return None
+
+        result: dict = {'delay': {}, 'analog': {}, 'ina219': {}}
+        for line in r[:-1]:
+            key, _, values = line.partition(' ')
+            if key == 'DELAY':
+                requested, measured = values.split(';')
+                result['delay'][int(requested)] = float(measured)
+            elif key == 'ANALOG':
+                pin, _, values = values.partition(' ')
+                result['analog'][int(pin)] = dict(zip(('time_us', 'deviation', 'deviation_settled'), (float(v) for v in values.split(';'))))
+            elif key == 'DIGITALWRITE':
+                result['digital_write_us'] = float(values)
+            elif key == 'STEP':
+                result['step_rate'] = float(values)
+            elif key == 'I2C':
+                result['i2c'] = dict(zip(('transfers', 'min_us', 'mean_us', 'max_us', 'bus_errors'), (int(v) for v in values.split(';'))))
+            elif key == 'INA219':
+                sensor, _, values = values.partition(' ')
+                result['ina219'][int(sensor)] = dict(zip(('readings', 'interval_us'), (int(v) for v in values.split(';'))))
+            elif key == 'SERVO':
+                result['servo_write_us'] = float(values)
+            elif key == 'DHT22':
+                result['dht22_read_us'] = int(values)
+            elif key == 'SERIAL':
+                result['serial'] = dict(zip(('bytes', 'time_us', 'bytes_per_second', 'nominal_bytes_per_second'), (float(v) for v in values.split(';'))))
+        logger.info(f'Self-benchmark: {result}', extra=self._logger_dict)
+        return result
+
+    def get_event_trace(self, timeout: float = 10) -> Optional[dict]:
+        """
+        Reads the event trace of the Arduino controller, which holds the last timestamped state transitions of the devices (commands, motions, threshold crossings, limit switches, Hall sensor peaks, phases and errors).
+
+        Parameters
+        ----------
+        timeout : float, default=10
+            The timeout when waiting for a response in seconds. Default is 10 seconds.
+
+        Returns
+        -------
+        Optional[dict]
+            A dictionary with the entries 'time_us' (time of the controller when the trace was read), 'overwritten' (number of events that were lost since the trace was cleared) and 'events' (list of dictionaries with time_us, type, device and value, oldest first), or None if the controller did not answer.
+        """
+        read_queue = self.get_read_queue('TRACE')
+        self.write('trace\n')
+        try:
+            data = read_queue.get(timeout=timeout)
+            r = read_queue.get(timeout=timeout)
+        except queue.Empty:
+            logger.error('No response to event trace request.', extra=self._logger_dict)
+            return None
+        if r != 'OK' or not isinstance(data, bytes):
+            logger.error(r, extra=self._logger_dict)
+            return None
+
+        now, _, overwritten = np.frombuffer(data[:8], dtype=np.dtype([('time', '<u4'), ('count', '<u2'), ('overwritten', '<u2')]))[0]
+        records = np.frombuffer(data[8:], dtype=ArduinoController.TRACE_DTYPE)
+        time_us = np.append(records['time'], now).astype(np.int64)
+        if len(time_us) > 1:
+            time_us[1:] = time_us[0] + np.cumsum(np.diff(time_us) % 2**32)  # micros() overflows after about 70 minutes
+
+        events = []
+        for i, e in enumerate(records):
+            events.append({'time_us': int(time_us[i]), 'type': ArduinoController.TRACE_EVENT_TYPES.get(int(e['type']), str(e['type'])), 'device': ArduinoController._get_trace_device(int(e['source'])), 'value': int(e['value'])})
+        return {'time_us': int(time_us[-1]), 'overwritten': int(overwritten), 'events': events}
+
+    @staticmethod
+    def _get_trace_device(source: int) -> str:
+        """
+        Name of the device of an event of the event trace (device type in the upper 4 bits of the source, device number in the lower 4 bits), e.g. 'clamp1'.
+
+        Parameters
+        ----------
+        source: int
+            The source byte of the event
+
+        Returns
+        -------
+        str
+            The name of the device
+        """
+        device = ArduinoController.TRACE_SOURCE_TYPES[source >> 4] if (source >> 4) < len(ArduinoController.TRACE_SOURCE_TYPES) else str(source >> 4)
+        if source & 0x0F:
+            device += str(source & 0x0F)
+        return device
+
+    def clear_event_trace(self, timeout: float = 10) -> bool:
+        """
+        Clears the event trace of the Arduino controller.
+
+        Parameters
+        ----------
+        timeout : float, default=10
+            The timeout when waiting for a response in seconds. Default is 10 seconds.
+
+        Returns
+        -------
+        bool
+            True if successful, False otherwise
+        """
+        read_queue = self.get_read_queue('TRACE')
+        self.write('trace clear\n')
+        try:
+            r = read_queue.get(timeout=timeout)
+        except queue.Empty:
+            logger.error('No response to event trace clear request.', extra=self._logger_dict)
+            return False
+        return r == 'OK'
+
+    @staticmethod
+    def convert_event_trace(trace: dict, file_path: Optional[str] = None) -> List[dict]:
+        """
+        Converts an event trace (see get_event_trace) to the Chrome trace event format, which can be opened in chrome://tracing or ui.perfetto.dev.
+        Every device gets its own track with the commands, motions and phases as durations and all other events as instant events.
+
+        Parameters
+        ----------
+        trace : dict
+            The event trace as returned by get_event_trace.
+        file_path : Optional[str], default=None
+            If provided, the converted trace is saved as a json file at this path.
+
+        Returns
+        -------
+        List[dict]
+            The converted trace events.
+        """
+        spans = {'command_received': ('command', 'command_done'), 'motion_start': ('motion', 'motion_stop')}
+        open_spans: Dict[tuple, dict] = {}
+        result: List[dict] = []
+        t0 = trace['events'][0]['time_us'] if len(trace['events']) > 0 else 0
+
+        def close_span(key: tuple, time_us: int, value: Optional[int] = None) -> None:
+            span = open_spans.pop(key, None)
+            if span is not None:
+                span['dur'] = time_us - t0 - span['ts']
+                if value is not None:
+                    span['args']['end_value'] = value
+                result.append(span)
+
+        for e in trace['events']:
+            ts = e['time_us'] - t0
+            if e['type'] in spans:
+                name, _ = spans[e['type']]
+                close_span((e['device'], name), e['time_us'])
+                open_spans[(e['device'], name)] = {'name': name, 'ph': 'X', 'ts': ts, 'pid': 0, 'tid': e['device'], 'args': {'value': e['value']}}
+            elif e['type'] in ('command_done', 'motion_stop'):
+                close_span((e['device'], 'command' if e['type'] == 'command_done' else 'motion'), e['time_us'], e['value'])
+                if e['type'] == 'command_done':  # a motion or phase that was aborted with an error ends with the command
+                    close_span((e['device'], 'motion'), e['time_us'])
+                    close_span((e['device'], 'phase'), e['time_us'])
+            elif e['type'] == 'phase':
+                close_span((e['device'], 'phase'), e['time_us'])
+                if e['value'] != 0:
+                    phases = ArduinoController.TRACE_PHASES.get(e['device'].rstrip('0123456789'), {})
+                    open_spans[(e['device'], 'phase')] = {'name': phases.get(e['value'], f'phase {e["value"]}'), 'ph': 'X', 'ts': ts, 'pid': 0, 'tid': e['device'], 'args': {'value': e['value']}}
+            else:
+                result.append({'name': e['type'], 'ph': 'i', 's': 't', 'ts': ts, 'pid': 0, 'tid': e['device'], 'args': {'value': e['value']}})
+        for key in list(open_spans.keys()):
+            close_span(key, trace['time_us'])
+
+        result.append({'name': 'process_name', 'ph': 'M', 'pid': 0, 'args': {'name': 'Arduino Controller'}})
+        if file_path is not None:
+            with open(file_path, 'w') as f:
+                json.dump({'traceEvents': result, 'displayTimeUnit': 'ms', 'otherData': {'overwritten_events': trace['overwritten']}}, f)
+        return result
+
     def _write_to_comport(self) -> None:
         """
         Method for continuously checking the write queue and writing the messages to the serial port. Run in its own daemon thread.
@@ -9,12 +9,15 @@
 
 from __future__ import annotations
 
+import queue
 import time
 
+import numpy as np
+
 import logging
 import os.path
 
-from typing import Union, Iterable, TYPE_CHECKING, List, Tuple, cast
+from typing import Union, Iterable, TYPE_CHECKING, List, Tuple, Dict, Optional, cast
 
 from Minerva.API import MinervaAPI
 from Minerva.API.HelperClassDefinitions import Hardware, PathsToHardwareCollection, TaskScheduler, TaskGroupSynchronizationObject, HardwareTypeDefinitions, PathNames
@@ -57,6 +60,10 @@ class CapperDecapper(Hardware):
     """
     EMERGENCY_STOP_REQUEST = False
     BRACKET_WIDTH = 23  
+    RECORDER_CYCLE_TYPES = {1: 'open', 2: 'close'}
+    RECORDER_PHASES = {1: 'wait_pressure', 2: 'clamp_close', 3: 'unscrew', 4: 'tighten', 5: 'clamp_open'}
+    CONTAINER_PROFILE_FIELDS = ('clamp_position_mm', 'grip_current_ma', 'open_pressure_threshold', 'close_pressure_threshold', 'seat_current_ma', 'fast_step_time_ms', 'fine_step_time_ms', 'open_timeout_ms', 'close_timeout_ms', 'torque_time_ms')  # see capper profile
+    RECORDER_DTYPE = np.dtype([('number', '<u2'), ('type', 'u1'), ('start_time_ms', '<u4'), ('pressure_threshold', '<i2'), ('current_threshold_ma', '<i2'), ('timeout_ms', '<i2'), ('parameter', '<i2'), ('outcome', 'u1'), ('reason', 'u1'), ('value', '<i2'), ('duration_ms', '<u2'), ('sample_interval_ms', '<u2'), ('phase_count', 'u1'), ('phases', [('phase', 'u1'), ('time_ms', '<u2')], (8,)), ('sample_count', 'u1'), ('samples', '<i2', (48, 2))])  # see FlightRecorder::dump
 
     def __init__(self, arduino_controller: ArduinoController.ArduinoController, timeout: float = 600):
         """
@@ -73,8 +80,10 @@ class CapperDecapper(Hardware):
         self.timeout = timeout
         self.arduino_controller = arduino_controller
         self.read_queue = self.arduino_controller.get_read_queue(f'CAPPER')
+        self.stream_queue = self.arduino_controller.get_stream_queue(f'CAPPER')
         self.approach_speed = 10
         self.clamp_height = 25
+        self.clamp_diameter = 0.0
         self._logger_dict = {'instance_name': str(self)}
 
     def read_pressure_sensor(self, averages: int = 64, log_results: bool = True) -> int:
@@ -137,6 +146,130 @@ class CapperDecapper(Hardware):
                 logger.error(r[-1], extra=self._logger_dict)
                 return None
 
+    def start_sensor_stream(self, channels: Iterable[str] = ('pressure', 'dc_current_ma', 'servo_current_ma'), period_us: int = 5000, decimation: int = 4, duration: float = 5.0) -> bool:
+        """
+        Starts streaming the capper sensors with a fixed sample period in binary records. The stream keeps running while other capper commands are executed, so e.g. a complete open_container or close_container call can be recorded. Use get_sensor_stream to retrieve the data.
+
+        Parameters
+        ----------
+        channels: Iterable[str] = ('pressure', 'dc_current_ma', 'servo_current_ma')
+            The channels to stream (any of 'pressure', 'dc_current_ma', 'servo_current_ma', 'bus_voltage_v'). Default is pressure, dc motor current and servo current.
+        period_us: int = 5000
+            The sample period in microseconds (500 - 32000). Default is 5000.
+        decimation: int = 4
+            The number of samples that are averaged for each record. At 9600 baud, 960 / (7 + 2 * number of channels) records per second can be transmitted (about 70 with three channels), the controller rejects streams with a higher record rate 1e6 / (period_us * decimation). Default is 4 (50 records per second).
+        duration: float = 5.0
+            The duration of the stream in seconds (0 streams until stop_sensor_stream is called). Default is 5.
+
+        Returns
+        -------
+            True if successful, false otherwise
+        """
+        if CapperDecapper.EMERGENCY_STOP_REQUEST:
+            return False
+
+        names = [i[0] for i in ArduinoController.ArduinoController.STREAM_CHANNELS]
+        mask = sum([1 << names.index(c) for c in channels])
+        self.arduino_controller.write(f'capper stream {mask};{period_us};{decimation};{int(duration * 1000)}\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if r == 'OK':
+            logger.info(f'Started sensor stream', extra=self._logger_dict)
+            return True
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return False
+
+    def stop_sensor_stream(self) -> bool:
+        if CapperDecapper.EMERGENCY_STOP_REQUEST:
+            return False
+
+        self.arduino_controller.write('capper stream_stop\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if r == 'OK':
+            logger.info(f'Stopped sensor stream', extra=self._logger_dict)
+            return True
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return False
+
+    def get_sensor_stream(self, timeout: Optional[float] = None) -> Optional[Dict]:
+        """
+        Waits until the sensor stream has ended and returns the recorded data.
+
+        Parameters
+        ----------
+        timeout: Optional[float] = None
+            The maximum time in seconds to wait for the end of the stream. Default is None, which uses the timeout of the class.
+
+        Returns
+        -------
+        Optional[Dict]
+            A dictionary with the timestamps ('time_us') and one numpy array for each streamed channel, as well as 'period_us', 'decimation', 'dropped' and 'missed'. None if no stream was received.
+        """
+        try:
+            r = self.stream_queue.get(timeout=self.timeout if timeout is None else timeout)
+        except queue.Empty:
+            logger.error('No sensor stream received.', extra=self._logger_dict)
+            return None
+        if r['dropped'] > 0 or r['missed'] > 0:
+            logger.warning(f'Sensor stream: {r["dropped"]} records dropped, {r["missed"]} samples missed.', extra=self._logger_dict)
+        return r
+
+    def get_flight_recorder(self) -> List[Dict]:
+        """
+        Reads the flight recorder of the controller, which holds a compact trace of the last open_container and close_container cycles.
+
+        Returns
+        -------
+        List[Dict]
+            One dictionary per cycle (oldest first) with the cycle type ('open' or 'close'), the thresholds that were used, the outcome, the reason code (bit mask of the signals for opening, seating reason for closing), the value (confidence in % for opening, current when the cap was seated in mA for closing), the phases with their start times, and the downsampled pressure and dc motor current as numpy arrays.
+        """
+        if CapperDecapper.EMERGENCY_STOP_REQUEST:
+            return []
+
+        self.arduino_controller.write('capper recorder\n')
+        data = self.read_queue.get(timeout=self.timeout)
+        r = self.read_queue.get(timeout=self.timeout)
+        if r != 'OK' or not isinstance(data, bytes):
+            logger.error(r, extra=self._logger_dict)
+            return []
+
+        cycles = []
+        for c in np.frombuffer(data, dtype=CapperDecapper.RECORDER_DTYPE):
+            n = int(c['sample_count'])
+            cycles.append({
+                'number': int(c['number']),
+                'type': CapperDecapper.RECORDER_CYCLE_TYPES.get(int(c['type']), str(c['type'])),
+                'start_time_ms': int(c['start_time_ms']),
+                'pressure_threshold': int(c['pressure_threshold']),
+                'current_threshold_ma': int(c['current_threshold_ma']),
+                'timeout_ms': int(c['timeout_ms']),
+                'parameter': int(c['parameter']),
+                'outcome': bool(c['outcome']),
+                'reason': int(c['reason']),
+                'value': int(c['value']),
+                'duration_ms': int(c['duration_ms']),
+                'phases': [(CapperDecapper.RECORDER_PHASES.get(int(p['phase']), str(p['phase'])), int(p['time_ms'])) for p in c['phases'][:int(c['phase_count'])]],
+                'time_ms': np.arange(n) * int(c['sample_interval_ms']),
+                'pressure': c['samples'][:n, 0] * 0.25,
+                'dc_current_ma': c['samples'][:n, 1] * 0.1
+            })
+        logger.info(f'Read {len(cycles)} cycles from the flight recorder', extra=self._logger_dict)
+        return cycles
+
+    def clear_flight_recorder(self) -> bool:
+        if CapperDecapper.EMERGENCY_STOP_REQUEST:
+            return False
+
+        self.arduino_controller.write('capper recorder_clear\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if r == 'OK':
+            logger.info(f'Cleared flight recorder', extra=self._logger_dict)
+            return True
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return False
+
     def turn_wrist_clockwise(self) -> bool:
         if CapperDecapper.EMERGENCY_STOP_REQUEST:
             return False
@@ -221,8 +354,70 @@ class CapperDecapper(Hardware):
 
         self.arduino_controller.write(f'capper clamp_close {current_threshold_in_ma}\n')
         r = self.read_queue.get(timeout=self.timeout)
-        if r == 'OK':
-            logger.info(f'Clamp closed.', extra=self._logger_dict)
+        if r[-1] == 'OK':
+            self.clamp_diameter = float(r[0].split(' ')[-1])
+            logger.info(f'Clamp closed, measured diameter: {self.clamp_diameter} mm.', extra=self._logger_dict)
+            return True
+        else:
+            logger.error(r[-1], extra=self._logger_dict)
+            return False
+
+    def get_container_profile(self, profile_id: int) -> Optional[Dict]:
+        """
+        Reads a container profile (the capping parameters of one container type) from the EEPROM of the controller.
+
+        Parameters
+        ----------
+        profile_id : int
+            The ID of the profile (0-7).
+
+        Returns
+        -------
+        Optional[Dict]
+            The values of the profile (see CONTAINER_PROFILE_FIELDS) and whether it was stored ('stored' is False if the controller uses the defaults for this ID), or None if an error occurred.
+        """
+        if CapperDecapper.EMERGENCY_STOP_REQUEST:
+            return None
+
+        self.arduino_controller.write(f'capper profile {profile_id}\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if isinstance(r, list) and r[-1] == 'OK':
+            profile = {'stored': r[0] == 'STORED'}
+            profile.update({k: float(v) for k, v in zip(CapperDecapper.CONTAINER_PROFILE_FIELDS, r[1].split(';'))})
+            return profile
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return None
+
+    def set_container_profile(self, profile_id: int, **values: float) -> bool:
+        """
+        Stores a container profile in the EEPROM of the controller. Values that are not specified are kept.
+
+        Parameters
+        ----------
+        profile_id : int
+            The ID of the profile (0-7).
+        **values : float
+            The new values, with the keys from CONTAINER_PROFILE_FIELDS.
+
+        Returns
+        -------
+        bool
+            True if the profile was stored successfully, False otherwise.
+        """
+        profile = self.get_container_profile(profile_id)
+        if profile is None:
+            return False
+        for k, v in values.items():
+            if k not in CapperDecapper.CONTAINER_PROFILE_FIELDS:
+                logger.error(f'Unknown container profile field: {k}', extra=self._logger_dict)
+                return False
+            profile[k] = v
+
+        self.arduino_controller.write(f'capper profile {profile_id};' + ';'.join(str(profile[k]) for k in CapperDecapper.CONTAINER_PROFILE_FIELDS) + '\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if isinstance(r, list) and r[-1] == 'OK':
+            logger.info(f'Stored container profile {profile_id}: {r[1]}', extra=self._logger_dict)
             return True
         else:
             logger.error(r, extra=self._logger_dict)
@@ -242,7 +437,7 @@ class CapperDecapper(Hardware):
         z_offset: int = 20
             Additional z_offset to be applied. Default is 0.
         opening_time: float = 2.0
-            Time in seconds during which the wrist will be turned to open the container. Default is 2.
+            Maximum time in seconds during which the wrist will be turned to open the container. The controller usually stops the wrist earlier, as soon as it detects that the cap is free. Default is 2.
         block: bool = TaskScheduler.default_blocking_behavior
             Whether to wait for the result of this call or return a reference to a queue.Queue object that will hold the result (when decorated with TaskScheduler.scheduled_task). Default is configured in TaskScheduler.default_blocking_behavior
         priority: int = TaskScheduler.default_priority
@@ -270,18 +465,18 @@ class CapperDecapper(Hardware):
         z_pos = start_zpos + CapperDecapper.BRACKET_WIDTH + z_offset
         robot_arm.arm.set_position(*[start_pos[i] if i != 2 else z_pos for i in range(0, len(start_pos))], speed=self.approach_speed, wait=True)  # Workaround for Bug in xArm Python SDK (1.11.6) using old x and y positions when providing only z as an argument
 
-        if not self.close_clamp(current_threshold_in_ma):
-            self.open_clamp()
-            robot_arm.arm.set_position(*[start_pos[i] if i != 2 else start_zpos for i in range(0, len(start_pos))], speed=self.approach_speed, wait=True)  # Workaround for Bug in xArm Python SDK (1.11.6) using old x and y positions when providing only z as an argument
-            return False
-        if not self.turn_wrist_counterclockwise():
-            self.open_clamp()
-            time.sleep(5)
-            robot_arm.arm.set_position(*[start_pos[i] if i != 2 else start_zpos for i in range(0, len(start_pos))], speed=self.approach_speed, wait=True)  # Workaround for Bug in xArm Python SDK (1.11.6) using old x and y positions when providing only z as an argument
-            return False
-        time.sleep(opening_time)
-
-        if not self.wrist_stop():
+        # The controller closes the clamp, already starts the wrist when the clamp touches the container, and stops it as soon as it detects that the cap is free (pressure release, current drop and rotation time)
+        self.arduino_controller.write(f'capper grip_unscrew {current_threshold_in_ma};{int(opening_time * 1000)}\n')
+        r = self.read_queue.get(timeout=self.timeout + opening_time)
+        if isinstance(r, list) and r[-1] == 'OK':
+            self.clamp_diameter = float(r[0].split(' ')[-1])
+            logger.info(f'Cap free: {r[1]}', extra=self._logger_dict)
+        elif isinstance(r, list) and r[-1].startswith('ERROR 3'):
+            self.clamp_diameter = float(r[0].split(' ')[-1])
+            logger.warning(f'Cap release not detected within {opening_time} seconds.', extra=self._logger_dict)
+        else:
+            logger.error(r, extra=self._logger_dict)
+            self.wrist_stop()
             self.open_clamp()
             time.sleep(5)
             robot_arm.arm.set_position(*[start_pos[i] if i != 2 else start_zpos for i in range(0, len(start_pos))], speed=self.approach_speed, wait=True)  # Workaround for Bug in xArm Python SDK (1.11.6) using old x and y positions when providing only z as an argument
@@ -297,7 +492,7 @@ class CapperDecapper(Hardware):
         return True
 
     @TaskScheduler.scheduled_task
-    def close_container(self, robot_arm: UFactory.XArm6, current_threshold_in_ma: float = 300.0, z_offset: int = 6, block: bool = TaskScheduler.default_blocking_behavior, priority: int = TaskScheduler.default_priority, is_sequential_task: bool = True, task_group_synchronization_object: TaskGroupSynchronizationObject = None) -> bool:
+    def close_container(self, robot_arm: UFactory.XArm6, current_threshold_in_ma: float = 300.0, z_offset: int = 6, timeout: float = 5.0, block: bool = TaskScheduler.default_blocking_behavior, priority: int = TaskScheduler.default_priority, is_sequential_task: bool = True, task_group_synchronization_object: TaskGroupSynchronizationObject = None) -> bool:
         """
         Method for closing the lid of a container.
 
@@ -306,9 +501,11 @@ class CapperDecapper(Hardware):
         robot_arm: UFactory.XArm6
             The robot arm that is holding the container for uncapping
         current_threshold_in_ma: float = 300
-            The current threshold in milliamps that determines the torque of the wrist when closing the lid. Default is 300.
+            The current level in milliamps at which the wrist is stopped at the latest when closing the lid. The controller usually stops the wrist earlier, as soon as it detects the current rise when the cap is seated. Default is 300.
         z_offset: int = 6
             Additional z_offset to be applied to ensure there is some pressure on the lid. Default is 6.
+        timeout: float = 5.0
+            Maximum time in seconds during which the wrist is turned (including the time the robot arm needs to move down). Default is 5.
         block: bool = TaskScheduler.default_blocking_behavior
             Whether to wait for the result of this call or return a reference to a queue.Queue object that will hold the result (when decorated with TaskScheduler.scheduled_task). Default is configured in TaskScheduler.default_blocking_behavior
         is_sequential_task: bool = True
@@ -330,34 +527,23 @@ class CapperDecapper(Hardware):
         start_pos = robot_arm.arm.position
         start_zpos = start_pos[2]
         z_pos = start_zpos + CapperDecapper.BRACKET_WIDTH + z_offset
-        if not self.turn_wrist_clockwise():
-            return False
+        # The controller turns the wrist, stops it as soon as it detects that the cap is seated and opens the clamp right away, while the robot arm presses the lid down
+        self.arduino_controller.write(f'capper tighten_release {current_threshold_in_ma};{int(timeout * 1000)}\n')
         robot_arm.arm.set_position(*[start_pos[i] if i != 2 else z_pos for i in range(0, len(start_pos))], speed=self.approach_speed, wait=True)  # Workaround for Bug in xArm Python SDK (1.11.6) using old x and y positions when providing only z as an argument
 
-        time.sleep(0.5)
-        current_dc_motor_current = cast(float, self.read_current_sensor_dc_motor())
-        start_time = time.time()
-        timeout = 2.5
-
-        while abs(current_dc_motor_current) < abs(current_threshold_in_ma) and time.time() - start_time < timeout:
-            current_dc_motor_current = cast(float, self.read_current_sensor_dc_motor())
-            if current_dc_motor_current is None:
-                self.wrist_stop()
-                self.open_clamp()
-                time.sleep(5)
-                robot_arm.arm.set_position(*[start_pos[i] if i != 2 else start_zpos for i in range(0, len(start_pos))], speed=self.approach_speed, wait=True)  # Workaround for Bug in xArm Python SDK (1.11.6) using old x and y positions when providing only z as an argument
-                return False
-
-        if not self.wrist_stop():
+        r = self.read_queue.get(timeout=self.timeout)
+        if isinstance(r, list) and r[-1] == 'OK':
+            logger.info(f'Cap seated: {r[0]}', extra=self._logger_dict)
+        elif isinstance(r, str) and r.startswith('ERROR 3'):
+            logger.warning(f'Cap seating not detected within {timeout} seconds.', extra=self._logger_dict)
+        else:
+            logger.error(r, extra=self._logger_dict)
+            self.wrist_stop()
             self.open_clamp()
             time.sleep(5)
             robot_arm.arm.set_position(*[start_pos[i] if i != 2 else start_zpos for i in range(0, len(start_pos))], speed=self.approach_speed, wait=True)  # Workaround for Bug in xArm Python SDK (1.11.6) using old x and y positions when providing only z as an argument
             return False
 
-        if not self.open_clamp():
-            robot_arm.arm.set_position(*[start_pos[i] if i != 2 else start_zpos for i in range(0, len(start_pos))], speed=self.approach_speed, wait=True)  # Workaround for Bug in xArm Python SDK (1.11.6) using old x and y positions when providing only z as an argument
-            return False
-
         err_warn_code = robot_arm.arm.get_err_warn_code()
         if err_warn_code != (0, [0, 0]):
             if err_warn_code == (0, [31, 0]):  # (0, [31, 0]) means abnormal current, probably due to collision:
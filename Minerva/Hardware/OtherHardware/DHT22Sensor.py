@@ -11,9 +11,10 @@ from __future__ import annotations
 
 import logging
 import os.path
+import queue
 import threading
 import time
-from typing import Optional
+from typing import Optional, Dict
 
 from Minerva.API.HelperClassDefinitions import Hardware, HotplateHardware, HardwareTypeDefinitions, PathNames
 from Minerva.Hardware.ControllerHardware import ArduinoController
@@ -84,6 +85,7 @@ class DHT22Sensor(Hardware):
         self._shutdown = False
         self.interval = interval
         self._logger_dict = {'instance_name': str(self)}
+        self.last_reading: Optional[Dict[str, float]] = None
 
         if self.interval is not None and self.interval > 0:
             self._polling_thread = threading.Thread(target=self._measure_continuous, daemon=True)
@@ -91,7 +93,7 @@ class DHT22Sensor(Hardware):
 
     def measure(self) -> bool:
         """
-        Method for reading the sensor values once.
+        Method for reading the sensor values once. The controller reads the sensor in the background every 2.1 s and answers with the latest reading, its age and the minimum, maximum and mean over the last 30 readings, which are stored in last_reading.
 
         Returns
         -------
@@ -101,20 +103,52 @@ class DHT22Sensor(Hardware):
         if DHT22Sensor.EMERGENCY_STOP_REQUEST:
             return False
 
-        for _ in range(0, self.retries):
+        for i in range(0, self.retries):
             self.arduino_controller.write(f'DHT22SENSOR{self.sensor_number} measure\n')
             r = self.read_queue.get(timeout=self.timeout)
             if r[-1] == 'OK':
-                logger.info(f'Temperature: {r[0]} C, Humidity: {r[1]} %', extra=self._logger_dict)
+                t_min, t_max, t_mean = (float(v) for v in r[3].split(';'))
+                h_min, h_max, h_mean = (float(v) for v in r[4].split(';'))
+                self.last_reading = {'temperature': float(r[0]), 'humidity': float(r[1]), 'age_ms': float(r[2]), 'temperature_min': t_min, 'temperature_max': t_max, 'temperature_mean': t_mean, 'humidity_min': h_min, 'humidity_max': h_max, 'humidity_mean': h_mean}
+                logger.info(f'Temperature: {r[0]} C, Humidity: {r[1]} % (age: {r[2]} ms, mean: {t_mean} C, {h_mean} %)', extra=self._logger_dict)
                 return True
+            if i < self.retries - 1:
+                time.sleep(2.1)  # no valid reading yet, wait for the next background reading
 
         logger.error(r, extra=self._logger_dict)
         return False
 
     def _measure_continuous(self) -> None:
         """
-        Method for continuously reading the sensor values in a certain interval.
+        Method for continuously reading the sensor values in a certain interval. The controller pushes the readings on its own (telemetry subscription), so no requests need to be sent. Falls back to polling with measure() if the subscription fails.
         """
+        # Humidity is subscribed first, so with the same period it is always pushed before (or together with) the temperature
+        humidity_channel = f'humidity{self.sensor_number}'
+        if self.arduino_controller.subscribe_telemetry(humidity_channel, self.interval * 1000) is None:
+            telemetry_queue = None
+        else:
+            telemetry_queue = self.arduino_controller.subscribe_telemetry(f'temperature{self.sensor_number}', self.interval * 1000)
+
         while not self._shutdown and not DHT22Sensor.EMERGENCY_STOP_REQUEST:
-            self.measure()
-            time.sleep(self.interval)
+            if telemetry_queue is None:
+                self.measure()
+                time.sleep(self.interval)
+                continue
+            try:
+                _, temperature = telemetry_queue.get(timeout=self.interval + self.timeout)
+            except queue.Empty:
+                logger.warning('No telemetry from the controller, reading the sensor directly.', extra=self._logger_dict)
+                self.measure()
+                continue
+            humidity = self.arduino_controller.get_telemetry(humidity_channel)
+            self.last_reading = {k: v for k, v in (self.last_reading or {}).items() if k != 'age_ms'}  # the statistics of the last measure() call are kept
+            self.last_reading.update({'temperature': temperature, 'humidity': humidity[1] if humidity is not None else float('nan')})
+            logger.info(f'Temperature: {temperature} C, Humidity: {self.last_reading["humidity"]} %', extra=self._logger_dict)
+
+    def stop_continuous_measurement(self) -> None:
+        """
+        Stops the periodic reading of the sensor values and the telemetry subscription on the controller.
+        """
+        self._shutdown = True
+        self.arduino_controller.unsubscribe_telemetry(f'temperature{self.sensor_number}')
+        self.arduino_controller.unsubscribe_telemetry(f'humidity{self.sensor_number}')
@@ -11,6 +11,7 @@ from __future__ import annotations
 
 import logging
 import os.path
+from typing import Tuple, Union
 
 from Minerva.Hardware.ControllerHardware import ArduinoController
 from Minerva.API.HelperClassDefinitions import Hardware, HardwareTypeDefinitions, PathNames
@@ -73,10 +74,17 @@ class Electromagnet(Hardware):
         self.read_queue = self.arduino_controller.get_read_queue(f'MAGNET{self.magnet_number}')
         self._logger_dict = {'instance_name': str(self)}
 
-    def turn_on(self) -> bool:
+    def turn_on(self, duty: int = 255, duration: int = 0) -> bool:
         """
         Turns the electromagnet on.
 
+        Parameters
+        ----------
+        duty : int, default = 255
+            PWM duty cycle (between 1 and 255) that sets the strength of the magnet.
+        duration : int, default = 0
+            Time in ms after which the magnet is turned off again in the background (0: stays on until it is turned off).
+
         Returns
         -------
         bool
@@ -85,7 +93,7 @@ class Electromagnet(Hardware):
         if Electromagnet.EMERGENCY_STOP_REQUEST:
             return False
 
-        self.arduino_controller.write(f'MAGNET{self.magnet_number} ON\n')
+        self.arduino_controller.write(f'MAGNET{self.magnet_number} ON {int(duty)};{int(duration)}\n')
         r = self.read_queue.get(timeout=self.timeout)
         if r == 'OK':
             logger.info(f'Magnet {self.magnet_number} turned on.', extra=self._logger_dict)
@@ -117,7 +125,8 @@ class Electromagnet(Hardware):
 
     def release(self) -> bool:
         """
-        Releases the piece currently held by the electromagnet briefly reversing the polarity and then turning the magnet off.
+        Releases the piece currently held by the electromagnet with a reverse pulse followed by pulses of alternating polarity and decaying
+        strength. The sequence runs in the background on the controller and turns the magnet off when it is done (after about 400 ms).
 
         Returns
         -------
@@ -157,6 +166,57 @@ class Electromagnet(Hardware):
             logger.error(r, extra=self._logger_dict)
             return False
 
+    def stir(self, frequency: float, duty: int = 255, duration: int = 0) -> bool:
+        """
+        Alternates the polarity of the electromagnet in the background to move the piece held by it.
+
+        Parameters
+        ----------
+        frequency : float
+            Number of polarity changes per second in Hz.
+        duty : int, default = 255
+            PWM duty cycle (between 1 and 255) that sets the strength of the magnet.
+        duration : int, default = 0
+            Time in ms after which the magnet is turned off in the background (0: until it is turned off).
+
+        Returns
+        -------
+        bool
+            True if successful, False otherwise
+        """
+        if Electromagnet.EMERGENCY_STOP_REQUEST:
+            return False
+
+        self.arduino_controller.write(f'MAGNET{self.magnet_number} STIR {float(frequency)};{int(duty)};{int(duration)}\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if r == 'OK':
+            logger.info(f'Magnet {self.magnet_number} stirring at {frequency} Hz.', extra=self._logger_dict)
+            return True
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return False
+
+    def get_status(self) -> Union[Tuple[int, int], None]:
+        """
+        Queries the waveform that is currently played by the electromagnet.
+
+        Returns
+        -------
+        Union[Tuple[int, int], None]
+            The waveform (0: off, 1: constant, 2: alternating, 3: release) and its remaining time in ms (0: unlimited), or None if unsuccessful
+        """
+        if Electromagnet.EMERGENCY_STOP_REQUEST:
+            return None
+
+        self.arduino_controller.write(f'MAGNET{self.magnet_number} STATUS\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if isinstance(r, list) and len(r) == 2 and r[-1] == 'OK':
+            waveform, remaining = r[0].split(';')
+            return int(waveform), int(remaining)
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return None
+
     def emergency_stop(self) -> bool:
         """
         Sends an emergency stop request to the Arduino, causing it to ignore all further commands until cleared.
@@ -218,4 +278,8 @@ REL
 Releases the piece currently held by the electromagnet briefly reversing the polarity and then turning the magnet off.
 REV
 Reverses the polarity of the electromagnet
+STIR <frequency>[;duty;duration]
+Alternates the polarity of the electromagnet with the given frequency in the background
+STATUS
+Returns the current waveform and its remaining time
 """
@@ -202,6 +202,65 @@ class HotplateClampDCMotor(Hardware):
             return False
 
 
+    def lower_and_close(self, angle: Optional[int] = None) -> bool:
+        """
+        Method for moving the clamp down and closing it in one go. The slow servo approach already starts during the last part of the descent, which is faster than calling move_down and close_clamp separately.
+
+        Parameters:
+        -----------
+        angle : Optional[int] = None
+            Servo angle in degrees. If set to None, close the clamp all the way.
+
+        Returns
+        ------
+        bool
+            True if successful, False otherwise
+        """
+        if HotplateClampDCMotor.EMERGENCY_STOP_REQUEST:
+            return False
+
+        if angle is None:
+            self.arduino_controller.write(f'Clamp{self.clamp_number} lower_and_close\n')
+        else:
+            self.arduino_controller.write(f'Clamp{self.clamp_number} lower_and_close {angle}\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if r == 'OK':
+            logger.info(f'Clamp{self.clamp_number} moved down and closed.', extra=self._logger_dict)
+            return True
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return False
+
+    def open_and_raise(self, angle: Optional[int] = None) -> bool:
+        """
+        Method for opening the clamp and moving it up in one go. The stage starts moving up as soon as the container is released, which is faster than calling open_clamp and move_up separately.
+
+        Parameters:
+        -----------
+        angle : Optional[int] = None
+            Servo angle in degrees. If set to None, open the clamp all the way.
+
+        Returns
+        ------
+        bool
+            True if successful, False otherwise
+        """
+        if HotplateClampDCMotor.EMERGENCY_STOP_REQUEST:
+            return False
+
+        if angle is None:
+            self.arduino_controller.write(f'Clamp{self.clamp_number} open_and_raise\n')
+        else:
+            self.arduino_controller.write(f'Clamp{self.clamp_number} open_and_raise {angle}\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if r == 'OK':
+            logger.info(f'Clamp{self.clamp_number} opened and moved up.', extra=self._logger_dict)
+            return True
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return False
+
+
 class HotplateClampStepperMotor(Hardware):
     """
     Class for communication with an Arduino controlling the hotplate clamp/stage, where the stage is connected to a Stepper Motor.
@@ -210,14 +269,14 @@ class HotplateClampStepperMotor(Hardware):
         Field specifying the hotplate hardware where this clamp is located.
     arduino_controller : ArduinoController
         The Arduino controller hardware.
-    timeout : float, default=5
-        The timeout when waiting for a response in seconds. Default is 5.
+    timeout : float, default=120
+        The timeout when waiting for a response in seconds. Default is 120.
     clamp_number : int, default=1
         The number of the hotplate clamp. Default is 1.
     """
     EMERGENCY_STOP_REQUEST = False
 
-    def __init__(self, parent_hardware: HotplateHardware, arduino_controller: ArduinoController.ArduinoController, timeout: float = 5, clamp_number: int = 1):
+    def __init__(self, parent_hardware: HotplateHardware, arduino_controller: ArduinoController.ArduinoController, timeout: float = 120, clamp_number: int = 1):
         """
         Constructor for the HotplateClamp Class for communication with the Arduino controlling the hotplate clamp/stage, where the stage is connected to a Stepper Motor.
 
@@ -227,8 +286,8 @@ class HotplateClampStepperMotor(Hardware):
             Field specifying the hotplate hardware where this clamp is located.
         arduino_controller : ArduinoController.ArduinoController
             The Arduino controller hardware.
-        timeout : float, default=5
-            The timeout when waiting for a response in seconds. Default is 5.
+        timeout : float, default=120
+            The timeout when waiting for a response in seconds. Default is 120.
         clamp_number : int, default=1
             The number of the hotplate clamp. Default is 1.
         """
@@ -238,11 +297,12 @@ class HotplateClampStepperMotor(Hardware):
         self.clamp_number = clamp_number
         self._parent_hardware = parent_hardware
         self.read_queue = self.arduino_controller.get_read_queue(f'CLAMP{self.clamp_number}')
+        self.current_position: Optional[int] = None
         self._logger_dict = {'instance_name': str(self)}
 
     def home_position(self) -> bool:
         """
-        Method for homing the stepper motor of the hotplate stage (will return it to the bottom-most position).
+        Method for homing the stepper motor of the hotplate stage (will return it to the bottom-most position). The stage approaches the limit switch quickly, backs off, and then re-approaches it slowly for a repeatable home position.
 
         Returns
         ------
@@ -254,12 +314,12 @@ class HotplateClampStepperMotor(Hardware):
 
         self.arduino_controller.write(f'Clamp{self.clamp_number} homePosition\n')
         r = self.read_queue.get(timeout=self.timeout)
-        if r[-1] == 'OK':
+        if r == 'OK':
             logger.info(f'Clamp{self.clamp_number} returned to home position. Current Position set to 0.', extra=self._logger_dict)
             self.current_position = 0
             return True
         else:
-            logger.error(r[-1], extra=self._logger_dict)
+            logger.error(r, extra=self._logger_dict)
             return False
 
     def get_position(self) -> int:
@@ -276,7 +336,7 @@ class HotplateClampStepperMotor(Hardware):
 
         self.arduino_controller.write(f'Clamp{self.clamp_number} pos\n')
         r = self.read_queue.get(timeout=self.timeout)
-        pos = int(r.split(' '))
+        pos = int(r.split(' ')[-1])
         if pos == self.current_position:
             logger.info(f'Clamp{self.clamp_number} is currently at {pos} mm above the home position.', extra=self._logger_dict)
             return pos
@@ -302,10 +362,11 @@ class HotplateClampStepperMotor(Hardware):
         if HotplateClampStepperMotor.EMERGENCY_STOP_REQUEST:
             return False
 
-        self.arduino_controller.write(f'Clamp{self.clamp_number} pos {self.current_position}\n')
+        self.arduino_controller.write(f'Clamp{self.clamp_number} pos {position}\n')
         r = self.read_queue.get(timeout=self.timeout)
         if r == 'OK':
             logger.info(f'Clamp{self.clamp_number} position set to {position} mm above the home position.', extra=self._logger_dict)
+            self.current_position = position
             return True
         else:
             logger.error(r, extra=self._logger_dict)
@@ -313,7 +374,7 @@ class HotplateClampStepperMotor(Hardware):
 
     def goto_position(self, position: int) -> bool:
         """
-        Method for moving the clamp to the specified position in millimeters above the home position.
+        Method for moving the clamp to the specified absolute position in millimeters above the home position (using an acceleration profile). The controller refuses the move until the clamp was homed with home_position or its position was set with update_position.
 
         Parameters:
         -----------
@@ -401,3 +462,71 @@ class HotplateClampStepperMotor(Hardware):
         else:
             logger.error(r, extra=self._logger_dict)
             return False
+
+    def lower_and_close(self, angle: Optional[int] = None) -> bool:
+        """
+        Method for moving the clamp down and closing it in one go. The slow servo approach already starts during the last part of the descent, which is faster than calling move_down and close_clamp separately.
+
+        Parameters:
+        -----------
+        angle : Optional[int] = None
+            Servo angle in degrees. If set to None, close the clamp all the way.
+
+        Returns
+        ------
+        bool
+            True if successful, False otherwise
+        """
+        if HotplateClampStepperMotor.EMERGENCY_STOP_REQUEST:
+            return False
+
+        if angle is None:
+            self.arduino_controller.write(f'Clamp{self.clamp_number} lower_and_close\n')
+        else:
+            self.arduino_controller.write(f'Clamp{self.clamp_number} lower_and_close {angle}\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if r == 'OK':
+            logger.info(f'Clamp{self.clamp_number} moved down and closed.', extra=self._logger_dict)
+            self.current_position = 0
+            return True
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return False
+
+    def open_and_raise(self, position: Optional[int] = None) -> bool:
+        """
+        Method for opening the clamp and moving it up in one go. The stage starts moving up as soon as the container is released, which is faster than calling open_clamp and move_up separately.
+
+        Parameters:
+        -----------
+        position : Optional[int] = None
+            Height of the clamp in millimeters above the home position. If set to None, the clamp returns to the height it had before the last call to lower_and_close.
+
+        Returns
+        ------
+        bool
+            True if successful, False otherwise
+        """
+        if HotplateClampStepperMotor.EMERGENCY_STOP_REQUEST:
+            return False
+
+        if position is None:
+            self.arduino_controller.write(f'Clamp{self.clamp_number} open_and_raise\n')
+        else:
+            self.arduino_controller.write(f'Clamp{self.clamp_number} open_and_raise {position}\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if r == 'OK':
+            if position is None:
+                # The firmware returned to the height it had before the last call to lower_and_close, so ask where that was
+                self.arduino_controller.write(f'Clamp{self.clamp_number} pos\n')
+                r = self.read_queue.get(timeout=self.timeout)
+                if not r.startswith('POS'):
+                    logger.error(r, extra=self._logger_dict)
+                    return False
+                position = int(r.split(' ')[-1])
+            logger.info(f'Clamp{self.clamp_number} opened and moved up to {position} mm above the home position.', extra=self._logger_dict)
+            self.current_position = position
+            return True
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return False
@@ -11,6 +11,7 @@ from __future__ import annotations
 
 import logging
 import os.path
+from typing import Optional, Tuple
 
 from Minerva.API.HelperClassDefinitions import Hardware, HotplateHardware, HardwareTypeDefinitions, PathNames
 from Minerva.Hardware.ControllerHardware import ArduinoController
@@ -78,10 +79,15 @@ class HotplateFan(Hardware):
         self.read_queue = self.arduino_controller.get_read_queue(f'FAN{self.fan_number}')
         self._logger_dict = {'instance_name': str(self)}
 
-    def turn_on(self) -> bool:
+    def turn_on(self, duty: int = 255) -> bool:
         """
         Method for turning the fan on.
 
+        Parameters
+        ----------
+        duty : int, default = 255
+            PWM duty cycle (between 1 and 255) that sets the fan speed. Fans on pins without hardware PWM always run with full speed.
+
         Returns
         ------
         bool
@@ -90,7 +96,7 @@ class HotplateFan(Hardware):
         if HotplateFan.EMERGENCY_STOP_REQUEST:
             return False
 
-        self.arduino_controller.write(f'Fan{self.fan_number} on\n')
+        self.arduino_controller.write(f'Fan{self.fan_number} on {int(duty)}\n')
         r = self.read_queue.get(timeout=self.timeout)
         if r == 'OK':
             logger.info(f'Fan{self.fan_number} turned on.', extra=self._logger_dict)
@@ -119,3 +125,58 @@ class HotplateFan(Hardware):
         else:
             logger.error(r, extra=self._logger_dict)
             return False
+
+    def cool_down(self, duty: int = 255, duration: int = 0, target_temperature: Optional[float] = None) -> bool:
+        """
+        Method for starting a cool-down profile. The fan runs with the given speed until the temperature drops below the target temperature or
+        until the duration has passed, and is then turned off by the controller without any further commands.
+
+        Parameters
+        ----------
+        duty : int, default = 255
+            PWM duty cycle (between 1 and 255) that sets the fan speed.
+        duration : int, default = 0
+            Maximum time in ms the fan runs (0: no time limit, requires a target temperature).
+        target_temperature : Optional[float], default = None
+            The fan is turned off once the temperature in centigrades drops below this value. If None, the fan runs for the given duration.
+
+        Returns
+        ------
+        bool
+            True if successful, False otherwise
+        """
+        if HotplateFan.EMERGENCY_STOP_REQUEST:
+            return False
+
+        if target_temperature is None:
+            self.arduino_controller.write(f'Fan{self.fan_number} cool {int(duty)};{int(duration)}\n')
+        else:
+            self.arduino_controller.write(f'Fan{self.fan_number} cool {int(duty)};{int(duration)};{float(target_temperature)}\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if r == 'OK':
+            logger.info(f'Fan{self.fan_number} started cool-down.', extra=self._logger_dict)
+            return True
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return False
+
+    def get_status(self) -> Optional[Tuple[int, int, int]]:
+        """
+        Method for querying the state of the fan.
+
+        Returns
+        ------
+        Optional[Tuple[int, int, int]]
+            The state (0: off, 1: on, 2: cool-down), the PWM duty, and the maximum remaining time of the cool-down in ms, or None if unsuccessful
+        """
+        if HotplateFan.EMERGENCY_STOP_REQUEST:
+            return None
+
+        self.arduino_controller.write(f'Fan{self.fan_number} status\n')
+        r = self.read_queue.get(timeout=self.timeout)
+        if isinstance(r, list) and len(r) == 2 and r[-1] == 'OK':
+            state, duty, remaining = r[0].split(';')
+            return int(state), int(duty), int(remaining)
+        else:
+            logger.error(r, extra=self._logger_dict)
+            return None